@@ -0,0 +1,74 @@
+find_package(Python3 COMPONENTS Interpreter)
+
+if(NOT Python3_FOUND)
+  message(STATUS "Can not find python3, benchmark targets are disabled")
+  return()
+endif()
+
+set(KCC_BENCH_DIR ${KCC_BINARY_DIR}/bench)
+file(MAKE_DIRECTORY ${KCC_BENCH_DIR})
+
+set(KCC_BENCH_RUNS
+    5
+    CACHE STRING "Number of runs of each benchmark")
+set(KCC_BENCH_THRESHOLD
+    0.05
+    CACHE STRING "Allowed relative regression against the baseline")
+
+# 编译速度, e.g. cmake --build build --target kcc-bench
+add_custom_target(
+  kcc-bench
+  COMMAND
+    ${Python3_EXECUTABLE} ${KCC_SOURCE_DIR}/script/kcc-bench.py --kcc
+    $<TARGET_FILE:${EXECUTABLE}> --runs ${KCC_BENCH_RUNS} -o
+    ${KCC_BENCH_DIR}/kcc-bench.json
+  DEPENDS ${EXECUTABLE}
+  WORKING_DIRECTORY ${KCC_BENCH_DIR}
+  USES_TERMINAL)
+
+# 与上一次 kcc-bench 保存的 baseline.json 比较
+add_custom_target(
+  kcc-bench-compare
+  COMMAND
+    ${Python3_EXECUTABLE} ${KCC_SOURCE_DIR}/script/kcc-bench.py --kcc
+    $<TARGET_FILE:${EXECUTABLE}> --runs ${KCC_BENCH_RUNS} -o
+    ${KCC_BENCH_DIR}/kcc-bench.json --baseline
+    ${KCC_BENCH_DIR}/kcc-bench-baseline.json --threshold
+    ${KCC_BENCH_THRESHOLD}
+  DEPENDS ${EXECUTABLE}
+  WORKING_DIRECTORY ${KCC_BENCH_DIR}
+  USES_TERMINAL)
+
+# 生成代码的运行速度, 与 clang / gcc 比较
+add_custom_target(
+  kcc-bench-runtime
+  COMMAND
+    ${Python3_EXECUTABLE} ${KCC_SOURCE_DIR}/script/kcc-bench-runtime.py --kcc
+    $<TARGET_FILE:${EXECUTABLE}> --runs ${KCC_BENCH_RUNS} -o
+    ${KCC_BENCH_DIR}/kcc-bench-runtime.json
+  DEPENDS ${EXECUTABLE}
+  WORKING_DIRECTORY ${KCC_BENCH_DIR}
+  USES_TERMINAL)
+
+add_custom_target(
+  kcc-bench-runtime-compare
+  COMMAND
+    ${Python3_EXECUTABLE} ${KCC_SOURCE_DIR}/script/kcc-bench-runtime.py --kcc
+    $<TARGET_FILE:${EXECUTABLE}> --runs ${KCC_BENCH_RUNS} -o
+    ${KCC_BENCH_DIR}/kcc-bench-runtime.json --baseline
+    ${KCC_BENCH_DIR}/kcc-bench-runtime-baseline.json --threshold
+    ${KCC_BENCH_THRESHOLD}
+  DEPENDS ${EXECUTABLE}
+  WORKING_DIRECTORY ${KCC_BENCH_DIR}
+  USES_TERMINAL)
+
+# -fopenmp 生成代码在 1..N 个线程下的扩展性
+add_custom_target(
+  kcc-bench-omp
+  COMMAND
+    ${Python3_EXECUTABLE} ${KCC_SOURCE_DIR}/script/kcc-bench-omp.py --kcc
+    $<TARGET_FILE:${EXECUTABLE}> --runs ${KCC_BENCH_RUNS} -o
+    ${KCC_BENCH_DIR}/kcc-bench-omp.json
+  DEPENDS ${EXECUTABLE}
+  WORKING_DIRECTORY ${KCC_BENCH_DIR}
+  USES_TERMINAL)
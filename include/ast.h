@@ -18,6 +18,7 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/GlobalValue.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/Intrinsics.h>
 
 #include "location.h"
 #include "token.h"
@@ -27,6 +28,7 @@ namespace kcc {
 
 class ObjectExpr;
 class CompoundStmt;
+class LabelStmt;
 class Declaration;
 class Visitor;
 
@@ -37,6 +39,62 @@ inline std::unordered_map<std::string,
 
 inline std::unordered_map<std::string, llvm::GlobalVariable *> GlobalVarMap;
 
+// GCC 的 __atomic / __sync 内建函数是类型泛型的, 参数和返回值的类型
+// 由第一个参数(指向原子对象的指针)所指向的类型 T 决定
+// 参数: p 为 T *, P 为其他 T *, v 为 T, b 为 _Bool, i 为内存序
+// 返回值: v 为 T, b 为 _Bool, 0 为 void
+inline const std::unordered_map<std::string, std::pair<std::string, char>>
+    AtomicBuiltins{{"__atomic_load_n", {"pi", 'v'}},
+                   {"__atomic_load", {"pPi", '0'}},
+                   {"__atomic_store_n", {"pvi", '0'}},
+                   {"__atomic_store", {"pPi", '0'}},
+                   {"__atomic_exchange_n", {"pvi", 'v'}},
+                   {"__atomic_exchange", {"pPPi", '0'}},
+                   {"__atomic_compare_exchange_n", {"pPvbii", 'b'}},
+                   {"__atomic_compare_exchange", {"pPPbii", 'b'}},
+                   {"__atomic_fetch_add", {"pvi", 'v'}},
+                   {"__atomic_fetch_sub", {"pvi", 'v'}},
+                   {"__atomic_fetch_and", {"pvi", 'v'}},
+                   {"__atomic_fetch_or", {"pvi", 'v'}},
+                   {"__atomic_fetch_xor", {"pvi", 'v'}},
+                   {"__atomic_fetch_nand", {"pvi", 'v'}},
+                   {"__atomic_add_fetch", {"pvi", 'v'}},
+                   {"__atomic_sub_fetch", {"pvi", 'v'}},
+                   {"__atomic_and_fetch", {"pvi", 'v'}},
+                   {"__atomic_or_fetch", {"pvi", 'v'}},
+                   {"__atomic_xor_fetch", {"pvi", 'v'}},
+                   {"__atomic_nand_fetch", {"pvi", 'v'}},
+                   {"__sync_fetch_and_add", {"pv", 'v'}},
+                   {"__sync_fetch_and_sub", {"pv", 'v'}},
+                   {"__sync_fetch_and_and", {"pv", 'v'}},
+                   {"__sync_fetch_and_or", {"pv", 'v'}},
+                   {"__sync_fetch_and_xor", {"pv", 'v'}},
+                   {"__sync_fetch_and_nand", {"pv", 'v'}},
+                   {"__sync_add_and_fetch", {"pv", 'v'}},
+                   {"__sync_sub_and_fetch", {"pv", 'v'}},
+                   {"__sync_and_and_fetch", {"pv", 'v'}},
+                   {"__sync_or_and_fetch", {"pv", 'v'}},
+                   {"__sync_xor_and_fetch", {"pv", 'v'}},
+                   {"__sync_nand_and_fetch", {"pv", 'v'}},
+                   {"__sync_bool_compare_and_swap", {"pvv", 'b'}},
+                   {"__sync_val_compare_and_swap", {"pvv", 'v'}},
+                   {"__sync_lock_test_and_set", {"pv", 'v'}},
+                   {"__sync_lock_release", {"p", '0'}}};
+
+// 类型泛型的溢出检查内建函数, 结果按无限精度计算后存入第三个参数
+// 分别对应有符号和无符号的 LLVM intrinsic
+inline const std::unordered_map<
+    std::string, std::pair<llvm::Intrinsic::ID, llvm::Intrinsic::ID>>
+    OverflowBuiltins{{"__builtin_add_overflow",
+                      {llvm::Intrinsic::sadd_with_overflow,
+                       llvm::Intrinsic::uadd_with_overflow}},
+                     {"__builtin_sub_overflow",
+                      {llvm::Intrinsic::ssub_with_overflow,
+                       llvm::Intrinsic::usub_with_overflow}},
+                     {"__builtin_mul_overflow",
+                      {llvm::Intrinsic::smul_with_overflow,
+                       llvm::Intrinsic::umul_with_overflow}}};
+
 enum class AstNodeType {
   kUnaryOpExpr,
   kTypeCastExpr,
@@ -49,6 +107,7 @@ enum class AstNodeType {
   kEnumeratorExpr,
   kObjectExpr,
   kStmtExpr,
+  kLabelAddrExpr,
 
   kLabelStmt,
   kCaseStmt,
@@ -64,6 +123,8 @@ enum class AstNodeType {
   kContinueStmt,
   kBreakStmt,
   kReturnStmt,
+  kAsmStmt,
+  kOmpStmt,
 
   kTranslationUnit,
   kDeclaration,
@@ -202,6 +263,8 @@ class BinaryOpExpr : public Expr {
   void RelationalOpCheck();
   void MemberRefOpCheck();
   void CommaOpCheck();
+  void VectorOpCheck();
+  void VectorIndexOpCheck();
 
   Tag op_;
   Expr *lhs_;
@@ -249,6 +312,11 @@ class FuncCallExpr : public Expr {
  private:
   explicit FuncCallExpr(Expr *callee, std::vector<Expr *> args = {});
 
+  void AtomicBuiltinCheck(const std::string &name);
+  void OverflowBuiltinCheck(const std::string &name);
+  void ShuffleVectorBuiltinCheck();
+  void ShuffleBuiltinCheck();
+
   Expr *callee_;
   std::vector<Expr *> args_;
 
@@ -330,6 +398,12 @@ class IdentifierExpr : public Expr {
   bool IsTypeName() const;
   bool IsObject() const;
 
+  // GNU 扩展, 汇编标签, e.g. int foo(void) asm("bar");
+  // 用于指定生成的符号名
+  void SetAsmLabel(const std::string &asm_label);
+  const std::string &GetAsmLabel() const;
+  std::string GetLinkName() const;
+
   ObjectExpr *ToObjectExpr();
   const ObjectExpr *ToObjectExpr() const;
 
@@ -341,6 +415,7 @@ class IdentifierExpr : public Expr {
   std::string name_;
   enum Linkage linkage_;
   bool is_type_name_;
+  std::string asm_label_;
 };
 
 class EnumeratorExpr : public IdentifierExpr {
@@ -399,8 +474,10 @@ class ObjectExpr : public IdentifierExpr {
   bool IsGlobalVar() const;
   bool IsLocalStaticVar() const;
 
-  void SetLocalPtr(llvm::AllocaInst *local_ptr);
-  llvm::AllocaInst *GetLocalPtr() const;
+  // 变长数组的地址不是 alloca 指令本身, 而是其 bitcast
+  void SetLocalPtr(llvm::Value *local_ptr);
+  bool HasLocalPtr() const;
+  llvm::Value *GetLocalPtr() const;
   llvm::GlobalVariable *GetGlobalPtr() const;
 
   std::list<std::pair<Type *, std::int32_t>> &GetIndexs();
@@ -435,7 +512,7 @@ class ObjectExpr : public IdentifierExpr {
   // 用于索引结构体或数组成员
   std::list<std::pair<Type *, std::int32_t>> indexs_;
 
-  llvm::AllocaInst *local_ptr_{};
+  llvm::Value *local_ptr_{};
 
   std::string func_name_;
 };
@@ -458,6 +535,33 @@ class StmtExpr : public Expr {
   CompoundStmt *block_;
 };
 
+// GNU 扩展, &&label
+class LabelAddrExpr : public Expr {
+ public:
+  static LabelAddrExpr *Get(const std::string &name);
+
+  virtual AstNodeType Kind() const override;
+  virtual void Accept(Visitor &visitor) const override;
+  virtual void Check() override;
+  virtual bool IsLValue() const override;
+
+  const std::string &GetName() const;
+  const LabelStmt *GetLabel() const;
+  void SetLabel(LabelStmt *label);
+
+  // 静态存储期对象的初始值在解析时计算, 此时函数还没有生成,
+  // 先使用占位的全局变量, 生成函数时再替换为 blockaddress
+  llvm::GlobalVariable *GetPlaceholder() const;
+  bool HasPlaceholder() const;
+
+ private:
+  explicit LabelAddrExpr(const std::string &name);
+
+  std::string name_;
+  LabelStmt *label_{};
+  mutable llvm::GlobalVariable *placeholder_{};
+};
+
 class Stmt : public AstNode {
  public:
   virtual std::vector<Stmt *> Children() const;
@@ -536,11 +640,16 @@ class CompoundStmt : public Stmt {
   const std::vector<Stmt *> &GetStmts() const;
   void AddStmt(Stmt *stmt);
 
+  void SetHasVLA();
+  bool HasVLA() const;
+
  private:
   CompoundStmt() = default;
   explicit CompoundStmt(std::vector<Stmt *> stmts);
 
   std::vector<Stmt *> stmts_;
+  // 块中声明了变长数组, 进入块时保存栈指针, 离开块时恢复
+  bool has_vla_{false};
 };
 
 class ExprStmt : public Stmt {
@@ -599,9 +708,24 @@ class SwitchStmt : public Stmt {
   Stmt *stmt_;
 };
 
+// 由循环前的 #pragma unroll / GCC unroll / GCC ivdep / clang loop 指定,
+// 生成代码时转换为 llvm.loop 元数据
+struct LoopHints {
+  // 没有参数的 #pragma unroll 表示完全展开
+  bool unroll_full{false};
+  bool unroll_enable{false};
+  bool unroll_disable{false};
+  std::int32_t unroll_count{};
+  std::optional<bool> vectorize;
+  std::int32_t vectorize_width{};
+  std::int32_t interleave_count{};
+  // 迭代之间没有依赖, 循环中的内存访问可以并行执行
+  bool ivdep{false};
+};
+
 class WhileStmt : public Stmt {
  public:
-  static WhileStmt *Get(Expr *cond, Stmt *block);
+  static WhileStmt *Get(Expr *cond, Stmt *block, const LoopHints &hints = {});
 
   virtual AstNodeType Kind() const override;
   virtual void Accept(Visitor &visitor) const override;
@@ -610,17 +734,20 @@ class WhileStmt : public Stmt {
 
   const Expr *GetCond() const;
   const Stmt *GetBlock() const;
+  const LoopHints &GetLoopHints() const;
 
  private:
-  WhileStmt(Expr *cond, Stmt *block);
+  WhileStmt(Expr *cond, Stmt *block, const LoopHints &hints);
 
   Expr *cond_;
   Stmt *block_;
+  LoopHints hints_;
 };
 
 class DoWhileStmt : public Stmt {
  public:
-  static DoWhileStmt *Get(Expr *cond, Stmt *block);
+  static DoWhileStmt *Get(Expr *cond, Stmt *block,
+                          const LoopHints &hints = {});
 
   virtual AstNodeType Kind() const override;
   virtual void Accept(Visitor &visitor) const override;
@@ -629,18 +756,20 @@ class DoWhileStmt : public Stmt {
 
   const Expr *GetCond() const;
   const Stmt *GetBlock() const;
+  const LoopHints &GetLoopHints() const;
 
  private:
-  DoWhileStmt(Expr *cond, Stmt *block);
+  DoWhileStmt(Expr *cond, Stmt *block, const LoopHints &hints);
 
   Expr *cond_;
   Stmt *block_;
+  LoopHints hints_;
 };
 
 class ForStmt : public Stmt {
  public:
   static ForStmt *Get(Expr *init, Expr *cond, Expr *inc, Stmt *block,
-                      Stmt *decl);
+                      Stmt *decl, const LoopHints &hints = {});
 
   virtual AstNodeType Kind() const override;
   virtual void Accept(Visitor &visitor) const override;
@@ -652,19 +781,23 @@ class ForStmt : public Stmt {
   const Expr *GetInc() const;
   const Stmt *GetBlock() const;
   const Stmt *GetDecl() const;
+  const LoopHints &GetLoopHints() const;
 
  private:
-  ForStmt(Expr *init, Expr *cond, Expr *inc, Stmt *block, Stmt *decl);
+  ForStmt(Expr *init, Expr *cond, Expr *inc, Stmt *block, Stmt *decl,
+          const LoopHints &hints);
 
   Expr *init_, *cond_, *inc_;
   Stmt *block_;
   Stmt *decl_;
+  LoopHints hints_;
 };
 
 class GotoStmt : public Stmt {
  public:
   static GotoStmt *Get(const std::string &name);
   static GotoStmt *Get(LabelStmt *label);
+  static GotoStmt *Get(Expr *expr);
 
   virtual AstNodeType Kind() const override;
   virtual void Accept(Visitor &visitor) const override;
@@ -673,13 +806,17 @@ class GotoStmt : public Stmt {
   const LabelStmt *GetLabel() const;
   void SetLabel(LabelStmt *label);
   const std::string &GetName() const;
+  // GNU 扩展, goto *expr, 否则为 nullptr
+  const Expr *GetExpr() const;
 
  private:
   explicit GotoStmt(const std::string &name);
   explicit GotoStmt(LabelStmt *ident);
+  explicit GotoStmt(Expr *expr);
 
   std::string name_;
   LabelStmt *label_{};
+  Expr *expr_{};
 };
 
 class ContinueStmt : public Stmt {
@@ -708,18 +845,128 @@ class BreakStmt : public Stmt {
 
 class ReturnStmt : public Stmt {
  public:
-  static ReturnStmt *Get(Expr *expr = nullptr);
+  static ReturnStmt *Get(Expr *expr = nullptr, Type *func_type = nullptr,
+                         bool must_tail = false);
 
   virtual AstNodeType Kind() const override;
   virtual void Accept(Visitor &visitor) const override;
   virtual void Check() override;
 
   const Expr *GetExpr() const;
+  // __attribute__((musttail))
+  bool IsMustTail() const;
 
  private:
-  explicit ReturnStmt(Expr *expr = nullptr);
+  explicit ReturnStmt(Expr *expr = nullptr, Type *func_type = nullptr,
+                      bool must_tail = false);
 
   Expr *expr_;
+  // 所在函数的类型
+  Type *func_type_;
+  bool must_tail_;
+};
+
+// GNU 扩展, 内联汇编
+// asm [volatile] [inline] [goto] ( 汇编模板
+//     : 输出操作数 : 输入操作数 : 破坏列表 : 跳转标签 );
+class AsmStmt : public Stmt {
+ public:
+  struct Operand {
+    // [name] "constraint" (expr)
+    std::string name;
+    std::string constraint;
+    Expr *expr;
+  };
+
+  static AsmStmt *Get(const std::string &asm_str, bool is_volatile,
+                      std::vector<Operand> outputs,
+                      std::vector<Operand> inputs,
+                      std::vector<std::string> clobbers,
+                      std::vector<GotoStmt *> labels);
+
+  virtual AstNodeType Kind() const override;
+  virtual void Accept(Visitor &visitor) const override;
+  virtual void Check() override;
+
+  const std::string &GetAsmString() const;
+  bool IsVolatile() const;
+  bool IsAsmGoto() const;
+  const std::vector<Operand> &GetOutputs() const;
+  const std::vector<Operand> &GetInputs() const;
+  const std::vector<std::string> &GetClobbers() const;
+  const std::vector<GotoStmt *> &GetLabels() const;
+
+ private:
+  AsmStmt(const std::string &asm_str, bool is_volatile,
+          std::vector<Operand> outputs, std::vector<Operand> inputs,
+          std::vector<std::string> clobbers, std::vector<GotoStmt *> labels);
+
+  std::string asm_str_;
+  bool is_volatile_;
+  std::vector<Operand> outputs_;
+  std::vector<Operand> inputs_;
+  std::vector<std::string> clobbers_;
+  std::vector<GotoStmt *> labels_;
+};
+
+// OpenMP 指令(-fopenmp), 支持 parallel / for / parallel for / critical /
+// barrier, simd 只作为循环的提示
+class OmpStmt : public Stmt {
+ public:
+  enum class Directive { kParallel, kFor, kParallelFor, kCritical, kBarrier };
+  enum class Schedule { kStatic, kDynamic };
+
+  struct Clauses {
+    Expr *num_threads{};
+    Schedule schedule{Schedule::kStatic};
+    Expr *chunk_size{};
+    bool nowait{false};
+    std::vector<ObjectExpr *> privates;
+    // e.g. reduction(+: sum), 运算符为 + * - & | ^ && || max min
+    std::vector<std::pair<std::string, ObjectExpr *>> reductions;
+    // critical (name)
+    std::string name;
+  };
+
+  static OmpStmt *Get(Directive directive, const Clauses &clauses,
+                      Stmt *block = nullptr);
+
+  virtual AstNodeType Kind() const override;
+  virtual void Accept(Visitor &visitor) const override;
+  virtual void Check() override;
+  virtual std::vector<Stmt *> Children() const override;
+
+  Directive GetDirective() const;
+  const Clauses &GetClauses() const;
+  const Stmt *GetBlock() const;
+
+  // 以下用于 for / parallel for, 循环需要是规范形式
+  // for (iv = lb; iv < ub; iv += step), 比较运算符也可以是 <= > >=
+  const ForStmt *GetLoop() const;
+  ObjectExpr *GetIterVar() const;
+  const Expr *GetLowerBound() const;
+  const Expr *GetUpperBound() const;
+  Tag GetCondOp() const;
+  // 为 nullptr 时步长为 1
+  const Expr *GetStep() const;
+  // --iv / iv-- / iv -= step
+  bool IsDecrement() const;
+
+ private:
+  OmpStmt(Directive directive, const Clauses &clauses, Stmt *block);
+
+  void CheckLoop();
+
+  Directive directive_;
+  Clauses clauses_;
+  Stmt *block_;
+
+  ObjectExpr *iter_var_{};
+  const Expr *lower_bound_{};
+  const Expr *upper_bound_{};
+  Tag cond_op_{};
+  const Expr *step_{};
+  bool is_decrement_{false};
 };
 
 using ExtDecl = AstNode;
@@ -814,11 +1061,16 @@ class FuncDef : public ExtDecl {
   IdentifierExpr *GetIdent() const;
   const CompoundStmt *GetBody() const;
 
+  void SetLabelAddrs(std::vector<LabelAddrExpr *> label_addrs);
+  const std::vector<LabelAddrExpr *> &GetLabelAddrs() const;
+
  private:
   explicit FuncDef(IdentifierExpr *ident);
 
   IdentifierExpr *ident_;
   CompoundStmt *body_{};
+  // 函数中所有的 &&label
+  std::vector<LabelAddrExpr *> label_addrs_;
 };
 
 template <typename T, typename... Args>
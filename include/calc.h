@@ -33,6 +33,7 @@ class CalcConstantExpr : public Visitor {
   virtual void Visit(const ConstantExpr *node) override;
   virtual void Visit(const EnumeratorExpr *node) override;
   virtual void Visit(const StmtExpr *node) override;
+  virtual void Visit(const LabelAddrExpr *node) override;
   virtual void Visit(const StringLiteralExpr *node) override;
 
   virtual void Visit(const FuncCallExpr *node) override;
@@ -53,6 +54,8 @@ class CalcConstantExpr : public Visitor {
   virtual void Visit(const ContinueStmt *node) override;
   virtual void Visit(const BreakStmt *node) override;
   virtual void Visit(const ReturnStmt *node) override;
+  virtual void Visit(const AsmStmt *node) override;
+  virtual void Visit(const OmpStmt *node) override;
 
   virtual void Visit(const TranslationUnit *node) override;
   virtual void Visit(const Declaration *node) override;
@@ -4,16 +4,23 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include <clang/Basic/TargetInfo.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/Metadata.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/ValueHandle.h>
@@ -41,10 +48,14 @@ class CodeGen : public Visitor {
   struct BreakContinue {
    public:
     BreakContinue(llvm::BasicBlock *break_block,
-                  llvm::BasicBlock *continue_block);
+                  llvm::BasicBlock *continue_block, std::size_t break_depth,
+                  std::size_t continue_depth);
 
     llvm::BasicBlock *break_block;
     llvm::BasicBlock *continue_block;
+    // 跳转前需要恢复的栈指针在 stack_saves_ 中的下标
+    std::size_t break_depth;
+    std::size_t continue_depth;
   };
 
   static llvm::BasicBlock *CreateBasicBlock(const std::string &name = "",
@@ -56,19 +67,26 @@ class CodeGen : public Visitor {
   llvm::Value *EvaluateExprAsBool(const Expr *expr);
   void EmitBranchOnBoolExpr(const Expr *expr, llvm::BasicBlock *true_block,
                             llvm::BasicBlock *false_block);
+  static llvm::MDNode *GetExpectBranchWeights(const Expr *expr);
   static void SimplifyForwardingBlocks(llvm::BasicBlock *bb);
+  static void EmitLoopMetadata(llvm::BasicBlock *header,
+                               const LoopHints &hints);
   void EmitStmt(const Stmt *stmt);
   bool EmitSimpleStmt(const Stmt *stmt);
   static bool ContainsLabel(const Stmt *stmt);
   void EmitBranchThroughCleanup(llvm::BasicBlock *dest);
   llvm::BasicBlock *GetBasicBlockForLabel(const LabelStmt *label);
+  llvm::BasicBlock *GetIndirectGotoBlock();
   static bool IsCheapEnoughToEvaluateUnconditionally(const Expr *expr);
   llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Type *type, std::int32_t align,
                                            const std::string &name);
   llvm::Value *GetPtr(const AstNode *node);
+  llvm::Value *GetObjectPtr(const ObjectExpr *obj) const;
   void PushBlock(llvm::BasicBlock *break_stack,
-                 llvm::BasicBlock *continue_block);
+                 llvm::BasicBlock *continue_block,
+                 std::optional<std::size_t> continue_depth = {});
   void PopBlock();
+  void EmitStackRestore(std::size_t depth);
   bool TestAndClearIgnoreAssignResult();
   void SetIgnoreAssignResult();
 
@@ -91,6 +109,7 @@ class CodeGen : public Visitor {
   virtual void Visit(const EnumeratorExpr *node) override;
   virtual void Visit(const ObjectExpr *node) override;
   virtual void Visit(const StmtExpr *node) override;
+  virtual void Visit(const LabelAddrExpr *node) override;
 
   virtual void Visit(const LabelStmt *node) override;
   virtual void Visit(const CaseStmt *node) override;
@@ -106,6 +125,8 @@ class CodeGen : public Visitor {
   virtual void Visit(const ContinueStmt *node) override;
   virtual void Visit(const BreakStmt *node) override;
   virtual void Visit(const ReturnStmt *node) override;
+  virtual void Visit(const AsmStmt *node) override;
+  virtual void Visit(const OmpStmt *node) override;
 
   virtual void Visit(const TranslationUnit *node) override;
   virtual void Visit(const Declaration *node) override;
@@ -116,6 +137,8 @@ class CodeGen : public Visitor {
   llvm::Value *LogicNotOp(llvm::Value *value);
   llvm::Value *Deref(const UnaryOpExpr *node);
 
+  static llvm::Value *ArithmeticOp(Tag op, llvm::Value *lhs, llvm::Value *rhs,
+                                   bool is_unsigned);
   static llvm::Value *AddOp(llvm::Value *lhs, llvm::Value *rhs,
                             bool is_unsigned);
   static llvm::Value *SubOp(llvm::Value *lhs, llvm::Value *rhs,
@@ -142,11 +165,25 @@ class CodeGen : public Visitor {
                                 bool is_unsigned);
   static llvm::Value *EqualOp(llvm::Value *lhs, llvm::Value *rhs);
   static llvm::Value *NotEqualOp(llvm::Value *lhs, llvm::Value *rhs);
+  static llvm::Value *CmpResult(llvm::Value *value, llvm::Type *operand_type);
   llvm::Value *LogicOrOp(const BinaryOpExpr *node);
   llvm::Value *LogicAndOp(const BinaryOpExpr *node);
   llvm::Value *AssignOp(const BinaryOpExpr *node);
   llvm::Value *MemberRef(const BinaryOpExpr *node);
   llvm::Value *Assign(llvm::Value *lhs_ptr, llvm::Value *rhs, bool is_unsigned);
+  static bool IsMemCpyAggregate(const Expr *expr);
+  void CopyAggregate(llvm::Value *dest, const Expr *src, bool is_volatile);
+
+  static llvm::AtomicOrdering GetAtomicOrdering(const Expr *order);
+  static llvm::Value *ToAtomicInt(llvm::Value *value, llvm::Type *int_type);
+  static llvm::Value *FromAtomicInt(llvm::Value *value, llvm::Type *type);
+  llvm::Value *AtomicLoad(llvm::Value *ptr, llvm::AtomicOrdering order,
+                          bool is_volatile);
+  llvm::Value *AtomicStore(llvm::Value *value, llvm::Value *ptr,
+                           llvm::AtomicOrdering order, bool is_volatile);
+  llvm::Value *AtomicIncOrDec(llvm::Value *ptr, const Type *type, bool is_inc,
+                              bool is_postfix);
+  llvm::Value *AtomicCompoundAssign(const BinaryOpExpr *node);
 
   bool MayCallBuiltinFunc(const FuncCallExpr *node);
   llvm::Value *VaStart(Expr *arg);
@@ -154,6 +191,11 @@ class CodeGen : public Visitor {
   llvm::Value *VaArg(Expr *arg, llvm::Type *type);
   llvm::Value *VaCopy(Expr *arg, Expr *arg2);
   llvm::Value *SyncSynchronize();
+  llvm::Value *AtomicBuiltin(const FuncCallExpr *node);
+  llvm::Value *AtomicFence(Expr *order, bool is_signal);
+  llvm::Value *AtomicTestAndSet(Expr *arg, Expr *order);
+  llvm::Value *AtomicClear(Expr *arg, Expr *order);
+  llvm::Value *AtomicIsLockFree(Expr *size);
   llvm::Value *Alloc(Expr *arg);
   llvm::Value *PopCount(Expr *arg);
   llvm::Value *Clz(Expr *arg);
@@ -163,8 +205,40 @@ class CodeGen : public Visitor {
   llvm::Value *Bswap16(Expr *arg);
   llvm::Value *Bswap32(Expr *arg);
   llvm::Value *Bswap64(Expr *arg);
+  llvm::Value *Rotate(const FuncCallExpr *node, bool is_left);
+  llvm::Value *Ffs(Expr *arg);
+  llvm::Value *Parity(Expr *arg);
+  llvm::Value *Expect(const FuncCallExpr *node);
+  llvm::Value *Prefetch(const FuncCallExpr *node);
+  llvm::Value *Unreachable();
+  llvm::Value *AssumeAligned(const FuncCallExpr *node);
+  static llvm::Value *ConstantP(Expr *arg);
+  llvm::Value *MemCpy(const FuncCallExpr *node, bool is_move);
+  llvm::Value *MemSet(const FuncCallExpr *node);
+  llvm::Value *OverflowBuiltin(const FuncCallExpr *node);
+  std::pair<llvm::Value *, llvm::Value *> SignedWideMulOverflow(
+      llvm::Value *lhs, llvm::Value *rhs);
+  llvm::Value *ShuffleVector(const FuncCallExpr *node);
+  llvm::Value *Shuffle(const FuncCallExpr *node);
+
+  static std::string SimplifyConstraint(
+      const char *constraint,
+      llvm::ArrayRef<clang::TargetInfo::ConstraintInfo> output_infos = {});
+  static std::string ConvertAsmString(const AsmStmt *node,
+                                      std::size_t num_in_out);
+
+  void EmitOmpParallel(const OmpStmt *node);
+  void EmitOmpFor(const OmpStmt *node);
+  void EmitOmpCritical(const OmpStmt *node);
+  std::vector<llvm::Value *> EmitOmpDataSharing(const OmpStmt *node);
+  void EmitOmpReduction(const OmpStmt *node,
+                        const std::vector<llvm::Value *> &shared_ptrs);
+  static llvm::Constant *GetOmpReductionInit(const std::string &op,
+                                             Type *type);
+  void OutlineOmpRegions();
 
   void DealLocaleDecl(const Declaration *node);
+  void DealVLADecl(const Declaration *node);
   void InitLocalAggregate(const Declaration *node);
 
   void StartFunction(const FuncDef *node);
@@ -178,9 +252,28 @@ class CodeGen : public Visitor {
   bool load_struct_{false};
 
   std::stack<BreakContinue> break_continue_stack_;
+  // 声明了变长数组的块在进入时保存的栈指针
+  std::vector<llvm::Value *> stack_saves_;
   std::unordered_map<const LabelStmt *, llvm::BasicBlock *> labels_;
+  // 所有的 goto *expr 都跳转到该基本块, 再由其中的 indirectbr 跳转到
+  // 取过地址的标签
+  llvm::BasicBlock *indirect_goto_block_{};
+  llvm::PHINode *indirect_goto_phi_{};
+  // return f(...) 中的调用
+  std::vector<llvm::CallInst *> tail_calls_;
   llvm::SwitchInst *switch_inst_{};
 
+  // parallel 区域, 函数生成完毕后提取为函数
+  struct OmpRegion {
+    llvm::BasicBlock *entry;
+    llvm::BasicBlock *exit;
+    llvm::Value *num_threads;
+    Location loc;
+  };
+  std::vector<OmpRegion> omp_regions_;
+  // private / reduction 子句中的变量在 OpenMP 构造中使用的副本
+  std::unordered_map<const ObjectExpr *, llvm::Value *> omp_privates_;
+
   llvm::Function *func_{};
   llvm::BasicBlock *return_block_{};
   llvm::Value *return_value_{};
@@ -189,6 +282,7 @@ class CodeGen : public Visitor {
   ObjectExpr *bit_field_{nullptr};
 
   bool is_volatile_{false};
+  bool is_atomic_{false};
   bool ignore_assign_result_{false};
 
   std::unique_ptr<DebugInfo> debug_info_;
@@ -46,6 +46,7 @@ class DebugInfo {
   llvm::DIType *CreateBuiltinType(Type *type);
   llvm::DIType *CreatePointerType(Type *type);
   llvm::DIType *CreateArrayType(Type *type);
+  llvm::DIType *CreateVectorType(Type *type);
   llvm::DIType *CreateStructType(Type *type, const Location &loc);
   llvm::DISubroutineType *CreateFunctionType(Type *type);
 
@@ -0,0 +1,14 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+#pragma once
+
+#include <string>
+
+namespace kcc {
+
+// --run, 通过 ORC JIT 执行 Module 中的 main, 以其返回值退出进程
+[[noreturn]] void RunJit(const std::string &file_name);
+
+}  // namespace kcc
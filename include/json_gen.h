@@ -29,6 +29,7 @@ class JsonGen : public Visitor {
   virtual void Visit(const EnumeratorExpr *node) override;
   virtual void Visit(const ObjectExpr *node) override;
   virtual void Visit(const StmtExpr *node) override;
+  virtual void Visit(const LabelAddrExpr *node) override;
 
   virtual void Visit(const LabelStmt *node) override;
   virtual void Visit(const CaseStmt *node) override;
@@ -44,6 +45,8 @@ class JsonGen : public Visitor {
   virtual void Visit(const ContinueStmt *node) override;
   virtual void Visit(const BreakStmt *node) override;
   virtual void Visit(const ReturnStmt *node) override;
+  virtual void Visit(const AsmStmt *node) override;
+  virtual void Visit(const OmpStmt *node) override;
 
   virtual void Visit(const TranslationUnit *node) override;
   virtual void Visit(const Declaration *node) override;
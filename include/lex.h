@@ -45,6 +45,8 @@ class Scanner {
 
   void SkipSpace();
   void SkipLineDirectives();
+  bool IsPragma() const;
+  bool SkipPragma();
 
   const Token &SkipNumber();
   const Token &SkipIdentifier();
@@ -4,8 +4,15 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 namespace kcc {
 
 bool Link();
 
+// ld -r, 将多个目标文件合并为一个可重定位目标文件
+bool LinkRelocatable(const std::vector<std::string> &obj_files,
+                     const std::string &output);
+
 }  // namespace kcc
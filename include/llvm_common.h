@@ -10,6 +10,7 @@
 
 #include <clang/Basic/TargetInfo.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <llvm/ADT/StringRef.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/IRBuilder.h>
@@ -34,10 +35,20 @@ inline clang::TargetInfo *TargetInfo;
 
 inline std::unique_ptr<llvm::TargetMachine> TargetMachine;
 
+// 由 -march / -mtune / -m<feature> 决定, 也用于函数的 target-cpu 等属性
+inline std::string TargetCPU;
+inline std::string TuneCPU;
+inline std::string TargetFeatures;
+
+// 为 false 时(-fno-math-errno / -ffast-math)数学库函数被视为无副作用
+inline bool MathErrno{true};
+
 inline clang::CompilerInstance Ci;
 
 void InitLLVM();
 
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine();
+
 std::string LLVMTypeToStr(llvm::Type *type);
 
 std::string LLVMConstantToStr(llvm::Constant *constant);
@@ -76,9 +87,12 @@ llvm::GlobalVariable *CreateGlobalVar(const ObjectExpr *obj);
 
 const llvm::fltSemantics &GetFloatTypeSemantics(llvm::Type *type);
 
+bool IsMathLibFunc(llvm::StringRef name);
+
 llvm::Type *GetBitFieldSpace(std::int8_t width);
 
 std::int32_t GetLLVMTypeSize(llvm::Type *type);
+std::int32_t GetLLVMTypeAlign(llvm::Type *type);
 
 llvm::Constant *GetBitField(llvm::Constant *value, std::int32_t size,
                             std::int32_t width, std::int32_t begin);
@@ -0,0 +1,23 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace kcc {
+
+// 在每个编译阶段结束时调用, 记录当前进程的峰值 RSS
+void MemReportPhase(std::string_view phase);
+
+// 记录预处理结果 / token 序列等缓冲区的元素个数和占用的字节数
+void MemReportBuffer(std::string_view name, std::size_t count,
+                     std::size_t bytes);
+
+// 打印内存使用情况, 并以 JSON 格式写入 json_file
+void MemReportPrint(const std::string &json_file);
+
+}  // namespace kcc
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include <boost/pool/object_pool.hpp>
 
 #include "ast.h"
@@ -12,44 +14,64 @@
 
 namespace kcc {
 
-inline boost::object_pool<UnaryOpExpr> UnaryOpExprPool;
-inline boost::object_pool<TypeCastExpr> TypeCastExprPool;
-inline boost::object_pool<BinaryOpExpr> BinaryOpExprPool;
-inline boost::object_pool<ConditionOpExpr> ConditionOpExprPool;
-inline boost::object_pool<FuncCallExpr> FuncCallExprPool;
-inline boost::object_pool<ConstantExpr> ConstantExprPool;
-inline boost::object_pool<StringLiteralExpr> StringLiteralExprPool;
-inline boost::object_pool<IdentifierExpr> IdentifierExprPool;
-inline boost::object_pool<EnumeratorExpr> EnumeratorExprPool;
-inline boost::object_pool<ObjectExpr> ObjectExprPool;
-inline boost::object_pool<StmtExpr> StmtExprPool;
-
-inline boost::object_pool<LabelStmt> LabelStmtPool;
-inline boost::object_pool<CaseStmt> CaseStmtPool;
-inline boost::object_pool<DefaultStmt> DefaultStmtPool;
-inline boost::object_pool<CompoundStmt> CompoundStmtPool;
-inline boost::object_pool<ExprStmt> ExprStmtPool;
-inline boost::object_pool<IfStmt> IfStmtPool;
-inline boost::object_pool<SwitchStmt> SwitchStmtPool;
-inline boost::object_pool<WhileStmt> WhileStmtPool;
-inline boost::object_pool<DoWhileStmt> DoWhileStmtPool;
-inline boost::object_pool<ForStmt> ForStmtPool;
-inline boost::object_pool<GotoStmt> GotoStmtPool;
-inline boost::object_pool<ContinueStmt> ContinueStmtPool;
-inline boost::object_pool<BreakStmt> BreakStmtPool;
-inline boost::object_pool<ReturnStmt> ReturnStmtPool;
-
-inline boost::object_pool<TranslationUnit> TranslationUnitPool;
-inline boost::object_pool<Declaration> DeclarationPool;
-inline boost::object_pool<FuncDef> FuncDefPool;
-
-inline boost::object_pool<VoidType> VoidTypePool;
-inline boost::object_pool<ArithmeticType> ArithmeticTypePool;
-inline boost::object_pool<PointerType> PointerTypePool;
-inline boost::object_pool<ArrayType> ArrayTypePool;
-inline boost::object_pool<StructType> StructTypePool;
-inline boost::object_pool<FunctionType> FunctionTypePool;
-
-inline boost::object_pool<Scope> ScopePool;
+// 记录分配的对象个数, 用于 -fmem-report
+template <typename T>
+class ObjectPool : public boost::object_pool<T> {
+ public:
+  T *malloc() {
+    ++count_;
+    return boost::object_pool<T>::malloc();
+  }
+
+  std::size_t GetCount() const { return count_; }
+  std::size_t GetBytes() const { return count_ * sizeof(T); }
+
+ private:
+  std::size_t count_{};
+};
+
+inline ObjectPool<UnaryOpExpr> UnaryOpExprPool;
+inline ObjectPool<TypeCastExpr> TypeCastExprPool;
+inline ObjectPool<BinaryOpExpr> BinaryOpExprPool;
+inline ObjectPool<ConditionOpExpr> ConditionOpExprPool;
+inline ObjectPool<FuncCallExpr> FuncCallExprPool;
+inline ObjectPool<ConstantExpr> ConstantExprPool;
+inline ObjectPool<StringLiteralExpr> StringLiteralExprPool;
+inline ObjectPool<IdentifierExpr> IdentifierExprPool;
+inline ObjectPool<EnumeratorExpr> EnumeratorExprPool;
+inline ObjectPool<ObjectExpr> ObjectExprPool;
+inline ObjectPool<StmtExpr> StmtExprPool;
+inline ObjectPool<LabelAddrExpr> LabelAddrExprPool;
+
+inline ObjectPool<LabelStmt> LabelStmtPool;
+inline ObjectPool<CaseStmt> CaseStmtPool;
+inline ObjectPool<DefaultStmt> DefaultStmtPool;
+inline ObjectPool<CompoundStmt> CompoundStmtPool;
+inline ObjectPool<ExprStmt> ExprStmtPool;
+inline ObjectPool<IfStmt> IfStmtPool;
+inline ObjectPool<SwitchStmt> SwitchStmtPool;
+inline ObjectPool<WhileStmt> WhileStmtPool;
+inline ObjectPool<DoWhileStmt> DoWhileStmtPool;
+inline ObjectPool<ForStmt> ForStmtPool;
+inline ObjectPool<GotoStmt> GotoStmtPool;
+inline ObjectPool<ContinueStmt> ContinueStmtPool;
+inline ObjectPool<BreakStmt> BreakStmtPool;
+inline ObjectPool<ReturnStmt> ReturnStmtPool;
+inline ObjectPool<AsmStmt> AsmStmtPool;
+inline ObjectPool<OmpStmt> OmpStmtPool;
+
+inline ObjectPool<TranslationUnit> TranslationUnitPool;
+inline ObjectPool<Declaration> DeclarationPool;
+inline ObjectPool<FuncDef> FuncDefPool;
+
+inline ObjectPool<VoidType> VoidTypePool;
+inline ObjectPool<ArithmeticType> ArithmeticTypePool;
+inline ObjectPool<PointerType> PointerTypePool;
+inline ObjectPool<ArrayType> ArrayTypePool;
+inline ObjectPool<VectorType> VectorTypePool;
+inline ObjectPool<StructType> StructTypePool;
+inline ObjectPool<FunctionType> FunctionTypePool;
+
+inline ObjectPool<Scope> ScopePool;
 
 }  // namespace kcc
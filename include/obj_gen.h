@@ -14,4 +14,7 @@ void ObjGen(
     const std::string &obj_file,
     llvm::CodeGenFileType file_type = llvm::CodeGenFileType::CGFT_ObjectFile);
 
+// 用于 -flto, ThinLTO 时同时写入模块摘要
+void BitcodeGen(const std::string &bc_file);
+
 }  // namespace kcc
@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <string>
+
 namespace kcc {
 
+// 需要在代码生成之前调用, 后端的 pass 也会产生优化备注
+void InitOptimizationRemarks(const std::string &file_name);
+
 void Optimization();
 
 }  // namespace kcc
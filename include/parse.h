@@ -24,6 +24,13 @@
 
 namespace kcc {
 
+// 目前只记录会影响类型的属性, 其余的属性解析后忽略
+struct Attributes {
+  std::optional<std::int64_t> vector_size;
+  // 语句属性, 只能用于 return 语句
+  bool must_tail{false};
+};
+
 class Parser {
  public:
   explicit Parser(std::vector<Token> tokens);
@@ -107,13 +114,17 @@ class Parser {
   Stmt *ParseExprStmt();
   Stmt *ParseIfStmt();
   Stmt *ParseSwitchStmt();
-  Stmt *ParseWhileStmt();
-  Stmt *ParseDoWhileStmt();
-  Stmt *ParseForStmt();
+  Stmt *ParseWhileStmt(const LoopHints &hints = {});
+  Stmt *ParseDoWhileStmt(const LoopHints &hints = {});
+  Stmt *ParseForStmt(const LoopHints &hints = {});
+  void ParseLoopPragma(LoopHints &hints);
+  Stmt *ParseOmpPragma(LoopHints &hints);
+  void ParseOmpClauses(OmpStmt::Clauses &clauses, std::int32_t &safelen);
+  std::vector<ObjectExpr *> ParseOmpVarList();
   Stmt *ParseGotoStmt();
   Stmt *ParseContinueStmt();
   Stmt *ParseBreakStmt();
-  Stmt *ParseReturnStmt();
+  Stmt *ParseReturnStmt(bool must_tail = false);
 
   /*
    * Decl
@@ -132,6 +143,9 @@ class Parser {
   Type *ParseEnumSpec();
   void ParseEnumerator();
   std::int32_t ParseAlignas();
+  void CheckAtomicType(const Token &tok, QualType type);
+  QualType ApplyAttributes(const Token &tok, QualType type,
+                           const Attributes &attrs);
 
   /*
    * Declarator
@@ -144,12 +158,13 @@ class Parser {
                                    std::uint32_t storage_class_spec,
                                    std::uint32_t func_spec, std::int32_t align);
   void ParseInitDeclaratorSub(Declaration *decl);
+  void ParseAutoTypeInit(Declaration *decl, bool is_local);
   void ParseDeclarator(Token &tok, QualType &base_type);
   void ParsePointer(QualType &type);
   std::uint32_t ParseTypeQualList();
   void ParseDirectDeclarator(Token &tok, QualType &base_type);
   void ParseDirectDeclaratorTail(QualType &base_type);
-  std::optional<std::size_t> ParseArrayLength();
+  std::optional<std::size_t> ParseArrayLength(Expr **vla_length);
   std::pair<std::vector<ObjectExpr *>, bool> ParseParamTypeList();
   ObjectExpr *ParseParamDecl();
 
@@ -170,6 +185,7 @@ class Parser {
                              bool designated);
   void ParseStructInitializer(std::vector<Initializer> &inits, Type *type,
                               bool designated);
+  void ParseVectorInitializer(std::vector<Initializer> &inits, Type *type);
 
   /*
    * ConstantInit
@@ -178,18 +194,26 @@ class Parser {
                                            bool force_brace);
   llvm::Constant *ParseConstantArrayInitializer(Type *type, bool designated);
   llvm::Constant *ParseConstantStructInitializer(Type *type, bool designated);
+  llvm::Constant *ParseConstantVectorInitializer(Type *type);
   llvm::Constant *ParseLiteralInitializer(Type *type, bool need_ptr);
+  llvm::Constant *TryParseConstantDataArray(Type *type, bool need_ptr);
+  llvm::Constant *ParseEmbedInitializer(Type *type, bool need_ptr);
 
   /*
    * GNU 扩展
    */
-  void TryParseAttributeSpec();
-  void ParseAttributeList();
-  void ParseAttribute();
+  void TryParseAttributeSpec(Attributes *attrs = nullptr);
+  void ParseAttributeList(Attributes *attrs);
+  void ParseAttribute(Attributes *attrs);
   void ParseAttributeParamList();
   void ParseAttributeExprList();
-  void TryParseAsm();
+  std::string TryParseAsmLabel();
+  Stmt *ParseAsmStmt();
+  std::vector<AsmStmt::Operand> ParseAsmOperands();
+  std::vector<std::string> ParseAsmClobbers();
+  std::vector<GotoStmt *> ParseAsmLabels();
   QualType ParseTypeof();
+  QualType ParseAutoType();
   Expr *TryParseStmtExpr();
   Expr *ParseStmtExpr();
   Expr *ParseTypeid();
@@ -212,6 +236,11 @@ class Parser {
 
   std::unordered_map<std::string, LabelStmt *> labels_;
   std::vector<GotoStmt *> gotos_;
+  std::vector<LabelAddrExpr *> label_addrs_;
+
+  // __auto_type 推导类型时解析的初始化表达式及其之后的位置
+  Expr *auto_type_init_{};
+  decltype(tokens_)::size_type auto_type_end_{};
 
   // 用于将块作用与的复合字面量加入块中
   std::stack<CompoundStmt *> compound_stmt_;
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "ast.h"
 #include "token.h"
@@ -58,6 +60,9 @@ class Scope {
   bool IsFileScope() const;
   bool IsBlockScope() const;
 
+  // 所有作用域中哈希表的元素个数与桶的个数, 用于 -fmem-report
+  static std::pair<std::size_t, std::size_t> GetHashMapStats();
+
  private:
   Scope(Scope *parent, enum ScopeType type);
 
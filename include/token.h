@@ -123,13 +123,17 @@ enum class Tag {
   kOffsetof,  // __builtin_offsetof
   kHugeVal,   // __builtin_huge_val
   kInff,      // __builtin_inff
+  kEmbed,     // __builtin_embed
 
   kFuncName,       // __func__ / __FUNCTION__
   kAsm,            // asm
   kAttribute,      // __attribute__
+  kPragma,         // #pragma, 只保留与循环有关的和 OpenMP 指令
   kFuncSignature,  // __PRETTY_FUNCTION__
   kExtension,      // __extension__
   kTypeof,         // typeof
+  kAutoType,       // __auto_type
+  kInt128,         // __int128
 
   kTypeid,  // typeid
 
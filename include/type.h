@@ -33,7 +33,9 @@ enum TypeSpec : std::uint32_t {
   kEnumSpec = 0x2000,
   kTypedefName = 0x4000,
 
-  kLongLong = 0x8000
+  kLongLong = 0x8000,
+  // GNU 扩展
+  kInt128 = 0x10000
 };
 
 enum TypeQualifier : std::uint32_t {
@@ -41,7 +43,6 @@ enum TypeQualifier : std::uint32_t {
   // 不支持
   kRestrict = 0x2,
   kVolatile = 0x4,
-  // 不支持
   kAtomic = 0x8
 };
 
@@ -58,13 +59,14 @@ enum StorageClassSpec : std::uint32_t {
 enum FuncSpec : std::uint32_t { kInline = 0x1, kNoreturn = 0x2 };
 
 enum TypeSpecCompatibility : std::uint32_t {
-  kCompSigned = kShort | kInt | kLong | kLongLong,
-  kCompUnsigned = kShort | kInt | kLong | kLongLong,
+  kCompSigned = kShort | kInt | kLong | kLongLong | kInt128,
+  kCompUnsigned = kShort | kInt | kLong | kLongLong | kInt128,
   kCompChar = kSigned | kUnsigned,
   kCompShort = kSigned | kUnsigned | kInt,
   kCompInt = kSigned | kUnsigned | kShort | kLong | kLongLong,
   kCompLong = kSigned | kUnsigned | kInt | kLong,
-  kCompDouble = kLong
+  kCompDouble = kLong,
+  kCompInt128 = kSigned | kUnsigned
 };
 
 class Type;
@@ -72,8 +74,10 @@ class VoidType;
 class ArithmeticType;
 class PointerType;
 class ArrayType;
+class VectorType;
 class StructType;
 class FunctionType;
+class Expr;
 class ObjectExpr;
 class Scope;
 
@@ -97,6 +101,7 @@ class QualType {
 
   bool IsConst() const;
   bool IsVolatile() const;
+  bool IsAtomic() const;
 
  private:
   Type *type_{};
@@ -128,6 +133,7 @@ class Type {
   ArithmeticType *ToArithmeticType();
   PointerType *ToPointerType();
   ArrayType *ToArrayType();
+  VectorType *ToVectorType();
   StructType *ToStructType();
   FunctionType *ToFunctionType();
 
@@ -135,6 +141,7 @@ class Type {
   const ArithmeticType *ToArithmeticType() const;
   const PointerType *ToPointerType() const;
   const ArrayType *ToArrayType() const;
+  const VectorType *ToVectorType() const;
   const StructType *ToStructType() const;
   const FunctionType *ToFunctionType() const;
 
@@ -148,12 +155,15 @@ class Type {
   bool IsIntTy() const;
   bool IsLongTy() const;
   bool IsLongLongTy() const;
+  bool IsInt128Ty() const;
   bool IsFloatTy() const;
   bool IsDoubleTy() const;
   bool IsLongDoubleTy() const;
 
   bool IsPointerTy() const;
   bool IsArrayTy() const;
+  bool IsVLATy() const;
+  bool IsVectorTy() const;
   bool IsStructTy() const;
   bool IsUnionTy() const;
   bool IsStructOrUnionTy() const;
@@ -181,6 +191,12 @@ class Type {
   void ArraySetNumElements(std::size_t num_elements);
   std::size_t ArrayGetNumElements() const;
   QualType ArrayGetElementType() const;
+  Expr *ArrayGetVLALength() const;
+  ObjectExpr *ArrayGetVLASize() const;
+  void ArraySetVLASize(ObjectExpr *size);
+
+  std::size_t VectorGetNumElements() const;
+  QualType VectorGetElementType() const;
 
   bool StructHasName() const;
   void StructSetName(const std::string &name);
@@ -273,6 +289,8 @@ class ArrayType : public Type {
  public:
   static ArrayType *Get(QualType contained_type,
                         std::optional<std::size_t> num_elements = {});
+  // 变长数组, 只支持第一维是变长的
+  static ArrayType *GetVLA(QualType contained_type, Expr *length);
 
   virtual std::int32_t GetWidth() const override;
   virtual std::int32_t GetAlign() const override;
@@ -283,11 +301,42 @@ class ArrayType : public Type {
   std::size_t GetNumElements() const;
   QualType GetElementType() const;
 
+  bool IsVLA() const;
+  Expr *GetVLALength() const;
+  ObjectExpr *GetVLASize() const;
+  void SetVLASize(ObjectExpr *size);
+
  private:
   ArrayType(QualType contained_type, std::optional<std::size_t> num_elements);
+  ArrayType(QualType contained_type, Expr *length);
 
   QualType contained_type_;
   std::optional<std::int64_t> num_elements_;
+
+  // 变长数组的长度表达式
+  Expr *vla_length_{};
+  // 声明变长数组时保存其长度的对象, sizeof 会使用它
+  ObjectExpr *vla_size_{};
+};
+
+// GCC 向量扩展, __attribute__((vector_size(N)))
+class VectorType : public Type {
+ public:
+  static VectorType *Get(QualType element_type, std::size_t num_elements);
+
+  virtual std::int32_t GetWidth() const override;
+  virtual std::int32_t GetAlign() const override;
+  virtual bool Compatible(const Type *other) const override;
+  virtual bool Equal(const Type *other) const override;
+
+  std::size_t GetNumElements() const;
+  QualType GetElementType() const;
+
+ private:
+  VectorType(QualType element_type, std::size_t num_elements);
+
+  QualType element_type_;
+  std::size_t num_elements_;
 };
 
 class StructType : public Type {
@@ -13,12 +13,16 @@
 
 namespace kcc {
 
-enum class OptLevel { kO0, kO1, kO2, kO3 };
+enum class OptLevel { kO0, kO1, kO2, kO3, kOs, kOz };
 
 enum class Langs { kC };
 
 enum class LangStds { kC89, kC99, kC11, kC17, kGnu89, kGnu99, kGnu11, kGnu17 };
 
+enum class FPContract { kOff, kOn, kFast };
+
+enum class LTOKind { kNone, kFull, kThin };
+
 inline std::vector<std::string> ObjFile;
 
 inline std::vector<std::string> SoFile;
@@ -27,6 +31,9 @@ inline std::vector<std::string> AFile;
 
 inline std::vector<std::string> RemoveFile;
 
+// --run 时 .c 文件之后的参数, 传给程序的 main
+inline std::vector<std::string> RunArgs;
+
 inline llvm::cl::OptionCategory Category{"Compiler Options"};
 
 inline llvm::cl::list<std::string> InputFilePaths{llvm::cl::desc{"input files"},
@@ -75,15 +82,44 @@ inline llvm::cl::opt<OptLevel> OptimizationLevel{
         clEnumValN(OptLevel::kO0, "O0", "No optimizations (default)"),
         clEnumValN(OptLevel::kO1, "O1", "Enable trivial optimizations"),
         clEnumValN(OptLevel::kO2, "O2", "Enable default optimizations"),
-        clEnumValN(OptLevel::kO3, "O3", "Enable expensive optimizations")),
+        clEnumValN(OptLevel::kO3, "O3", "Enable expensive optimizations"),
+        clEnumValN(OptLevel::kOs, "Os",
+                   "Like -O2 with extra optimizations for size"),
+        clEnumValN(OptLevel::kOz, "Oz",
+                   "Like -Os but reduces code size further")),
     llvm::cl::cat{Category}};
 
+inline llvm::cl::opt<std::string> Passes{
+    "passes",
+    llvm::cl::desc{"Run the given pass pipeline instead of the default one, "
+                   "e.g. 'default<O2>' or 'function(sroa,instcombine)'"},
+    llvm::cl::value_desc{"pipeline"}, llvm::cl::cat{Category}};
+
 inline llvm::cl::opt<bool> OutputAssembly{
     "S", llvm::cl::desc{"Emit native assembly code"}, llvm::cl::cat{Category}};
 
 inline llvm::cl::opt<bool> Timing{
     "t", llvm::cl::desc{"Print the amount of time"}, llvm::cl::cat{Category}};
 
+inline llvm::cl::opt<bool> FTimeTrace{
+    "ftime-trace",
+    llvm::cl::desc{"Write a Chrome trace event file (.json) with the time "
+                   "spent in each compilation phase"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::uint32_t> FTimeTraceGranularity{
+    "ftime-trace-granularity",
+    llvm::cl::desc{"Minimum time granularity (in microseconds) traced by "
+                   "-ftime-trace"},
+    llvm::cl::value_desc{"microseconds"}, llvm::cl::init(500),
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FMemReport{
+    "fmem-report",
+    llvm::cl::desc{"Print memory usage statistics at the end of compilation "
+                   "and write them to a .mem.json file"},
+    llvm::cl::cat{Category}};
+
 inline llvm::cl::opt<bool> Shared{"shared",
                                   llvm::cl::desc{"Generate dynamic library"},
                                   llvm::cl::cat{Category}};
@@ -134,6 +170,134 @@ inline llvm::cl::opt<bool> FPic{
     "fPIC", llvm::cl::desc{"Emit position-independent code"},
     llvm::cl::cat{Category}};
 
+inline llvm::cl::opt<std::string> March{
+    "march",
+    llvm::cl::desc{"Generate code for the given CPU ('native' for the host)"},
+    llvm::cl::value_desc{"cpu"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> Mcpu{
+    "mcpu", llvm::cl::desc{"Same as -march, -march takes precedence"},
+    llvm::cl::value_desc{"cpu"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> Mtune{
+    "mtune",
+    llvm::cl::desc{"Optimize for the given CPU without changing the ISA"},
+    llvm::cl::value_desc{"cpu"}, llvm::cl::cat{Category}};
+
+// e.g. -mavx2 -mno-fma
+inline llvm::cl::list<std::string> TargetFeatureOptions{
+    "m", llvm::cl::desc{"Enable (-m<feature>) or disable (-mno-<feature>) a "
+                        "target feature"},
+    llvm::cl::value_desc{"feature"}, llvm::cl::Prefix, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FFastMath{
+    "ffast-math",
+    llvm::cl::desc{"Allow aggressive, lossy floating-point optimizations"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FNoMathErrno{
+    "fno-math-errno",
+    llvm::cl::desc{"Assume math functions never set errno"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FFiniteMathOnly{
+    "ffinite-math-only",
+    llvm::cl::desc{"Assume floating-point values are never NaN or Inf"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FNoSignedZeros{
+    "fno-signed-zeros",
+    llvm::cl::desc{"Ignore the sign of floating-point zeros"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FReciprocalMath{
+    "freciprocal-math",
+    llvm::cl::desc{"Allow division to be replaced by multiplication with the "
+                   "reciprocal"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FAssociativeMath{
+    "fassociative-math",
+    llvm::cl::desc{"Allow reassociation of floating-point operations"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<FPContract> FFpContract{
+    "ffp-contract",
+    llvm::cl::desc{"Form fused floating-point operations (e.g. FMAs)"},
+    llvm::cl::init(FPContract::kOn),
+    llvm::cl::values(
+        clEnumValN(FPContract::kOff, "off", "Never fuse"),
+        clEnumValN(FPContract::kOn, "on",
+                   "Fuse when the target allows it (default)"),
+        clEnumValN(FPContract::kFast, "fast",
+                   "Fuse across statements, ignoring rounding")),
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<LTOKind> FLto{
+    "flto", llvm::cl::desc{"Enable link-time optimization"},
+    llvm::cl::init(LTOKind::kNone),
+    llvm::cl::values(
+        clEnumValN(LTOKind::kFull, "full",
+                   "Merge all input files into one module"),
+        clEnumValN(LTOKind::kThin, "thin",
+                   "Optimize input files in parallel with summaries")),
+    llvm::cl::cat{Category}};
+
+// 默认不使用缓存, 共享的固定目录可能被其他用户写入
+inline llvm::cl::opt<std::string> FLtoCacheDir{
+    "flto-cache-dir",
+    llvm::cl::desc{"Directory of the ThinLTO cache (no cache by default)"},
+    llvm::cl::value_desc{"directory"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::uint32_t> FParallelCodegen{
+    "fparallel-codegen",
+    llvm::cl::desc{"Split the module into N partitions and generate object "
+                   "code for them in parallel (0: one per core)"},
+    llvm::cl::value_desc{"N"}, llvm::cl::init(1), llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> FProfileGenerate{
+    "fprofile-generate",
+    llvm::cl::desc{"Generate instrumented code to collect execution counts "
+                   "into <directory>/default_%m.profraw"},
+    llvm::cl::value_desc{"directory"}, llvm::cl::ValueOptional,
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> FProfileUse{
+    "fprofile-use",
+    llvm::cl::desc{"Use instrumentation data for profile-guided optimization, "
+                   "a directory means <directory>/default.profdata"},
+    llvm::cl::value_desc{"path"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FOpenMP{
+    "fopenmp",
+    llvm::cl::desc{"Enable OpenMP directives, links against libgomp"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> RPass{
+    "Rpass",
+    llvm::cl::desc{"Report transformations performed by optimization passes "
+                   "whose name matches the given regular expression"},
+    llvm::cl::value_desc{"regex"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> RPassMissed{
+    "Rpass-missed",
+    llvm::cl::desc{"Report missed transformations by optimization passes "
+                   "whose name matches the given regular expression"},
+    llvm::cl::value_desc{"regex"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> RPassAnalysis{
+    "Rpass-analysis",
+    llvm::cl::desc{"Report transformation analysis from optimization passes "
+                   "whose name matches the given regular expression"},
+    llvm::cl::value_desc{"regex"}, llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<std::string> FSaveOptimizationRecord{
+    "fsave-optimization-record",
+    llvm::cl::desc{"Write optimization remarks to a file next to the output, "
+                   "format is 'yaml' (default) or 'bitstream'"},
+    llvm::cl::value_desc{"format"}, llvm::cl::ValueOptional,
+    llvm::cl::cat{Category}};
+
 inline llvm::cl::opt<bool> FPch{
     "fpch-preprocess",
     llvm::cl::desc{"Allows use of a precompiled header together with -E"},
@@ -145,6 +309,17 @@ inline llvm::cl::opt<bool> DD{
         "make debugging dumps during compilation as specified by letters"},
     llvm::cl::cat{Category}};
 
+inline llvm::cl::opt<bool> JitRun{
+    "run",
+    llvm::cl::desc{"Compile the file in-process and run its main with the "
+                   "JIT, arguments after the file are passed to the program"},
+    llvm::cl::cat{Category}};
+
+inline llvm::cl::opt<bool> FJitLazy{
+    "fjit-lazy",
+    llvm::cl::desc{"With --run, compile each function on its first call"},
+    llvm::cl::cat{Category}};
+
 #ifdef DEV
 inline llvm::cl::opt<bool> DevMode{"dev", llvm::cl::desc{"Dev Mode"},
                                    llvm::cl::cat{Category}};
@@ -160,16 +335,25 @@ void TimingStart();
 
 void TimingEnd(const std::string &str = "");
 
+void TimeTraceStart();
+
+void TimeTraceEnd(const std::string &trace_file);
+
 void EnsureFileExists(const std::string &file_name);
 
 std::string GetObjFile(const std::string &name);
 
 std::string GetFileName(const std::string &name, std::string_view extension);
 
+// 与 clang 一致, 优化备注 / time trace 等文件放在输出文件旁边
+std::string GetAuxFileName(const std::string &name, std::string_view extension);
+
 void RemoveFiles();
 
 bool CommandSuccess(std::int32_t status);
 
 bool DoNotLink();
 
+bool ProfileGenerate();
+
 }  // namespace kcc
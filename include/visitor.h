@@ -23,6 +23,7 @@ class Visitor {
   virtual void Visit(const EnumeratorExpr *node) = 0;
   virtual void Visit(const ObjectExpr *node) = 0;
   virtual void Visit(const StmtExpr *node) = 0;
+  virtual void Visit(const LabelAddrExpr *node) = 0;
 
   virtual void Visit(const LabelStmt *node) = 0;
   virtual void Visit(const CaseStmt *node) = 0;
@@ -38,6 +39,8 @@ class Visitor {
   virtual void Visit(const ContinueStmt *node) = 0;
   virtual void Visit(const BreakStmt *node) = 0;
   virtual void Visit(const ReturnStmt *node) = 0;
+  virtual void Visit(const AsmStmt *node) = 0;
+  virtual void Visit(const OmpStmt *node) = 0;
 
   virtual void Visit(const TranslationUnit *node) = 0;
   virtual void Visit(const Declaration *node) = 0;
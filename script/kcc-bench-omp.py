@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Scaling benchmark of the OpenMP code generated by kcc -fopenmp.
+#
+# test/bench/omp_scaling.c (a static reduction and a dynamically scheduled
+# mandelbrot) is built by every compiler with -O3 -fopenmp and run with
+# OMP_NUM_THREADS=1..--max-threads.  Medians, the speedup over one thread and
+# the parallel efficiency are written as JSON.  Typical usage:
+#
+#     script/kcc-bench-omp.py --kcc build/tool/kcc -o omp.json
+#     script/kcc-bench-omp.py --kcc build/tool/kcc --threads 1,2,4,8
+#
+
+import argparse
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SOURCE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SCHEDULES = ["static", "dynamic"]
+
+
+def build(cc, source, level, exe):
+    cmd = [cc, source, "-std=gnu17", level, "-fopenmp", "-o", exe]
+    result = subprocess.run(cmd,
+                            stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        sys.exit("failed: {}\n{}".format(" ".join(cmd),
+                                         result.stderr.decode()))
+
+
+def run(exe, args, threads, warmup, runs):
+    env = dict(os.environ, OMP_NUM_THREADS=str(threads))
+    times = []
+    for i in range(warmup + runs):
+        start = time.perf_counter()
+        subprocess.run([exe] + args,
+                       stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL,
+                       env=env,
+                       check=True)
+        if i >= warmup:
+            times.append(time.perf_counter() - start)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="OpenMP scaling benchmark of kcc generated code")
+    parser.add_argument("--kcc", default="kcc", help="kcc executable")
+    parser.add_argument("--clang", default="clang")
+    parser.add_argument("--gcc", default="gcc")
+    parser.add_argument("--source-dir", default=SOURCE_DIR)
+    parser.add_argument("--level", default="-O3")
+    parser.add_argument("--threads",
+                        help="e.g. --threads=1,2,4,8 (default: 1..ncpu)")
+    parser.add_argument("--iterations", type=int, default=10)
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("-o", "--output", default="kcc-bench-omp.json")
+    args = parser.parse_args()
+
+    if args.threads:
+        threads = [int(n) for n in args.threads.split(",")]
+    else:
+        threads = list(range(1, (os.cpu_count() or 1) + 1))
+
+    compilers = {"kcc": args.kcc}
+    for name in ("clang", "gcc"):
+        path = shutil.which(getattr(args, name))
+        if path:
+            compilers[name] = path
+        else:
+            print("skip {}: not found".format(name))
+
+    source = os.path.join(args.source_dir, "test", "bench", "omp_scaling.c")
+    report = {
+        "compilers": compilers,
+        "level": args.level,
+        "runs": args.runs,
+        "warmup": args.warmup,
+        "results": {}
+    }
+
+    with tempfile.TemporaryDirectory() as work_dir:
+        for cc_name, cc in compilers.items():
+            exe = os.path.join(work_dir, "omp_scaling-" + cc_name)
+            build(cc, source, args.level, exe)
+
+            for schedule in SCHEDULES:
+                result = {}
+                for n in threads:
+                    times = run(exe, [schedule, str(args.iterations)], n,
+                                args.warmup, args.runs)
+                    result[str(n)] = {
+                        "median_s": statistics.median(times),
+                        "min_s": min(times),
+                        "times_s": times,
+                    }
+
+                # speedup and efficiency relative to the first thread count (usually 1)
+                base = result[str(threads[0])]["median_s"]
+                for n in threads:
+                    speedup = base / result[str(n)]["median_s"]
+                    result[str(n)]["speedup"] = speedup
+                    result[str(n)]["efficiency"] = speedup * threads[0] / n
+                    print("{:<6}{:<8}{:>4} threads{:>9.3f}s{:>8.2f}x".format(
+                        cc_name, schedule, n, result[str(n)]["median_s"],
+                        speedup))
+
+                report["results"].setdefault(cc_name, {})[schedule] = result
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
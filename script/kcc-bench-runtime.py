@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+#
+# Runtime benchmark of the code generated by kcc, compared with clang and gcc.
+#
+# speedtest1 (sqlite), the lua interpreter running test/lua/bench.lua and the
+# switch / threaded (computed goto) dispatch loops of test/bench/dispatch.c
+# are built by every compiler at every optimization level.  Each binary is run
+# --warmup times untimed and --runs times timed, pinned to one CPU; medians
+# and the kcc/clang and kcc/gcc ratios are written as JSON.  Typical usage:
+#
+#     script/kcc-bench-runtime.py --kcc build/tool/kcc -o runtime.json
+#     script/kcc-bench-runtime.py --kcc build/tool/kcc --baseline runtime.json
+#
+# With --baseline the exit status is 1 if the median time of any kcc-built
+# binary grew by more than --threshold compared with the baseline report.
+#
+# --kcc-baseline adds a second kcc executable as compiler "kcc-baseline",
+# e.g. one built before a pipeline change, and reports kcc/kcc-baseline.
+#
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SOURCE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def benchmarks(source_dir):
+    sqlite_dir = os.path.join(source_dir, "test", "sqlite")
+    lua_dir = os.path.join(source_dir, "test", "lua")
+    dispatch = os.path.join(source_dir, "test", "bench", "dispatch.c")
+    return {
+        "speedtest1": {
+            "sources": [
+                os.path.join(sqlite_dir, "speedtest1.c"),
+                os.path.join(sqlite_dir, "sqlite3.c")
+            ],
+            "flags": [
+                "-DNDEBUG", "-DSQLITE_ENABLE_RTREE", "-DSQLITE_ENABLE_MEMSYS5"
+            ],
+            "libs": ["-ldl", "-lpthread", "-lm"],
+            "args": [
+                "--shrink-memory", "--reprepare", "--heap", "10000000", "64",
+                "--size", "5"
+            ],
+        },
+        # without LUA_USER_H ltests.c is empty and the internal checks used by
+        # the test suite do not distort the timings
+        "lua": {
+            "sources": sorted(glob.glob(os.path.join(lua_dir, "*.c"))),
+            "flags": ["-std=gnu17", "-DLUA_USE_LINUX", "-DLUA_COMPAT_5_2"],
+            "libs": ["-ldl", "-lreadline", "-lm"],
+            "args": [os.path.join(lua_dir, "bench.lua")],
+        },
+        "dispatch-switch": {
+            "sources": [dispatch],
+            "flags": ["-std=gnu17"],
+            "libs": [],
+            "args": ["switch", "200"],
+        },
+        "dispatch-threaded": {
+            "sources": [dispatch],
+            "flags": ["-std=gnu17"],
+            "libs": [],
+            "args": ["threaded", "200"],
+        },
+    }
+
+
+def build(cc, bench, level, exe):
+    cmd = [cc] + bench["sources"] + bench["flags"] + [level, "-o", exe
+                                                      ] + bench["libs"]
+    result = subprocess.run(cmd,
+                            stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        sys.exit("failed: {}\n{}".format(" ".join(cmd),
+                                         result.stderr.decode()))
+
+
+def run(exe, args, cpu, warmup, runs, work_dir):
+    cmd = [exe] + args
+    if cpu is not None and shutil.which("taskset"):
+        cmd = ["taskset", "-c", str(cpu)] + cmd
+
+    times = []
+    for i in range(warmup + runs):
+        start = time.perf_counter()
+        subprocess.run(cmd,
+                       stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL,
+                       cwd=work_dir,
+                       check=True)
+        if i >= warmup:
+            times.append(time.perf_counter() - start)
+    return times
+
+
+def compare(report, baseline, threshold):
+    regressions = []
+    for name, levels in report["results"].items():
+        for level, result in levels.items():
+            base = baseline.get("results", {}).get(name, {}).get(level, {})
+            if "kcc" not in base or "kcc" not in result:
+                continue
+            ratio = result["kcc"]["median_s"] / base["kcc"]["median_s"]
+            status = "REGRESSION" if ratio > 1 + threshold else "ok"
+            print("{:<18}{:<4}{:>10.3f}{:>10.3f}{:>8.3f}  {}".format(
+                name, level, base["kcc"]["median_s"],
+                result["kcc"]["median_s"], ratio, status))
+            if status != "ok":
+                regressions.append((name, level))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Runtime benchmark of kcc generated code")
+    parser.add_argument("--kcc", default="kcc", help="kcc executable")
+    parser.add_argument("--kcc-baseline",
+                        help="second kcc executable to compare against")
+    parser.add_argument("--clang", default="clang")
+    parser.add_argument("--gcc", default="gcc")
+    parser.add_argument("--source-dir", default=SOURCE_DIR)
+    parser.add_argument("--levels",
+                        default="-O2,-O3",
+                        help="e.g. --levels=-O2,-O3")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--cpu",
+                        type=int,
+                        default=0,
+                        help="CPU to pin the benchmarks to (-1: no pinning)")
+    parser.add_argument("-o", "--output", default="kcc-bench-runtime.json")
+    parser.add_argument("--baseline", help="report to compare against")
+    parser.add_argument("--threshold",
+                        type=float,
+                        default=0.05,
+                        help="allowed relative slowdown (default: 0.05)")
+    args = parser.parse_args()
+
+    compilers = {"kcc": args.kcc}
+    if args.kcc_baseline:
+        compilers["kcc-baseline"] = args.kcc_baseline
+    for name in ("clang", "gcc"):
+        path = shutil.which(getattr(args, name))
+        if path:
+            compilers[name] = path
+        else:
+            print("skip {}: not found".format(name))
+
+    cpu = args.cpu if args.cpu >= 0 else None
+    report = {
+        "compilers": compilers,
+        "runs": args.runs,
+        "warmup": args.warmup,
+        "results": {}
+    }
+
+    with tempfile.TemporaryDirectory() as work_dir:
+        for name, bench in benchmarks(args.source_dir).items():
+            if not all(os.path.exists(f) for f in bench["sources"]):
+                print("skip {}: no sources".format(name))
+                continue
+
+            for level in args.levels.split(","):
+                result = {}
+                for cc_name, cc in compilers.items():
+                    exe = os.path.join(work_dir,
+                                       "{}-{}{}".format(name, cc_name, level))
+                    build(cc, bench, level, exe)
+                    times = run(exe, bench["args"], cpu, args.warmup,
+                                args.runs, work_dir)
+                    result[cc_name] = {
+                        "median_s": statistics.median(times),
+                        "min_s": min(times),
+                        "times_s": times,
+                    }
+
+                for cc_name in ("kcc-baseline", "clang", "gcc"):
+                    if cc_name in result:
+                        result["kcc/" + cc_name] = (
+                            result["kcc"]["median_s"] /
+                            result[cc_name]["median_s"])
+
+                report["results"].setdefault(name, {})[level] = result
+                print("{:<18}{:<4}".format(name, level) + "".join(
+                    "{:>13}{:>9.3f}s".format(cc_name, result[cc_name]
+                                            ["median_s"])
+                    for cc_name in compilers))
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+
+    if args.baseline:
+        if not os.path.exists(args.baseline):
+            sys.exit("no baseline: {}".format(args.baseline))
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if compare(report, baseline, args.threshold):
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
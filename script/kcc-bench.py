@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+#
+# Compile-time benchmark of kcc over the sources bundled in test/.
+#
+# Every translation unit of each corpus is compiled --runs times at each
+# optimization level; the median of the summed wall times is reported.  One
+# extra instrumented compile per file (-ftime-trace -fmem-report) provides the
+# per-phase times and the peak RSS.  Typical usage:
+#
+#     script/kcc-bench.py --kcc build/tool/kcc -o bench.json
+#     script/kcc-bench.py --kcc build/tool/kcc --baseline bench.json
+#
+# With --baseline the exit status is 1 if any wall time or peak RSS grew by
+# more than --threshold compared with the baseline report.
+#
+# --kcc-baseline times a second kcc executable on the same corpora, e.g. one
+# built before a pipeline change, and reports the wall time ratio.  Only wall
+# times are measured for it, older builds lack -ftime-trace / -fmem-report:
+#
+#     script/kcc-bench.py --kcc build/tool/kcc --kcc-baseline old/tool/kcc \
+#         --corpus sqlite --corpus lua --levels=-O2,-O3
+#
+
+import argparse
+import glob
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SOURCE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+PHASES = [
+    "Preprocessor::Cpp",
+    "Scanner::Tokenize",
+    "Parser::ParseTranslationUnit",
+    "CodeGen::GenCode",
+    "Optimization",
+    "ObjGen",
+]
+
+SQLITE_FLAGS = [
+    "-DSQLITE_DEFAULT_MEMSTATUS=0", "-DSQLITE_DQS=0",
+    "-DSQLITE_ENABLE_DBSTAT_VTAB", "-DSQLITE_ENABLE_FTS5",
+    "-DSQLITE_ENABLE_GEOPOLY", "-DSQLITE_ENABLE_JSON1", "-DSQLITE_ENABLE_RBU",
+    "-DSQLITE_ENABLE_RTREE", "-DSQLITE_LIKE_DOESNT_MATCH_BLOBS",
+    "-DSQLITE_MAX_EXPR_DEPTH=0", "-DSQLITE_OMIT_DECLTYPE",
+    "-DSQLITE_OMIT_DEPRECATED", "-DSQLITE_USE_ALLOCA",
+    "-DSQLITE_ENABLE_MEMSYS5"
+]
+
+LUA_FLAGS = [
+    "-std=gnu17", '-DLUA_USER_H="ltests.h"', "-DLUA_USE_LINUX",
+    "-DLUA_COMPAT_5_2"
+]
+
+
+def corpora(source_dir):
+    test_dir = os.path.join(source_dir, "test")
+    usual = [
+        f for f in sorted(glob.glob(os.path.join(test_dir, "usual", "*.c")))
+        if os.path.basename(f) != "testmain.c"
+    ]
+    return {
+        "sqlite": ([os.path.join(test_dir, "sqlite", "sqlite3.c")],
+                   SQLITE_FLAGS),
+        "lua": (sorted(glob.glob(os.path.join(test_dir, "lua", "*.c"))),
+                LUA_FLAGS),
+        "8cc": (sorted(glob.glob(os.path.join(test_dir, "8cc", "*.c"))), [
+            "-std=gnu17",
+            '-DBUILD_DIR="{}"'.format(os.path.join(test_dir, "8cc"))
+        ]),
+        "usual": (usual, []),
+    }
+
+
+def compile_file(kcc, src, flags, obj, extra=()):
+    cmd = [kcc, src, "-c", "-o", obj] + flags + list(extra)
+    start = time.perf_counter()
+    result = subprocess.run(cmd,
+                            stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    if result.returncode != 0:
+        sys.exit("failed: {}\n{}".format(" ".join(cmd),
+                                         result.stderr.decode()))
+    return elapsed
+
+
+def phase_times(trace_file):
+    with open(trace_file) as f:
+        events = json.load(f)["traceEvents"]
+
+    times = dict.fromkeys(PHASES, 0.0)
+    for event in events:
+        if event.get("ph") == "X" and event.get("name") in times:
+            times[event["name"]] += event["dur"] / 1000
+    return times
+
+
+def peak_rss(mem_file):
+    with open(mem_file) as f:
+        return max(p["peak_rss_kb"] for p in json.load(f)["phases"])
+
+
+def wall_times(kcc, files, flags, runs, work_dir):
+    obj = os.path.join(work_dir, "bench.o")
+    return [
+        sum(compile_file(kcc, src, flags, obj) for src in files)
+        for _ in range(runs)
+    ]
+
+
+def bench_corpus(kcc, files, flags, level, runs, work_dir):
+    flags = flags + [level]
+    obj = os.path.join(work_dir, "bench.o")
+
+    totals = wall_times(kcc, files, flags, runs, work_dir)
+
+    phases = dict.fromkeys(PHASES, 0.0)
+    rss = 0
+    for src in files:
+        compile_file(kcc, src, flags, obj, ["-ftime-trace", "-fmem-report"])
+        for name, ms in phase_times(os.path.join(work_dir,
+                                                 "bench.json")).items():
+            phases[name] += ms
+        rss = max(rss, peak_rss(os.path.join(work_dir, "bench.mem.json")))
+
+    return {
+        "files": len(files),
+        "wall_ms": statistics.median(totals) * 1000,
+        "min_ms": min(totals) * 1000,
+        "phases_ms": phases,
+        "peak_rss_kb": rss,
+    }
+
+
+def compare(report, baseline, threshold):
+    regressions = []
+    for corpus, levels in report["results"].items():
+        for level, result in levels.items():
+            base = baseline.get("results", {}).get(corpus, {}).get(level)
+            if base is None:
+                continue
+            for key in ("wall_ms", "peak_rss_kb"):
+                ratio = result[key] / base[key] if base[key] else 1.0
+                status = "REGRESSION" if ratio > 1 + threshold else "ok"
+                print("{:<8}{:<4}{:<12}{:>12.1f}{:>12.1f}{:>8.3f}  {}".format(
+                    corpus, level, key, base[key], result[key], ratio,
+                    status))
+                if status != "ok":
+                    regressions.append((corpus, level, key))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compile-time benchmark of kcc")
+    parser.add_argument("--kcc", default="kcc", help="kcc executable")
+    parser.add_argument("--kcc-baseline",
+                        help="second kcc executable to compare wall times")
+    parser.add_argument("--source-dir", default=SOURCE_DIR)
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--levels",
+                        default="-O0,-O3",
+                        help="e.g. --levels=-O0,-O3")
+    parser.add_argument("--corpus",
+                        action="append",
+                        help="sqlite, lua, 8cc or usual (default: all)")
+    parser.add_argument("-o", "--output", default="kcc-bench.json")
+    parser.add_argument("--baseline", help="report to compare against")
+    parser.add_argument("--threshold",
+                        type=float,
+                        default=0.05,
+                        help="allowed relative slowdown (default: 0.05)")
+    args = parser.parse_args()
+
+    report = {"kcc": args.kcc, "runs": args.runs, "results": {}}
+    with tempfile.TemporaryDirectory() as work_dir:
+        for corpus, (files, flags) in corpora(args.source_dir).items():
+            if args.corpus and corpus not in args.corpus:
+                continue
+            files = [f for f in files if os.path.exists(f)]
+            if not files:
+                print("skip {}: no sources".format(corpus))
+                continue
+
+            for level in args.levels.split(","):
+                result = bench_corpus(args.kcc, files, flags, level,
+                                      args.runs, work_dir)
+                report["results"].setdefault(corpus, {})[level] = result
+                print("{:<8}{:<4}{:>10.1f} ms{:>10} KB".format(
+                    corpus, level, result["wall_ms"], result["peak_rss_kb"]))
+
+                if args.kcc_baseline:
+                    times = wall_times(args.kcc_baseline, files,
+                                       flags + [level], args.runs, work_dir)
+                    result["baseline_wall_ms"] = (statistics.median(times) *
+                                                  1000)
+                    result["wall_ratio"] = (result["wall_ms"] /
+                                            result["baseline_wall_ms"])
+                    print("{:<8}{:<4}{:>10.1f} ms baseline{:>8.3f}".format(
+                        corpus, level, result["baseline_wall_ms"],
+                        result["wall_ratio"]))
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+
+    if args.baseline:
+        if not os.path.exists(args.baseline):
+            sys.exit("no baseline: {}".format(args.baseline))
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if compare(report, baseline, args.threshold):
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
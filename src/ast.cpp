@@ -8,6 +8,7 @@
 
 #include <magic_enum.hpp>
 
+#include "calc.h"
 #include "error.h"
 #include "llvm_common.h"
 #include "memory_pool.h"
@@ -174,6 +175,11 @@ void UnaryOpExpr::IncDecOpCheck() {
 }
 
 void UnaryOpExpr::UnaryAddSubOpCheck() {
+  if (expr_->GetType()->IsVectorTy()) {
+    type_ = expr_->GetQualType();
+    return;
+  }
+
   if (!expr_->GetType()->IsArithmeticTy()) {
     Error(this, "expect operand of arithmetic type");
   }
@@ -187,6 +193,15 @@ void UnaryOpExpr::UnaryAddSubOpCheck() {
 }
 
 void UnaryOpExpr::NotOpCheck() {
+  if (auto type{expr_->GetType()}; type->IsVectorTy()) {
+    if (!type->VectorGetElementType()->IsIntegerTy()) {
+      Error(this, "expect operand of integer vector type");
+    }
+
+    type_ = expr_->GetQualType();
+    return;
+  }
+
   if (!expr_->GetType()->IsIntegerTy()) {
     Error(this, "expect operand of arithmetic type");
   }
@@ -234,6 +249,23 @@ AstNodeType TypeCastExpr::Kind() const { return AstNodeType::kTypeCastExpr; }
 void TypeCastExpr::Accept(Visitor &visitor) const { visitor.Visit(this); }
 
 void TypeCastExpr::Check() {
+  // 向量之间的转换是按位的, 要求大小相同
+  // 标量转换为向量时会复制到每个元素
+  if (type_->IsVectorTy() && expr_->GetType()->IsVectorTy()) {
+    if (type_->GetWidth() != expr_->GetType()->GetWidth()) {
+      Error(loc_, "cannot cast between vectors of different size: '{}' to '{}'",
+            expr_->GetQualType().ToString(), type_.ToString());
+    }
+  } else if (type_->IsVectorTy()) {
+    if (!expr_->GetType()->IsArithmeticTy()) {
+      Error(loc_, "cannot cast '{}' to vector type '{}'",
+            expr_->GetQualType().ToString(), type_.ToString());
+    }
+  } else if (expr_->GetType()->IsVectorTy() && !type_->IsVoidTy()) {
+    Error(loc_, "cannot cast vector type '{}' to '{}'",
+          expr_->GetQualType().ToString(), type_.ToString());
+  }
+
   if (type_->IsFloatPointTy() && expr_->GetType()->IsPointerTy()) {
     Error(loc_, "cannot cast a pointer to float point ('{}' to '{}')",
           expr_->GetQualType().ToString(), type_.ToString());
@@ -264,6 +296,14 @@ AstNodeType BinaryOpExpr::Kind() const { return AstNodeType::kBinaryOpExpr; }
 void BinaryOpExpr::Accept(Visitor &visitor) const { visitor.Visit(this); }
 
 void BinaryOpExpr::Check() {
+  if (op_ != Tag::kEqual && op_ != Tag::kPeriod && op_ != Tag::kComma &&
+      op_ != Tag::kAmpAmp && op_ != Tag::kPipePipe &&
+      op_ != Tag::kLeftSquare &&
+      (lhs_->GetType()->IsVectorTy() || rhs_->GetType()->IsVectorTy())) {
+    VectorOpCheck();
+    return;
+  }
+
   switch (op_) {
     case Tag::kEqual:
       AssignOpCheck();
@@ -308,6 +348,9 @@ void BinaryOpExpr::Check() {
     case Tag::kComma:
       CommaOpCheck();
       break;
+    case Tag::kLeftSquare:
+      VectorIndexOpCheck();
+      break;
     default:
       assert(false);
   }
@@ -357,6 +400,10 @@ void BinaryOpExpr::AssignOpCheck() {
     if (!Expr::IsZero(rhs_)) {
       Error(this, "must be pointer and zero");
     }
+  } else if ((lhs_type->IsVectorTy() || rhs_type->IsVectorTy()) &&
+             !lhs_type->Equal(rhs_type.GetType())) {
+    Error(this, "assigning to '{}' from incompatible type '{}'",
+          lhs_type.ToString(), rhs_type.ToString());
   }
 
   rhs_ = Expr::MayCastTo(rhs_, lhs_type);
@@ -502,7 +549,97 @@ void BinaryOpExpr::RelationalOpCheck() {
 
 void BinaryOpExpr::MemberRefOpCheck() { type_ = rhs_->GetQualType(); }
 
-void BinaryOpExpr::CommaOpCheck() { type_ = rhs_->GetQualType(); }
+// 逗号运算符的结果不是左值, 丢弃限定符
+void BinaryOpExpr::CommaOpCheck() { type_ = rhs_->GetType(); }
+
+// 非左值向量的下标访问, 结果是元素的值
+void BinaryOpExpr::VectorIndexOpCheck() {
+  if (!rhs_->GetType()->IsIntegerTy()) {
+    Error(this, "array subscript is not an integer");
+  }
+
+  type_ = lhs_->GetType()->VectorGetElementType().GetType();
+}
+
+// GCC 向量扩展, 运算按元素进行
+// 另一个运算对象是标量时, 先转换为元素类型, 再复制到每个元素
+// 比较运算的结果是元素宽度相同的有符号整数向量, 真为 -1, 假为 0
+void BinaryOpExpr::VectorOpCheck() {
+  auto lhs_type{lhs_->GetType()};
+  auto rhs_type{rhs_->GetType()};
+
+  if (!lhs_type->IsVectorTy()) {
+    if (!lhs_type->IsArithmeticTy()) {
+      Error(this, "invalid operands to binary expression ('{}' and '{}')",
+            lhs_type->ToString(), rhs_type->ToString());
+    }
+    lhs_ = Expr::MayCastTo(
+        Expr::MayCastTo(lhs_, rhs_type->VectorGetElementType()), rhs_type);
+    lhs_type = rhs_type;
+  } else if (!rhs_type->IsVectorTy()) {
+    if (!rhs_type->IsArithmeticTy()) {
+      Error(this, "invalid operands to binary expression ('{}' and '{}')",
+            lhs_type->ToString(), rhs_type->ToString());
+    }
+    rhs_ = Expr::MayCastTo(
+        Expr::MayCastTo(rhs_, lhs_type->VectorGetElementType()), lhs_type);
+    rhs_type = lhs_type;
+  } else if (!lhs_type->Equal(rhs_type)) {
+    Error(this, "cannot convert between vector types '{}' and '{}'",
+          lhs_type->ToString(), rhs_type->ToString());
+  }
+
+  auto element_type{lhs_type->VectorGetElementType()};
+
+  switch (op_) {
+    case Tag::kPlus:
+    case Tag::kMinus:
+    case Tag::kStar:
+    case Tag::kSlash:
+      type_ = lhs_type;
+      break;
+    case Tag::kPercent:
+    case Tag::kAmp:
+    case Tag::kPipe:
+    case Tag::kCaret:
+    case Tag::kLessLess:
+    case Tag::kGreaterGreater:
+      if (!element_type->IsIntegerTy()) {
+        Error(this, "the operand should be integer vector type");
+      }
+      type_ = lhs_type;
+      break;
+    case Tag::kEqualEqual:
+    case Tag::kExclaimEqual:
+    case Tag::kLess:
+    case Tag::kLessEqual:
+    case Tag::kGreater:
+    case Tag::kGreaterEqual: {
+      std::uint32_t type_spec{};
+      switch (element_type->GetWidth()) {
+        case 1:
+          type_spec = kChar;
+          break;
+        case 2:
+          type_spec = kShort;
+          break;
+        case 4:
+          type_spec = kInt;
+          break;
+        case 8:
+          type_spec = kLong;
+          break;
+        default:
+          assert(false);
+      }
+      type_ = VectorType::Get(ArithmeticType::Get(type_spec),
+                              lhs_type->VectorGetNumElements());
+      break;
+    }
+    default:
+      assert(false);
+  }
+}
 
 /*
  * ConditionOpExpr
@@ -535,6 +672,12 @@ void ConditionOpExpr::Check() {
             lhs_type.ToString(), rhs_type.ToString());
     }
     type_ = lhs_type;
+  } else if (lhs_type->IsVectorTy() && rhs_type->IsVectorTy()) {
+    if (!lhs_type->Equal(rhs_type.GetType())) {
+      Error(loc_, "Must have the same vector type: '{}' vs '{}'",
+            lhs_type.ToString(), rhs_type.ToString());
+    }
+    type_ = lhs_type;
   } else if (lhs_type->IsPointerTy() && rhs_type->IsPointerTy()) {
     // 这里放松了限制
     if (lhs_type->PointerGetElementType()->IsVoidTy()) {
@@ -604,6 +747,24 @@ void FuncCallExpr::Check() {
   }
 
   auto func_type{callee_->GetType()};
+  if (AtomicBuiltins.count(func_type->FuncGetName())) {
+    AtomicBuiltinCheck(func_type->FuncGetName());
+    return;
+  } else if (OverflowBuiltins.count(func_type->FuncGetName())) {
+    OverflowBuiltinCheck(func_type->FuncGetName());
+    return;
+  } else if (func_type->FuncGetName() == "__builtin_shufflevector") {
+    ShuffleVectorBuiltinCheck();
+    return;
+  } else if (func_type->FuncGetName() == "__builtin_shuffle") {
+    ShuffleBuiltinCheck();
+    return;
+  } else if (func_type->FuncGetName() == "__builtin_constant_p" &&
+             std::size(args_) != 1) {
+    Error(loc_, "'__builtin_constant_p' expects 1 argument but got {}",
+          std::size(args_));
+  }
+
   auto args_iter{std::begin(args_)};
 
   for (const auto &param : callee_->GetType()->FuncGetParams()) {
@@ -658,6 +819,163 @@ Type *FuncCallExpr::GetVaArgType() const { return va_arg_type_; }
 FuncCallExpr::FuncCallExpr(Expr *callee, std::vector<Expr *> args)
     : callee_{callee}, args_{std::move(args)} {}
 
+void FuncCallExpr::AtomicBuiltinCheck(const std::string &name) {
+  const auto &[params, ret]{AtomicBuiltins.at(name)};
+
+  if (std::size(args_) != std::size(params)) {
+    Error(loc_, "'{}' expects {} arguments but got {}", name, std::size(params),
+          std::size(args_));
+  }
+
+  args_.front() = Expr::MayCast(args_.front());
+  auto ptr_type{args_.front()->GetQualType()};
+  if (!ptr_type->IsPointerTy()) {
+    Error(args_.front(), "'{}' expects a pointer but got '{}'", name,
+          ptr_type.ToString());
+  }
+
+  // 去掉 _Atomic 等限定
+  // 与 _Atomic 相同, 超过 8 字节的类型需要 libatomic, 不支持
+  auto type{QualType{ptr_type->PointerGetElementType().GetType()}};
+  if (!type->IsScalarTy() || type->IsLongDoubleTy() || type->GetWidth() > 8) {
+    Error(args_.front(), "'{}': Does not support atomic operation on '{}'",
+          name, type.ToString());
+  }
+  if (name.find("fetch") != std::string::npos && type->IsFloatPointTy()) {
+    Error(args_.front(), "'{}' expects an integer or pointer but got '{}'",
+          name, type.ToString());
+  }
+
+  for (std::size_t i{1}; i < std::size(params); ++i) {
+    auto &arg{args_[i]};
+
+    switch (params[i]) {
+      case 'v':
+        arg = Expr::MayCastTo(arg, type);
+        break;
+      case 'P':
+        arg = Expr::MayCast(arg);
+        if (!arg->GetType()->IsPointerTy() ||
+            !arg->GetType()->PointerGetElementType()->Compatible(
+                type.GetType())) {
+          Error(arg, "'{}' expects '{}' but got '{}'", name,
+                type->GetPointerTo()->ToString(),
+                arg->GetQualType().ToString());
+        }
+        break;
+      case 'b':
+        arg = Expr::MayCastTo(arg, ArithmeticType::Get(kBool));
+        break;
+      case 'i':
+        arg = Expr::MayCastTo(arg, ArithmeticType::Get(kInt));
+        break;
+      default:
+        assert(false);
+    }
+  }
+
+  switch (ret) {
+    case 'v':
+      type_ = type;
+      break;
+    case 'b':
+      type_ = ArithmeticType::Get(kBool);
+      break;
+    case '0':
+      type_ = VoidType::Get();
+      break;
+    default:
+      assert(false);
+  }
+}
+
+void FuncCallExpr::OverflowBuiltinCheck(const std::string &name) {
+  if (std::size(args_) != 3) {
+    Error(loc_, "'{}' expects 3 arguments but got {}", name, std::size(args_));
+  }
+
+  for (std::size_t i{0}; i < 2; ++i) {
+    args_[i] = Expr::MayCast(args_[i]);
+    if (!args_[i]->GetType()->IsIntegerTy()) {
+      Error(args_[i], "'{}' expects an integer but got '{}'", name,
+            args_[i]->GetQualType().ToString());
+    }
+  }
+
+  args_[2] = Expr::MayCast(args_[2]);
+  auto ptr_type{args_[2]->GetQualType()};
+  if (!ptr_type->IsPointerTy() ||
+      !ptr_type->PointerGetElementType()->IsIntegerTy() ||
+      ptr_type->PointerGetElementType()->IsBoolTy() ||
+      ptr_type->PointerGetElementType().IsConst()) {
+    Error(args_[2], "'{}' expects a pointer to integer but got '{}'", name,
+          ptr_type.ToString());
+  }
+
+  type_ = ArithmeticType::Get(kBool);
+}
+
+// __builtin_shufflevector(v1, v2, index...)
+// 结果的元素个数等于下标的个数, 下标是常量, -1 表示未定义
+void FuncCallExpr::ShuffleVectorBuiltinCheck() {
+  if (std::size(args_) < 3) {
+    Error(loc_, "'__builtin_shufflevector' expects at least 3 arguments");
+  }
+
+  auto type{args_[0]->GetType()};
+  if (!type->IsVectorTy() || !type->Equal(args_[1]->GetType())) {
+    Error(loc_, "expect two vectors of the same type: '{}' and '{}'",
+          args_[0]->GetQualType().ToString(),
+          args_[1]->GetQualType().ToString());
+  }
+
+  auto limit{2 * static_cast<std::int64_t>(type->VectorGetNumElements())};
+  for (std::size_t i{2}; i < std::size(args_); ++i) {
+    auto index{CalcConstantExpr{}.CalcInteger(args_[i])};
+    if (*index < -1 || *index >= limit) {
+      Error(args_[i], "index must be -1 or in the range [0, {})", limit);
+    }
+  }
+
+  auto num_elements{std::size(args_) - 2};
+  if (num_elements & (num_elements - 1)) {
+    Error(loc_, "number of indices must be a power of two");
+  }
+
+  type_ = VectorType::Get(type->VectorGetElementType().GetType(), num_elements);
+}
+
+// __builtin_shuffle(v, mask) / __builtin_shuffle(v1, v2, mask)
+// mask 是元素个数和宽度都相同的整数向量, 下标按元素个数 (或其两倍) 取模
+void FuncCallExpr::ShuffleBuiltinCheck() {
+  if (std::size(args_) != 2 && std::size(args_) != 3) {
+    Error(loc_, "'__builtin_shuffle' expects 2 or 3 arguments but got {}",
+          std::size(args_));
+  }
+
+  auto type{args_[0]->GetType()};
+  if (!type->IsVectorTy()) {
+    Error(args_[0], "'__builtin_shuffle' expects a vector but got '{}'",
+          args_[0]->GetQualType().ToString());
+  }
+  if (std::size(args_) == 3 && !type->Equal(args_[1]->GetType())) {
+    Error(loc_, "expect two vectors of the same type: '{}' and '{}'",
+          args_[0]->GetQualType().ToString(),
+          args_[1]->GetQualType().ToString());
+  }
+
+  auto mask_type{args_.back()->GetType()};
+  if (!mask_type->IsVectorTy() ||
+      !mask_type->VectorGetElementType()->IsIntegerTy() ||
+      mask_type->VectorGetNumElements() != type->VectorGetNumElements() ||
+      mask_type->GetWidth() != type->GetWidth()) {
+    Error(args_.back(), "invalid mask type: '{}'",
+          args_.back()->GetQualType().ToString());
+  }
+
+  type_ = type;
+}
+
 /*
  * Constant
  */
@@ -821,6 +1139,26 @@ const std::string &IdentifierExpr::GetName() const { return name_; }
 
 bool IdentifierExpr::IsTypeName() const { return is_type_name_; }
 
+void IdentifierExpr::SetAsmLabel(const std::string &asm_label) {
+  asm_label_ = asm_label;
+}
+
+const std::string &IdentifierExpr::GetAsmLabel() const { return asm_label_; }
+
+std::string IdentifierExpr::GetLinkName() const {
+  if (std::empty(asm_label_)) {
+    return name_;
+  }
+
+  // 汇编标签即为最终的符号名, 在有全局前缀的平台上(如 Mach-O 的 _)
+  // 使用 \1 阻止 LLVM 再添加前缀
+  if (Module->getDataLayout().getGlobalPrefix()) {
+    return "\1" + asm_label_;
+  } else {
+    return asm_label_;
+  }
+}
+
 bool IdentifierExpr::IsObject() const {
   return dynamic_cast<const ObjectExpr *>(this);
 }
@@ -909,12 +1247,14 @@ bool ObjectExpr::IsLocalStaticVar() const {
   return linkage_ == Linkage::kNone && IsStatic();
 }
 
-void ObjectExpr::SetLocalPtr(llvm::AllocaInst *local_ptr) {
+void ObjectExpr::SetLocalPtr(llvm::Value *local_ptr) {
   assert(local_ptr_ == nullptr);
   local_ptr_ = local_ptr;
 }
 
-llvm::AllocaInst *ObjectExpr::GetLocalPtr() const {
+bool ObjectExpr::HasLocalPtr() const { return local_ptr_ != nullptr; }
+
+llvm::Value *ObjectExpr::GetLocalPtr() const {
   assert(local_ptr_ != nullptr);
   return local_ptr_;
 }
@@ -932,7 +1272,8 @@ llvm::GlobalVariable *ObjectExpr::GetGlobalPtr() const {
     return ptr;
   } else if (IsLocalStaticVar()) {
     assert(!std::empty(func_name_));
-    auto name{func_name_ + "." + name_};
+    auto name{std::empty(asm_label_) ? func_name_ + "." + name_
+                                     : GetLinkName()};
 
     if (auto iter{GlobalVarMap.find(name)}; iter != std::end(GlobalVarMap)) {
       ptr = iter->second;
@@ -1028,6 +1369,41 @@ const CompoundStmt *StmtExpr::GetBlock() const { return block_; }
 
 StmtExpr::StmtExpr(CompoundStmt *block) : block_{block} {}
 
+/*
+ * LabelAddrExpr
+ */
+LabelAddrExpr *LabelAddrExpr::Get(const std::string &name) {
+  return new (LabelAddrExprPool.malloc()) LabelAddrExpr{name};
+}
+
+AstNodeType LabelAddrExpr::Kind() const { return AstNodeType::kLabelAddrExpr; }
+
+void LabelAddrExpr::Accept(Visitor &visitor) const { visitor.Visit(this); }
+
+void LabelAddrExpr::Check() { type_ = PointerType::Get(VoidType::Get()); }
+
+bool LabelAddrExpr::IsLValue() const { return false; }
+
+const std::string &LabelAddrExpr::GetName() const { return name_; }
+
+const LabelStmt *LabelAddrExpr::GetLabel() const { return label_; }
+
+void LabelAddrExpr::SetLabel(LabelStmt *label) { label_ = label; }
+
+llvm::GlobalVariable *LabelAddrExpr::GetPlaceholder() const {
+  if (!placeholder_) {
+    placeholder_ = new llvm::GlobalVariable(
+        *Module, Builder.getInt8Ty(), true,
+        llvm::GlobalValue::ExternalLinkage, nullptr, "label.addr." + name_);
+  }
+
+  return placeholder_;
+}
+
+bool LabelAddrExpr::HasPlaceholder() const { return placeholder_ != nullptr; }
+
+LabelAddrExpr::LabelAddrExpr(const std::string &name) : name_{name} {}
+
 /*
  * Stmt
  */
@@ -1136,6 +1512,10 @@ void CompoundStmt::AddStmt(Stmt *stmt) {
   }
 }
 
+void CompoundStmt::SetHasVLA() { has_vla_ = true; }
+
+bool CompoundStmt::HasVLA() const { return has_vla_; }
+
 CompoundStmt::CompoundStmt(std::vector<Stmt *> stmts)
     : stmts_{std::move(stmts)} {}
 
@@ -1222,9 +1602,9 @@ SwitchStmt::SwitchStmt(Expr *cond, Stmt *block) : cond_{cond}, stmt_{block} {}
 /*
  * WhileStmt
  */
-WhileStmt *WhileStmt::Get(Expr *cond, Stmt *block) {
+WhileStmt *WhileStmt::Get(Expr *cond, Stmt *block, const LoopHints &hints) {
   assert(cond != nullptr && block != nullptr);
-  return new (WhileStmtPool.malloc()) WhileStmt{cond, block};
+  return new (WhileStmtPool.malloc()) WhileStmt{cond, block, hints};
 }
 
 AstNodeType WhileStmt::Kind() const { return AstNodeType::kWhileStmt; }
@@ -1244,15 +1624,18 @@ const Expr *WhileStmt::GetCond() const { return cond_; }
 
 const Stmt *WhileStmt::GetBlock() const { return block_; }
 
-WhileStmt::WhileStmt(Expr *cond, Stmt *block)
-    : cond_{Expr::MayCast(cond)}, block_{block} {}
+const LoopHints &WhileStmt::GetLoopHints() const { return hints_; }
+
+WhileStmt::WhileStmt(Expr *cond, Stmt *block, const LoopHints &hints)
+    : cond_{Expr::MayCast(cond)}, block_{block}, hints_{hints} {}
 
 /*
  * DoWhileStmt
  */
-DoWhileStmt *DoWhileStmt::Get(Expr *cond, Stmt *block) {
+DoWhileStmt *DoWhileStmt::Get(Expr *cond, Stmt *block,
+                              const LoopHints &hints) {
   assert(cond != nullptr && block != nullptr);
-  return new (DoWhileStmtPool.malloc()) DoWhileStmt{cond, block};
+  return new (DoWhileStmtPool.malloc()) DoWhileStmt{cond, block, hints};
 }
 
 AstNodeType DoWhileStmt::Kind() const { return AstNodeType::kDoWhileStmt; }
@@ -1272,15 +1655,18 @@ const Expr *DoWhileStmt::GetCond() const { return cond_; }
 
 const Stmt *DoWhileStmt::GetBlock() const { return block_; }
 
-DoWhileStmt::DoWhileStmt(Expr *cond, Stmt *block)
-    : cond_{Expr::MayCast(cond)}, block_{block} {}
+const LoopHints &DoWhileStmt::GetLoopHints() const { return hints_; }
+
+DoWhileStmt::DoWhileStmt(Expr *cond, Stmt *block, const LoopHints &hints)
+    : cond_{Expr::MayCast(cond)}, block_{block}, hints_{hints} {}
 
 /*
  * ForStmt
  */
 ForStmt *ForStmt::Get(Expr *init, Expr *cond, Expr *inc, Stmt *block,
-                      Stmt *decl) {
-  return new (ForStmtPool.malloc()) ForStmt{init, cond, inc, block, decl};
+                      Stmt *decl, const LoopHints &hints) {
+  return new (ForStmtPool.malloc())
+      ForStmt{init, cond, inc, block, decl, hints};
 }
 
 AstNodeType ForStmt::Kind() const { return AstNodeType::kForStmt; }
@@ -1306,8 +1692,16 @@ const Stmt *ForStmt::GetBlock() const { return block_; }
 
 const Stmt *ForStmt::GetDecl() const { return decl_; }
 
-ForStmt::ForStmt(Expr *init, Expr *cond, Expr *inc, Stmt *block, Stmt *decl)
-    : init_{init}, cond_{cond}, inc_{inc}, block_{block}, decl_{decl} {}
+const LoopHints &ForStmt::GetLoopHints() const { return hints_; }
+
+ForStmt::ForStmt(Expr *init, Expr *cond, Expr *inc, Stmt *block, Stmt *decl,
+                 const LoopHints &hints)
+    : init_{init},
+      cond_{cond},
+      inc_{inc},
+      block_{block},
+      decl_{decl},
+      hints_{hints} {}
 
 /*
  * GotoStmt
@@ -1316,6 +1710,11 @@ GotoStmt *GotoStmt::Get(const std::string &name) {
   return new (GotoStmtPool.malloc()) GotoStmt{name};
 }
 
+GotoStmt *GotoStmt::Get(Expr *expr) {
+  assert(expr != nullptr);
+  return new (GotoStmtPool.malloc()) GotoStmt{expr};
+}
+
 GotoStmt *GotoStmt::Get(LabelStmt *label) {
   assert(label != nullptr);
   return new (GotoStmtPool.malloc()) GotoStmt{label};
@@ -1325,7 +1724,12 @@ AstNodeType GotoStmt::Kind() const { return AstNodeType::kGotoStmt; }
 
 void GotoStmt::Accept(Visitor &visitor) const { visitor.Visit(this); }
 
-void GotoStmt::Check() {}
+void GotoStmt::Check() {
+  if (expr_ && !expr_->GetType()->IsPointerTy()) {
+    Error(expr_, "indirect goto requires a pointer operand, not '{}'",
+          expr_->GetQualType().ToString());
+  }
+}
 
 const LabelStmt *GotoStmt::GetLabel() const { return label_; }
 
@@ -1337,6 +1741,10 @@ GotoStmt::GotoStmt(const std::string &name) : name_{name} {}
 
 GotoStmt::GotoStmt(LabelStmt *label) : label_{label} {}
 
+GotoStmt::GotoStmt(Expr *expr) : expr_{expr} {}
+
+const Expr *GotoStmt::GetExpr() const { return expr_; }
+
 /*
  * ContinueStmt
  */
@@ -1364,19 +1772,358 @@ void BreakStmt::Check() {}
 /*
  * ReturnStmt
  */
-ReturnStmt *ReturnStmt::Get(Expr *expr) {
-  return new (ReturnStmtPool.malloc()) ReturnStmt{expr};
+ReturnStmt *ReturnStmt::Get(Expr *expr, Type *func_type, bool must_tail) {
+  return new (ReturnStmtPool.malloc()) ReturnStmt{expr, func_type, must_tail};
 }
 
 AstNodeType ReturnStmt::Kind() const { return AstNodeType::kReturnStmt; }
 
 void ReturnStmt::Accept(Visitor &visitor) const { visitor.Visit(this); }
 
-void ReturnStmt::Check() {}
+// musttail 要求调用者与被调用者的签名相同, 且返回值就是调用的结果
+void ReturnStmt::Check() {
+  if (!must_tail_) {
+    return;
+  }
+
+  auto call{dynamic_cast<const FuncCallExpr *>(expr_)};
+  if (!call) {
+    Error(loc_,
+          "'musttail' attribute requires that the return value is the result "
+          "of a function call");
+  }
+
+  assert(func_type_ != nullptr);
+  auto callee_type{call->GetFuncType()};
+  if (!callee_type->Equal(func_type_) ||
+      callee_type->FuncIsVarArgs() != func_type_->FuncIsVarArgs()) {
+    Error(loc_,
+          "cannot perform a tail call to function with type '{}' from '{}', "
+          "the signatures are incompatible",
+          callee_type->ToString(), func_type_->ToString());
+  }
+
+  // 结构体 / 联合体通过内存返回, 调用的结果不能直接 ret
+  if (func_type_->FuncGetReturnType()->IsStructOrUnionTy()) {
+    Error(loc_,
+          "'musttail' attribute is not supported on functions returning a "
+          "struct or union");
+  }
+}
 
 const Expr *ReturnStmt::GetExpr() const { return expr_; }
 
-ReturnStmt::ReturnStmt(Expr *expr) : expr_{expr} {}
+bool ReturnStmt::IsMustTail() const { return must_tail_; }
+
+ReturnStmt::ReturnStmt(Expr *expr, Type *func_type, bool must_tail)
+    : expr_{expr}, func_type_{func_type}, must_tail_{must_tail} {}
+
+/*
+ * AsmStmt
+ */
+AsmStmt *AsmStmt::Get(const std::string &asm_str, bool is_volatile,
+                      std::vector<Operand> outputs,
+                      std::vector<Operand> inputs,
+                      std::vector<std::string> clobbers,
+                      std::vector<GotoStmt *> labels) {
+  return new (AsmStmtPool.malloc())
+      AsmStmt{asm_str,           is_volatile,         std::move(outputs),
+              std::move(inputs), std::move(clobbers), std::move(labels)};
+}
+
+AstNodeType AsmStmt::Kind() const { return AstNodeType::kAsmStmt; }
+
+void AsmStmt::Accept(Visitor &visitor) const { visitor.Visit(this); }
+
+void AsmStmt::Check() {
+  auto is_bit_field{[](const Expr *expr) {
+    auto binary{dynamic_cast<const BinaryOpExpr *>(expr)};
+    if (!binary || binary->GetOp() != Tag::kPeriod) {
+      return false;
+    }
+    auto obj{dynamic_cast<const ObjectExpr *>(binary->GetRHS())};
+    return obj && obj->GetBitFieldWidth() != 0;
+  }};
+  auto in_register{[](const Expr *expr) {
+    return expr->GetType()->IsScalarTy() || expr->GetType()->IsVectorTy();
+  }};
+
+  std::vector<clang::TargetInfo::ConstraintInfo> output_infos;
+
+  for (const auto &[name, constraint, expr] : outputs_) {
+    clang::TargetInfo::ConstraintInfo info{constraint, name};
+    if (!TargetInfo->validateOutputConstraint(info)) {
+      Error(expr, "invalid output constraint '{}' in asm", constraint);
+    }
+
+    if (expr->IsConst()) {
+      Error(expr,
+            "cannot assign to something with const-qualified type '{}'",
+            expr->GetQualType().ToString());
+    } else if (!expr->IsLValue() || is_bit_field(expr)) {
+      Error(expr, "invalid lvalue in asm output");
+    } else if (!info.allowsMemory() && !in_register(expr)) {
+      Error(expr, "impossible constraint '{}' in asm for type '{}'",
+            constraint, expr->GetQualType().ToString());
+    }
+
+    output_infos.push_back(info);
+  }
+
+  for (auto &[name, constraint, expr] : inputs_) {
+    clang::TargetInfo::ConstraintInfo info{constraint, name};
+    if (!TargetInfo->validateInputConstraint(output_infos, info)) {
+      Error(expr, "invalid input constraint '{}' in asm", constraint);
+    }
+
+    if (info.requiresImmediateConstant() && !info.allowsRegister()) {
+      if (!CalcConstantExpr{}.CalcInteger(expr, false)) {
+        Error(expr, "constraint '{}' expects an integer constant expression",
+              constraint);
+      }
+    } else if (info.allowsMemory() && !info.allowsRegister()) {
+      // 只能使用内存的操作数需要取地址, 因此必须是左值
+      if (!expr->IsLValue() || is_bit_field(expr)) {
+        Error(expr, "invalid lvalue in asm input for constraint '{}'",
+              constraint);
+      }
+    } else {
+      expr = Expr::MayCast(expr);
+
+      if (!in_register(expr) &&
+          (!info.allowsMemory() || !expr->IsLValue())) {
+        Error(expr, "impossible constraint '{}' in asm for type '{}'",
+              constraint, expr->GetQualType().ToString());
+      }
+    }
+  }
+
+  for (const auto &item : clobbers_) {
+    if (item != "memory" && item != "cc" &&
+        !TargetInfo->isValidGCCRegisterName(item)) {
+      Error(loc_, "unknown register name '{}' in asm", item);
+    }
+  }
+}
+
+const std::string &AsmStmt::GetAsmString() const { return asm_str_; }
+
+bool AsmStmt::IsVolatile() const { return is_volatile_; }
+
+bool AsmStmt::IsAsmGoto() const { return !std::empty(labels_); }
+
+const std::vector<AsmStmt::Operand> &AsmStmt::GetOutputs() const {
+  return outputs_;
+}
+
+const std::vector<AsmStmt::Operand> &AsmStmt::GetInputs() const {
+  return inputs_;
+}
+
+const std::vector<std::string> &AsmStmt::GetClobbers() const {
+  return clobbers_;
+}
+
+const std::vector<GotoStmt *> &AsmStmt::GetLabels() const { return labels_; }
+
+AsmStmt::AsmStmt(const std::string &asm_str, bool is_volatile,
+                 std::vector<Operand> outputs, std::vector<Operand> inputs,
+                 std::vector<std::string> clobbers,
+                 std::vector<GotoStmt *> labels)
+    : asm_str_{asm_str},
+      is_volatile_{is_volatile},
+      outputs_{std::move(outputs)},
+      inputs_{std::move(inputs)},
+      clobbers_{std::move(clobbers)},
+      labels_{std::move(labels)} {}
+
+/*
+ * OmpStmt
+ */
+OmpStmt *OmpStmt::Get(Directive directive, const Clauses &clauses,
+                      Stmt *block) {
+  return new (OmpStmtPool.malloc()) OmpStmt{directive, clauses, block};
+}
+
+AstNodeType OmpStmt::Kind() const { return AstNodeType::kOmpStmt; }
+
+void OmpStmt::Accept(Visitor &visitor) const { visitor.Visit(this); }
+
+void OmpStmt::Check() {
+  if (auto num_threads{clauses_.num_threads};
+      num_threads && !num_threads->GetType()->IsIntegerTy()) {
+    Error(num_threads, "expression must have integral type");
+  }
+  if (auto chunk_size{clauses_.chunk_size};
+      chunk_size && !chunk_size->GetType()->IsIntegerTy()) {
+    Error(chunk_size, "expression must have integral type");
+  }
+
+  for (const auto &[op, obj] : clauses_.reductions) {
+    auto type{obj->GetType()};
+    if (!type->IsArithmeticTy()) {
+      Error(loc_, "variable '{}' of type '{}' can not be used in reduction",
+            obj->GetName(), obj->GetQualType().ToString());
+    }
+    if ((op == "&" || op == "|" || op == "^") && !type->IsIntegerTy()) {
+      Error(loc_, "reduction operator '{}' requires integral type", op);
+    }
+  }
+
+  for (const auto &obj : clauses_.privates) {
+    if (obj->GetType()->IsVLATy()) {
+      Error(loc_, "variable length array '{}' can not be private",
+            obj->GetName());
+    }
+  }
+
+  if (directive_ == Directive::kFor || directive_ == Directive::kParallelFor) {
+    CheckLoop();
+  }
+}
+
+std::vector<Stmt *> OmpStmt::Children() const {
+  if (block_) {
+    return {block_};
+  } else {
+    return {};
+  }
+}
+
+OmpStmt::Directive OmpStmt::GetDirective() const { return directive_; }
+
+const OmpStmt::Clauses &OmpStmt::GetClauses() const { return clauses_; }
+
+const Stmt *OmpStmt::GetBlock() const { return block_; }
+
+const ForStmt *OmpStmt::GetLoop() const {
+  return dynamic_cast<const ForStmt *>(block_);
+}
+
+ObjectExpr *OmpStmt::GetIterVar() const { return iter_var_; }
+
+const Expr *OmpStmt::GetLowerBound() const { return lower_bound_; }
+
+const Expr *OmpStmt::GetUpperBound() const { return upper_bound_; }
+
+Tag OmpStmt::GetCondOp() const { return cond_op_; }
+
+const Expr *OmpStmt::GetStep() const { return step_; }
+
+bool OmpStmt::IsDecrement() const { return is_decrement_; }
+
+OmpStmt::OmpStmt(Directive directive, const Clauses &clauses, Stmt *block)
+    : directive_{directive}, clauses_{clauses}, block_{block} {}
+
+// 参考 clang 的 Sema::ActOnOpenMPLoopInitialization 等
+void OmpStmt::CheckLoop() {
+  // 去掉隐式的类型转换
+  auto strip{[](const Expr *expr) {
+    while (expr->Kind() == AstNodeType::kTypeCastExpr) {
+      expr = dynamic_cast<const TypeCastExpr *>(expr)->GetExpr();
+    }
+    return expr;
+  }};
+  auto as_binary{[&](const Expr *expr) {
+    return dynamic_cast<const BinaryOpExpr *>(strip(expr));
+  }};
+
+  auto loop{GetLoop()};
+  assert(loop != nullptr);
+
+  // int i = lb / i = lb
+  if (auto decl{dynamic_cast<const CompoundStmt *>(loop->GetDecl())};
+      decl && std::size(decl->GetStmts()) == 1) {
+    auto item{dynamic_cast<const Declaration *>(decl->GetStmts().front())};
+    if (item && item->IsObjDecl() && item->HasLocalInit() &&
+        std::size(item->GetLocalInits()) == 1) {
+      iter_var_ = item->GetObject();
+      lower_bound_ = item->GetLocalInits().front().GetExpr();
+    }
+  } else if (auto init{loop->GetInit() ? as_binary(loop->GetInit()) : nullptr};
+             init && init->GetOp() == Tag::kEqual) {
+    iter_var_ = const_cast<ObjectExpr *>(
+        dynamic_cast<const ObjectExpr *>(init->GetLHS()));
+    lower_bound_ = init->GetRHS();
+  }
+
+  if (iter_var_ == nullptr) {
+    Error(loop->GetLoc(),
+          "initialization clause of OpenMP for loop is not in canonical form");
+  }
+  if (!iter_var_->GetType()->IsIntegerTy()) {
+    Error(loop->GetLoc(), "variable must be of integer type");
+  }
+  // libgomp 的迭代区间最多为 64 位
+  if (iter_var_->GetType()->GetWidth() > 8) {
+    Error(loop->GetLoc(), "OpenMP loop variable '{}' is wider than 64 bits",
+          iter_var_->GetName());
+  }
+
+  // i < ub / ub > i
+  auto cond{loop->GetCond() ? as_binary(loop->GetCond()) : nullptr};
+  if (cond) {
+    cond_op_ = cond->GetOp();
+    if (strip(cond->GetLHS()) == iter_var_) {
+      upper_bound_ = cond->GetRHS();
+    } else if (strip(cond->GetRHS()) == iter_var_) {
+      upper_bound_ = cond->GetLHS();
+      switch (cond_op_) {
+        case Tag::kLess:
+          cond_op_ = Tag::kGreater;
+          break;
+        case Tag::kGreater:
+          cond_op_ = Tag::kLess;
+          break;
+        case Tag::kLessEqual:
+          cond_op_ = Tag::kGreaterEqual;
+          break;
+        case Tag::kGreaterEqual:
+          cond_op_ = Tag::kLessEqual;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  if (upper_bound_ == nullptr ||
+      (cond_op_ != Tag::kLess && cond_op_ != Tag::kGreater &&
+       cond_op_ != Tag::kLessEqual && cond_op_ != Tag::kGreaterEqual)) {
+    Error(loop->GetLoc(),
+          "condition of OpenMP for loop must be a relational comparison ('<', "
+          "'<=', '>', or '>=') of loop variable '{}'",
+          iter_var_->GetName());
+  }
+
+  // ++i / i++ / --i / i-- / i += step / i -= step
+  bool canonical{false};
+  if (auto inc{loop->GetInc() ? strip(loop->GetInc()) : nullptr};
+      inc && inc->Kind() == AstNodeType::kUnaryOpExpr) {
+    auto unary{dynamic_cast<const UnaryOpExpr *>(inc)};
+    auto op{unary->GetOp()};
+    canonical = strip(unary->GetExpr()) == iter_var_ &&
+                (op == Tag::kPlusPlus || op == Tag::kPostfixPlusPlus ||
+                 op == Tag::kMinusMinus || op == Tag::kPostfixMinusMinus);
+    is_decrement_ = op == Tag::kMinusMinus || op == Tag::kPostfixMinusMinus;
+  } else if (auto assign{inc ? as_binary(inc) : nullptr};
+             assign && assign->GetOp() == Tag::kEqual &&
+             strip(assign->GetLHS()) == iter_var_) {
+    if (auto rhs{as_binary(assign->GetRHS())};
+        rhs && (rhs->GetOp() == Tag::kPlus || rhs->GetOp() == Tag::kMinus) &&
+        strip(rhs->GetLHS()) == iter_var_ &&
+        rhs->GetRHS()->GetType()->IsIntegerTy()) {
+      canonical = true;
+      step_ = rhs->GetRHS();
+      is_decrement_ = rhs->GetOp() == Tag::kMinus;
+    }
+  }
+  if (!canonical) {
+    Error(loop->GetLoc(),
+          "increment clause of OpenMP for loop must perform simple addition "
+          "or subtraction on loop variable '{}'",
+          iter_var_->GetName());
+  }
+}
 
 /*
  * TranslationUnit
@@ -1468,7 +2215,8 @@ void Declaration::AddInits(std::vector<Initializer> inits) {
     if (!type->Equal(expr->GetType())) {
       expr = Expr::MayCastTo(expr, type);
     }
-  } else if (ident_->GetType()->IsAggregateTy()) {
+  } else if (ident_->GetType()->IsAggregateTy() ||
+             ident_->GetType()->IsVectorTy()) {
     auto last{*(std::end(inits_) - 1)};
 
     for (auto &&init : inits_) {
@@ -1560,6 +2308,14 @@ IdentifierExpr *FuncDef::GetIdent() const { return ident_; }
 
 const CompoundStmt *FuncDef::GetBody() const { return body_; }
 
+void FuncDef::SetLabelAddrs(std::vector<LabelAddrExpr *> label_addrs) {
+  label_addrs_ = std::move(label_addrs);
+}
+
+const std::vector<LabelAddrExpr *> &FuncDef::GetLabelAddrs() const {
+  return label_addrs_;
+}
+
 FuncDef::FuncDef(IdentifierExpr *ident) : ident_{ident} {}
 
 }  // namespace kcc
@@ -41,6 +41,10 @@ std::optional<std::int64_t> CalcConstantExpr::CalcInteger(const Expr *expr,
   }
 
   if (auto p{llvm::dyn_cast<llvm::ConstantInt>(val)}) {
+    // __int128 的值可能超出 64 位
+    if (p->getValue().getMinSignedBits() > 64) {
+      Error(expr->GetLoc(), "integer constant is too large");
+    }
     return p->getValue().getSExtValue();
   } else {
     Error(expr->GetLoc(), "expect integer constant expression, but got '{}'",
@@ -219,13 +223,22 @@ void CalcConstantExpr::Visit(const StringLiteralExpr *node) {
   val_ = node->GetPtr();
 }
 
-void CalcConstantExpr::Visit(const FuncCallExpr *) { Throw(); }
+void CalcConstantExpr::Visit(const FuncCallExpr *node) {
+  if (node->GetFuncType()->FuncGetName() == "__builtin_constant_p") {
+    val_ = llvm::ConstantInt::get(
+        node->GetType()->GetLLVMType(),
+        CalcConstantExpr{node->GetLoc()}.Calc(node->GetArgs().front()) !=
+            nullptr);
+  } else {
+    Throw();
+  }
+}
 
 void CalcConstantExpr::Visit(const IdentifierExpr *node) {
   auto type{node->GetType()};
   assert(type->IsFunctionTy());
 
-  auto name{node->GetName()};
+  auto name{node->GetLinkName()};
 
   auto func{Module->getFunction(name)};
   if (!func) {
@@ -251,6 +264,10 @@ void CalcConstantExpr::Visit(const ObjectExpr *node) {
   }
 }
 
+void CalcConstantExpr::Visit(const LabelAddrExpr *node) {
+  val_ = node->GetPlaceholder();
+}
+
 void CalcConstantExpr::Visit(const LabelStmt *) { assert(false); }
 
 void CalcConstantExpr::Visit(const CaseStmt *) { assert(false); }
@@ -279,6 +296,10 @@ void CalcConstantExpr::Visit(const BreakStmt *) { assert(false); }
 
 void CalcConstantExpr::Visit(const ReturnStmt *) { assert(false); }
 
+void CalcConstantExpr::Visit(const AsmStmt *) { assert(false); }
+
+void CalcConstantExpr::Visit(const OmpStmt *) { assert(false); }
+
 void CalcConstantExpr::Visit(const TranslationUnit *) { assert(false); }
 
 void CalcConstantExpr::Visit(const Declaration *) { assert(false); }
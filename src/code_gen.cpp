@@ -4,9 +4,18 @@
 
 #include "code_gen.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_set>
 #include <vector>
 
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/IR/Attributes.h>
 #include <llvm/IR/CFG.h>
 #include <llvm/IR/Constants.h>
@@ -14,8 +23,12 @@
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetOptions.h>
 
@@ -26,23 +39,207 @@
 
 namespace kcc {
 
+namespace {
+
+// 初始值在对象中的位置, 即每一层数组 / 结构体的下标
+using InitPath = std::vector<std::int32_t>;
+
+std::uint64_t CountScalars(llvm::Type *type) {
+  if (auto arr{llvm::dyn_cast<llvm::ArrayType>(type)}) {
+    return arr->getNumElements() * CountScalars(arr->getElementType());
+  } else if (auto st{llvm::dyn_cast<llvm::StructType>(type)}) {
+    std::uint64_t count{};
+    for (const auto &item : st->elements()) {
+      count += CountScalars(item);
+    }
+    return count;
+  } else {
+    return 1;
+  }
+}
+
+// 没有初始值的部分为零
+llvm::Constant *BuildConstant(
+    llvm::Type *type, const std::map<InitPath, llvm::Constant *> &values,
+    InitPath &prefix) {
+  // 没有以 prefix 开头的初始值
+  auto iter{values.lower_bound(prefix)};
+  if (iter == std::end(values) || std::size(iter->first) < std::size(prefix) ||
+      !std::equal(std::begin(prefix), std::end(prefix),
+                  std::begin(iter->first))) {
+    return llvm::Constant::getNullValue(type);
+  }
+
+  if (iter->first == prefix) {
+    return iter->second;
+  }
+
+  std::vector<llvm::Constant *> elements;
+  if (auto arr{llvm::dyn_cast<llvm::ArrayType>(type)}) {
+    for (std::uint64_t i{}; i < arr->getNumElements(); ++i) {
+      prefix.push_back(i);
+      elements.push_back(BuildConstant(arr->getElementType(), values, prefix));
+      prefix.pop_back();
+    }
+    return llvm::ConstantArray::get(arr, elements);
+  } else {
+    auto st{llvm::cast<llvm::StructType>(type)};
+    for (std::uint32_t i{}; i < st->getNumElements(); ++i) {
+      prefix.push_back(i);
+      elements.push_back(
+          BuildConstant(st->getElementType(i), values, prefix));
+      prefix.pop_back();
+    }
+    return llvm::ConstantStruct::get(st, elements);
+  }
+}
+
+// 能否安全地在编译期计算, 语句表达式 / 函数调用有副作用, 除数为零时
+// CalcConstantExpr 会报错, 这些情况都留到运行时计算
+bool IsFoldableInit(const Expr *expr) {
+  switch (expr->Kind()) {
+    case AstNodeType::kStmtExpr:
+    case AstNodeType::kFuncCallExpr:
+      return false;
+    case AstNodeType::kUnaryOpExpr:
+      return IsFoldableInit(dynamic_cast<const UnaryOpExpr *>(expr)->GetExpr());
+    case AstNodeType::kTypeCastExpr:
+      return IsFoldableInit(
+          dynamic_cast<const TypeCastExpr *>(expr)->GetExpr());
+    case AstNodeType::kBinaryOpExpr: {
+      auto binary{dynamic_cast<const BinaryOpExpr *>(expr)};
+      if (!IsFoldableInit(binary->GetLHS()) ||
+          !IsFoldableInit(binary->GetRHS())) {
+        return false;
+      }
+
+      if (binary->GetOp() == Tag::kSlash || binary->GetOp() == Tag::kPercent) {
+        auto rhs{CalcConstantExpr{}.Calc(binary->GetRHS())};
+        return rhs && !rhs->isZeroValue();
+      }
+      return true;
+    }
+    case AstNodeType::kConditionOpExpr: {
+      auto cond{dynamic_cast<const ConditionOpExpr *>(expr)};
+      return IsFoldableInit(cond->GetCond()) &&
+             IsFoldableInit(cond->GetLHS()) && IsFoldableInit(cond->GetRHS());
+    }
+    default:
+      return true;
+  }
+}
+
+// 如果每个初始值都是标量且只经过数组和结构体(不包括位域 / 联合体 / 向量),
+// 返回由其中的常量组成的值, is_constant 记录每个初始值是否为常量,
+// full 表示对象中的每个标量都有初始值
+llvm::Constant *GetLocalInitConstant(const Declaration *node,
+                                     std::vector<bool> &is_constant,
+                                     bool &full) {
+  auto obj_type{node->GetObject()->GetType()->GetLLVMType()};
+
+  std::set<InitPath> paths;
+  std::map<InitPath, llvm::Constant *> values;
+  for (const auto &item : node->GetLocalInits()) {
+    InitPath path;
+    auto type{obj_type};
+    for (const auto &[t, index, begin, width] : item.GetIndexs()) {
+      if (width != 0) {
+        return nullptr;
+      } else if (t->IsArrayTy()) {
+        type = type->getArrayElementType();
+      } else if (t->IsStructTy()) {
+        type = type->getStructElementType(index);
+      } else {
+        return nullptr;
+      }
+      path.push_back(index);
+    }
+
+    // 重复的指示符, 以最后一个为准, 此时不区分常量
+    if (type->isAggregateType() || type->isVectorTy() ||
+        !paths.insert(path).second) {
+      return nullptr;
+    }
+
+    auto expr{item.GetExpr()};
+    llvm::Constant *value{};
+    if (IsFoldableInit(expr)) {
+      value = CalcConstantExpr{}.Calc(expr);
+    }
+
+    if (value && value->getType() == type) {
+      values[path] = value;
+      is_constant.push_back(true);
+    } else {
+      is_constant.push_back(false);
+    }
+  }
+
+  full = std::size(paths) == CountScalars(obj_type);
+
+  InitPath prefix;
+  return BuildConstant(obj_type, values, prefix);
+}
+
+// 局部变量的地址是否可能被其他函数访问, 只允许 load / store / memcpy 等
+bool AddressMayEscape(const llvm::Value *ptr) {
+  for (const auto user : ptr->users()) {
+    if (llvm::isa<llvm::LoadInst>(user) || llvm::isa<llvm::MemIntrinsic>(user)) {
+      continue;
+    } else if (auto store{llvm::dyn_cast<llvm::StoreInst>(user)}) {
+      if (store->getValueOperand() == ptr) {
+        return true;
+      }
+    } else if (llvm::isa<llvm::GetElementPtrInst>(user) ||
+               llvm::isa<llvm::BitCastInst>(user)) {
+      if (AddressMayEscape(user)) {
+        return true;
+      }
+    } else {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
+
 /*
  * BreakContinue
  */
 CodeGen::BreakContinue::BreakContinue(llvm::BasicBlock *break_block,
-                                      llvm::BasicBlock *continue_block)
-    : break_block(break_block), continue_block(continue_block) {}
+                                      llvm::BasicBlock *continue_block,
+                                      std::size_t break_depth,
+                                      std::size_t continue_depth)
+    : break_block(break_block),
+      continue_block(continue_block),
+      break_depth(break_depth),
+      continue_depth(continue_depth) {}
 
 /*
  * CodeGen
  */
 void CodeGen::GenCode(const TranslationUnit *root) {
+  llvm::TimeTraceScope scope{"CodeGen::GenCode"};
+
   if (Debug) {
     debug_info_ = std::make_unique<DebugInfo>();
   }
 
   root->Accept(*this);
 
+  // 数学库函数不会修改 errno 时, 可以像 clang 一样将其视为无副作用,
+  // 从而允许向量化和公共子表达式消除
+  if (!MathErrno) {
+    for (auto &func : *Module) {
+      if (func.isDeclaration() && IsMathLibFunc(func.getName())) {
+        func.addFnAttr(llvm::Attribute::ReadNone);
+        func.addFnAttr(llvm::Attribute::NoUnwind);
+      }
+    }
+  }
+
   if (debug_info_) {
     debug_info_->Finalize();
   }
@@ -147,7 +344,80 @@ void CodeGen::EmitBranchOnBoolExpr(const Expr *expr,
     return;
   }
 
-  Builder.CreateCondBr(EvaluateExprAsBool(expr), true_block, false_block);
+  Builder.CreateCondBr(EvaluateExprAsBool(expr), true_block, false_block,
+                       GetExpectBranchWeights(expr));
+}
+
+// 和 clang 一样, __builtin_expect 预期的分支权重为 2000 : 1
+// __builtin_expect_with_probability 则按给定的概率计算权重
+llvm::MDNode *CodeGen::GetExpectBranchWeights(const Expr *expr) {
+  constexpr std::uint32_t kLikelyBranchWeight{2000};
+  constexpr std::uint32_t kUnlikelyBranchWeight{1};
+
+  // __builtin_expect(x, a) == c / __builtin_expect(x, a) != c
+  std::optional<std::int64_t> compare_with;
+  auto is_equal{false};
+  if (auto binary{dynamic_cast<const BinaryOpExpr *>(expr)};
+      binary && (binary->GetOp() == Tag::kEqualEqual ||
+                 binary->GetOp() == Tag::kExclaimEqual)) {
+    compare_with = CalcConstantExpr{}.CalcInteger(binary->GetRHS(), false);
+    if (!compare_with) {
+      return nullptr;
+    }
+
+    is_equal = binary->GetOp() == Tag::kEqualEqual;
+    expr = binary->GetLHS();
+  }
+
+  while (auto cast{dynamic_cast<const TypeCastExpr *>(expr)}) {
+    expr = cast->GetExpr();
+  }
+
+  auto call{dynamic_cast<const FuncCallExpr *>(expr)};
+  if (!call) {
+    return nullptr;
+  }
+
+  auto name{call->GetFuncType()->FuncGetName()};
+  if (name != "__builtin_expect" &&
+      name != "__builtin_expect_with_probability") {
+    return nullptr;
+  }
+
+  auto expected{CalcConstantExpr{}.CalcInteger(call->GetArgs()[1], false)};
+  if (!expected) {
+    return nullptr;
+  }
+
+  // 条件为真是否是预期的结果
+  auto likely{compare_with ? (*expected == *compare_with) == is_equal
+                           : *expected != 0};
+
+  std::uint32_t true_weight, false_weight;
+  if (name == "__builtin_expect") {
+    true_weight = likely ? kLikelyBranchWeight : kUnlikelyBranchWeight;
+    false_weight = likely ? kUnlikelyBranchWeight : kLikelyBranchWeight;
+  } else {
+    auto probability{llvm::dyn_cast_or_null<llvm::ConstantFP>(
+        CalcConstantExpr{}.Calc(call->GetArgs()[2]))};
+    if (!probability) {
+      return nullptr;
+    }
+
+    auto true_probability{probability->getValueAPF().convertToDouble()};
+    if (!likely) {
+      true_probability = 1.0 - true_probability;
+    }
+
+    constexpr std::uint32_t kMaxWeight{
+        std::numeric_limits<std::int32_t>::max() - 1};
+    true_weight = static_cast<std::uint32_t>(
+        std::llround(true_probability * kMaxWeight));
+    false_weight = kMaxWeight - true_weight;
+  }
+
+  return llvm::MDBuilder{Context}.createBranchWeights(true_weight,
+                                                      false_weight);
 }
 
 void CodeGen::SimplifyForwardingBlocks(llvm::BasicBlock *bb) {
@@ -245,6 +515,22 @@ llvm::BasicBlock *CodeGen::GetBasicBlockForLabel(const LabelStmt *label) {
   return bb = CreateBasicBlock(label->GetName());
 }
 
+llvm::BasicBlock *CodeGen::GetIndirectGotoBlock() {
+  if (indirect_goto_block_) {
+    return indirect_goto_block_;
+  }
+
+  indirect_goto_block_ = CreateBasicBlock("indirectgoto");
+
+  llvm::IRBuilder<> builder{indirect_goto_block_};
+  indirect_goto_phi_ =
+      builder.CreatePHI(builder.getInt8PtrTy(), 0, "indirect.goto.dest");
+  // 跳转目标在函数结束时加入
+  builder.CreateIndirectBr(indirect_goto_phi_);
+
+  return indirect_goto_block_;
+}
+
 bool CodeGen::IsCheapEnoughToEvaluateUnconditionally(const Expr *expr) {
   return expr->Kind() == AstNodeType::kConstantExpr;
 }
@@ -267,12 +553,9 @@ llvm::Value *CodeGen::GetPtr(const AstNode *node) {
   if (node->Kind() == AstNodeType::kObjectExpr) {
     auto obj{dynamic_cast<const ObjectExpr *>(node)};
     is_volatile_ = obj->GetQualType().IsVolatile();
+    is_atomic_ = obj->GetQualType().IsAtomic();
 
-    if (obj->IsGlobalVar() || obj->IsLocalStaticVar()) {
-      return obj->GetGlobalPtr();
-    } else {
-      return obj->GetLocalPtr();
-    }
+    return GetObjectPtr(obj);
   } else if (node->Kind() == AstNodeType::kIdentifierExpr) {
     // 函数指针
     node->Accept(*this);
@@ -281,6 +564,7 @@ llvm::Value *CodeGen::GetPtr(const AstNode *node) {
     auto unary{dynamic_cast<const UnaryOpExpr *>(node)};
     assert(unary->GetOp() == Tag::kStar);
     unary->GetExpr()->Accept(*this);
+    is_atomic_ = unary->GetQualType().IsAtomic();
     return result_;
   } else if (node->Kind() == AstNodeType::kBinaryOpExpr) {
     auto binary{dynamic_cast<const BinaryOpExpr *>(node)};
@@ -294,6 +578,7 @@ llvm::Value *CodeGen::GetPtr(const AstNode *node) {
       if (obj->GetQualType().IsVolatile()) {
         is_volatile_ = true;
       }
+      is_atomic_ = obj->GetQualType().IsAtomic();
 
       if (obj->GetBitFieldWidth()) {
         is_bit_field_ = true;
@@ -333,13 +618,39 @@ llvm::Value *CodeGen::GetPtr(const AstNode *node) {
   return nullptr;
 }
 
+llvm::Value *CodeGen::GetObjectPtr(const ObjectExpr *obj) const {
+  // OpenMP 构造中的私有副本
+  if (auto iter{omp_privates_.find(obj)}; iter != std::end(omp_privates_)) {
+    return iter->second;
+  }
+
+  if (obj->IsGlobalVar() || obj->IsLocalStaticVar()) {
+    return obj->GetGlobalPtr();
+  } else {
+    return obj->GetLocalPtr();
+  }
+}
+
 void CodeGen::PushBlock(llvm::BasicBlock *break_stack,
-                        llvm::BasicBlock *continue_block) {
-  break_continue_stack_.push({break_stack, continue_block});
+                        llvm::BasicBlock *continue_block,
+                        std::optional<std::size_t> continue_depth) {
+  auto depth{std::size(stack_saves_)};
+  break_continue_stack_.push(
+      {break_stack, continue_block, depth, continue_depth.value_or(depth)});
 }
 
 void CodeGen::PopBlock() { break_continue_stack_.pop(); }
 
+// 离开声明了变长数组的块时, 释放块中分配的栈空间
+void CodeGen::EmitStackRestore(std::size_t depth) {
+  static auto stack_restore{llvm::Intrinsic::getDeclaration(
+      Module.get(), llvm::Intrinsic::stackrestore)};
+
+  if (std::size(stack_saves_) > depth && HaveInsertPoint()) {
+    Builder.CreateCall(stack_restore, {stack_saves_[depth]});
+  }
+}
+
 bool CodeGen::TestAndClearIgnoreAssignResult() {
   auto ret{ignore_assign_result_};
   ignore_assign_result_ = false;
@@ -455,6 +766,11 @@ void CodeGen::DealLocaleDecl(const Declaration *node) {
   auto type{obj->GetType()};
   auto name{obj->GetName()};
 
+  if (type->IsVLATy()) {
+    DealVLADecl(node);
+    return;
+  }
+
   auto ptr{CreateEntryBlockAlloca(type->GetLLVMType(), obj->GetAlign(), name)};
   obj->SetLocalPtr(ptr);
 
@@ -470,40 +786,140 @@ void CodeGen::DealLocaleDecl(const Declaration *node) {
       init.front().GetExpr()->Accept(*this);
       Builder.CreateStore(result_, obj->GetLocalPtr(), is_volatile_);
       is_volatile_ = false;
-    } else if (type->IsAggregateTy()) {
+    } else if (type->IsAggregateTy() || type->IsVectorTy()) {
       InitLocalAggregate(node);
     } else {
       assert(false);
     }
   } else if (node->HasConstantInit()) {
-    if (ptr->getType() != Builder.getInt8PtrTy()) {
-      result_ = Builder.CreateBitCast(ptr, Builder.getInt8PtrTy());
+    result_ = Builder.CreateBitCast(ptr, Builder.getInt8PtrTy());
+
+    // e.g. char buf[4096] = "abc";
+    // 只复制字符串本身, 剩余的部分清零, 不能越过字符串常量读取
+    std::uint64_t width{static_cast<std::uint64_t>(type->GetWidth())};
+    auto size{width};
+    if (auto str{llvm::dyn_cast<llvm::GlobalVariable>(
+            node->GetConstant()->stripPointerCasts())}) {
+      size = std::min<std::uint64_t>(
+          width,
+          Module->getDataLayout().getTypeAllocSize(str->getValueType()));
     }
 
     auto align{llvm::MaybeAlign{static_cast<std::uint64_t>(obj->GetAlign())}};
-    Builder.CreateMemCpy(result_, align, node->GetConstant(), align,
-                         obj->GetType()->GetWidth(), is_volatile_);
+    Builder.CreateMemCpy(result_, align, node->GetConstant(), align, size,
+                         is_volatile_);
+    if (size < width) {
+      Builder.CreateMemSet(Builder.CreateConstInBoundsGEP1_64(result_, size),
+                           Builder.getInt8(0), width - size, llvm::MaybeAlign{},
+                           is_volatile_);
+    }
     is_volatile_ = false;
   }
 }
 
+void CodeGen::DealVLADecl(const Declaration *node) {
+  EnsureInsertPoint();
+
+  auto obj{node->GetObject()};
+  auto type{obj->GetType()};
+  auto size_obj{type->ArrayGetVLASize()};
+  assert(size_obj != nullptr);
+
+  // 同一个变长数组类型可能被多个声明共享(e.g. typeof), 元素个数只计算一次
+  llvm::Value *num_elements{};
+  if (size_obj->HasLocalPtr()) {
+    num_elements = Builder.CreateLoad(size_obj->GetLocalPtr());
+  } else {
+    type->ArrayGetVLALength()->Accept(*this);
+    num_elements =
+        CastTo(result_, size_obj->GetType()->GetLLVMType(),
+               type->ArrayGetVLALength()->GetType()->IsUnsigned());
+
+    auto size_ptr{CreateEntryBlockAlloca(size_obj->GetType()->GetLLVMType(),
+                                         size_obj->GetAlign(),
+                                         size_obj->GetName())};
+    size_obj->SetLocalPtr(size_ptr);
+    Builder.CreateStore(num_elements, size_ptr);
+  }
+
+  // 不能放在入口块中, 长度在运行到此处时才知道
+  auto element_type{type->ArrayGetElementType()};
+  auto ptr{Builder.CreateAlloca(element_type->GetLLVMType(), num_elements,
+                                obj->GetName())};
+  ptr->setAlignment(
+      llvm::Align{static_cast<std::uint64_t>(obj->GetAlign())});
+
+  obj->SetLocalPtr(Builder.CreateBitCast(
+      ptr, type->GetLLVMType()->getPointerTo(), obj->GetName()));
+}
+
 void CodeGen::InitLocalAggregate(const Declaration *node) {
   EnsureInsertPoint();
 
   auto obj{node->GetObject()};
   auto width{obj->GetType()->GetWidth()};
 
+  const auto &inits{node->GetLocalInits()};
+
+  // e.g. struct A b = a; 整个对象都会被覆盖, 不需要先清零
+  if (std::size(inits) == 1 && std::empty(inits.front().GetIndexs()) &&
+      IsMemCpyAggregate(inits.front().GetExpr())) {
+    CopyAggregate(obj->GetLocalPtr(), inits.front().GetExpr(), is_volatile_);
+    is_volatile_ = false;
+    return;
+  }
+
+  auto align{llvm::MaybeAlign{static_cast<std::uint64_t>(obj->GetAlign())}};
   result_ = Builder.CreateBitCast(obj->GetLocalPtr(), Builder.getInt8PtrTy());
-  Builder.CreateMemSet(
-      result_, Builder.getInt8(0), width,
-      llvm::MaybeAlign{static_cast<std::uint64_t>(obj->GetAlign())},
-      is_volatile_);
 
-  for (const auto &item : node->GetLocalInits()) {
-    Load_Struct_Obj();
-    item.GetExpr()->Accept(*this);
-    Finish_Load();
-    auto value{result_};
+  // 常量部分可以一次性初始化, 之后只需要存储非常量的初始值
+  std::vector<bool> is_constant;
+  auto full{false};
+  auto constant{GetLocalInitConstant(node, is_constant, full)};
+  auto num_constant{std::count(std::begin(is_constant), std::end(is_constant),
+                               true)};
+
+  if (constant && constant->isNullValue() && (!full || num_constant > 0)) {
+    // e.g. int a[100] = {}; / int a[100] = {0, x};
+    // 每个标量都由非常量存储时不需要清零, e.g. int a[4] = {x, x + 1, ...};
+    Builder.CreateMemSet(result_, Builder.getInt8(0), width, align,
+                         is_volatile_);
+  } else if (constant && 2 * num_constant >= std::size(inits)) {
+    // 大部分为常量, 与 clang 一致, 从只读的全局常量中复制
+    // e.g. int table[256] = {1, 2, 3, ...};
+    auto global{new llvm::GlobalVariable{
+        *Module, constant->getType(), true, llvm::GlobalValue::PrivateLinkage,
+        constant,
+        "__const." + func_->getName().str() + "." + obj->GetName()}};
+    global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    global->setAlignment(align);
+
+    Builder.CreateMemCpy(result_, align, global, align, width, is_volatile_);
+  } else {
+    // 所有标量都会被存储时不需要清零
+    if (!constant || !full) {
+      Builder.CreateMemSet(result_, Builder.getInt8(0), width, align,
+                           is_volatile_);
+    }
+    is_constant.clear();
+  }
+
+  for (std::size_t i{}; i < std::size(inits); ++i) {
+    const auto &item{inits[i]};
+    if (i < std::size(is_constant) && is_constant[i]) {
+      continue;
+    }
+
+    // 较大的结构体成员在计算出地址后再复制
+    auto copy_aggregate{IsMemCpyAggregate(item.GetExpr())};
+
+    llvm::Value *value{};
+    if (!copy_aggregate) {
+      Load_Struct_Obj();
+      item.GetExpr()->Accept(*this);
+      Finish_Load();
+      value = result_;
+    }
 
     llvm::Value *ptr{obj->GetLocalPtr()};
     Type *member_type{};
@@ -523,6 +939,11 @@ void CodeGen::InitLocalAggregate(const Declaration *node) {
         member_type = type->StructGetMemberType(index).GetType();
         ptr = Builder.CreateBitCast(ptr,
                                     member_type->GetLLVMType()->getPointerTo());
+      } else if (type->IsVectorTy()) {
+        member_type = type->VectorGetElementType().GetType();
+        ptr = Builder.CreateBitCast(ptr,
+                                    member_type->GetLLVMType()->getPointerTo());
+        ptr = Builder.CreateInBoundsGEP(ptr, {Builder.getInt64(index)});
       } else {
         member_type = type;
         break;
@@ -547,7 +968,11 @@ void CodeGen::InitLocalAggregate(const Declaration *node) {
       value = Builder.CreateOr(result_, value);
     }
 
-    result_ = Builder.CreateStore(value, ptr, is_volatile_);
+    if (copy_aggregate) {
+      CopyAggregate(ptr, item.GetExpr(), is_volatile_);
+    } else {
+      result_ = Builder.CreateStore(value, ptr, is_volatile_);
+    }
   }
 
   is_volatile_ = false;
@@ -568,9 +993,32 @@ void CodeGen::StartFunction(const FuncDef *node) {
   func_->addFnAttr(llvm::Attribute::StackProtectStrong);
   func_->addFnAttr(llvm::Attribute::UWTable);
 
+  func_->addFnAttr("target-cpu", TargetCPU);
+  if (!std::empty(TuneCPU)) {
+    func_->addFnAttr("tune-cpu", TuneCPU);
+  }
+  if (!std::empty(TargetFeatures)) {
+    func_->addFnAttr("target-features", TargetFeatures);
+  }
+
+  auto fmf{Builder.getFastMathFlags()};
+  func_->addFnAttr("no-infs-fp-math", llvm::toStringRef(fmf.noInfs()));
+  func_->addFnAttr("no-nans-fp-math", llvm::toStringRef(fmf.noNaNs()));
+  func_->addFnAttr("no-signed-zeros-fp-math",
+                   llvm::toStringRef(fmf.noSignedZeros()));
+  func_->addFnAttr("unsafe-fp-math",
+                   llvm::toStringRef(fmf.allowReassoc() &&
+                                     fmf.noSignedZeros() &&
+                                     fmf.allowReciprocal()));
+
   if (OptimizationLevel == OptLevel::kO0) {
     func_->addFnAttr(llvm::Attribute::NoInline);
     func_->addFnAttr(llvm::Attribute::OptimizeNone);
+  } else if (OptimizationLevel == OptLevel::kOs) {
+    func_->addFnAttr(llvm::Attribute::OptimizeForSize);
+  } else if (OptimizationLevel == OptLevel::kOz) {
+    func_->addFnAttr(llvm::Attribute::OptimizeForSize);
+    func_->addFnAttr(llvm::Attribute::MinSize);
   }
 
   auto entry{CreateBasicBlock("entry", func_)};
@@ -592,7 +1040,7 @@ void CodeGen::StartFunction(const FuncDef *node) {
 }
 
 void CodeGen::FinishFunction(const FuncDef *node) {
-  auto func{Module->getFunction(node->GetName())};
+  auto func{Module->getFunction(node->GetIdent()->GetLinkName())};
 
   EmitReturnBlock();
   EmitFunctionEpilog();
@@ -601,6 +1049,47 @@ void CodeGen::FinishFunction(const FuncDef *node) {
   alloc_insert_point_ = nullptr;
   ptr->eraseFromParent();
 
+  std::unordered_set<llvm::BasicBlock *> dests;
+  for (const auto &item : node->GetLabelAddrs()) {
+    auto block{GetBasicBlockForLabel(item->GetLabel())};
+    auto addr{llvm::BlockAddress::get(func_, block)};
+
+    if (item->HasPlaceholder()) {
+      auto placeholder{item->GetPlaceholder()};
+      placeholder->replaceAllUsesWith(addr);
+      placeholder->eraseFromParent();
+    }
+
+    if (indirect_goto_block_ && dests.insert(block).second) {
+      llvm::cast<llvm::IndirectBrInst>(indirect_goto_block_->getTerminator())
+          ->addDestination(block);
+    }
+  }
+
+  if (indirect_goto_block_) {
+    func_->getBasicBlockList().push_back(indirect_goto_block_);
+    indirect_goto_block_ = nullptr;
+    indirect_goto_phi_ = nullptr;
+  }
+
+  if (!std::empty(omp_regions_)) {
+    OutlineOmpRegions();
+  }
+
+  // 没有局部变量的地址会泄露给被调用者时, return f(...) 中的调用
+  // 可以标记为 tail, 调用了 setjmp 等函数时栈帧之后可能还会被使用
+  if (!std::empty(tail_calls_) && !func_->callsFunctionThatReturnsTwice() &&
+      std::none_of(llvm::inst_begin(func_), llvm::inst_end(func_),
+                   [](const llvm::Instruction &inst) {
+                     return llvm::isa<llvm::AllocaInst>(inst) &&
+                            AddressMayEscape(&inst);
+                   })) {
+    for (auto call : tail_calls_) {
+      call->setTailCall();
+    }
+  }
+  tail_calls_.clear();
+
   labels_.clear();
 
   // 验证生成的代码, 检查一致性
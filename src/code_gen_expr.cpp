@@ -6,14 +6,19 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <optional>
+#include <tuple>
 #include <vector>
 
 #include <llvm/IR/CFG.h>
 #include <llvm/IR/Constant.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/MathExtras.h>
 
 #include "calc.h"
+#include "error.h"
 #include "llvm_common.h"
 
 namespace kcc {
@@ -57,6 +62,7 @@ void CodeGen::Visit(const UnaryOpExpr *node) {
       break;
     case Tag::kAmp:
       result_ = GetPtr(node->GetExpr());
+      is_atomic_ = false;
       break;
     default:
       assert(false);
@@ -99,34 +105,16 @@ void CodeGen::Visit(const BinaryOpExpr *node) {
 
   switch (node->GetOp()) {
     case Tag::kPlus:
-      result_ = AddOp(lhs, rhs, is_unsigned);
-      break;
     case Tag::kMinus:
-      result_ = SubOp(lhs, rhs, is_unsigned);
-      break;
     case Tag::kStar:
-      result_ = MulOp(lhs, rhs, is_unsigned);
-      break;
     case Tag::kSlash:
-      result_ = DivOp(lhs, rhs, is_unsigned);
-      break;
     case Tag::kPercent:
-      result_ = ModOp(lhs, rhs, is_unsigned);
-      break;
     case Tag::kPipe:
-      result_ = OrOp(lhs, rhs);
-      break;
     case Tag::kAmp:
-      result_ = AndOp(lhs, rhs);
-      break;
     case Tag::kCaret:
-      result_ = XorOp(lhs, rhs);
-      break;
     case Tag::kLessLess:
-      result_ = ShlOp(lhs, rhs);
-      break;
     case Tag::kGreaterGreater:
-      result_ = ShrOp(lhs, rhs, is_unsigned);
+      result_ = ArithmeticOp(node->GetOp(), lhs, rhs, is_unsigned);
       break;
     case Tag::kEqualEqual:
       result_ = EqualOp(lhs, rhs);
@@ -149,6 +137,9 @@ void CodeGen::Visit(const BinaryOpExpr *node) {
     case Tag::kComma:
       result_ = rhs;
       break;
+    case Tag::kLeftSquare:
+      result_ = Builder.CreateExtractElement(lhs, rhs);
+      break;
     default:
       assert(false);
   }
@@ -271,7 +262,7 @@ void CodeGen::Visit(const IdentifierExpr *node) {
   auto type{node->GetType()};
   assert(type->IsFunctionTy());
 
-  auto name{node->GetName()};
+  auto name{node->GetLinkName()};
 
   auto func{Module->getFunction(name)};
   if (!func) {
@@ -292,18 +283,17 @@ void CodeGen::Visit(const EnumeratorExpr *node) {
 }
 
 void CodeGen::Visit(const ObjectExpr *node) {
-  llvm::Value *ptr;
-  if (node->IsGlobalVar() || node->IsLocalStaticVar()) {
-    ptr = node->GetGlobalPtr();
-  } else {
-    ptr = node->GetLocalPtr();
-  }
+  auto ptr{GetObjectPtr(node)};
 
   is_volatile_ = node->GetQualType().IsVolatile();
 
   auto type{node->GetType()};
   if (type->IsArrayTy() || (type->IsStructOrUnionTy() && !load_struct_)) {
     result_ = ptr;
+  } else if (node->GetQualType().IsAtomic()) {
+    result_ = AtomicLoad(ptr, llvm::AtomicOrdering::SequentiallyConsistent,
+                         is_volatile_);
+    is_volatile_ = false;
   } else {
     result_ = Builder.CreateLoad(ptr, is_volatile_);
     is_volatile_ = false;
@@ -315,11 +305,22 @@ void CodeGen::Visit(const StmtExpr *node) {
   node->GetBlock()->Accept(*this);
 }
 
+void CodeGen::Visit(const LabelAddrExpr *node) {
+  result_ = llvm::BlockAddress::get(func_,
+                                    GetBasicBlockForLabel(node->GetLabel()));
+}
+
 llvm::Value *CodeGen::IncOrDec(const Expr *expr, bool is_inc, bool is_postfix) {
   auto is_unsigned{expr->GetType()->IsUnsigned()};
   auto lhs_ptr{GetPtr(expr)};
 
   TryEmitLocation(expr);
+
+  if (is_atomic_) {
+    is_atomic_ = false;
+    is_volatile_ = false;
+    return AtomicIncOrDec(lhs_ptr, expr->GetType(), is_inc, is_postfix);
+  }
   llvm::Value *lhs_value{Builder.CreateLoad(lhs_ptr, is_volatile_)};
 
   if (is_bit_field_) {
@@ -389,7 +390,13 @@ llvm::Value *CodeGen::Deref(const UnaryOpExpr *node) {
       result_ = Builder.CreateInBoundsGEP(lhs, {result_, Builder.getInt64(0)});
     } else {
       result_ = Builder.CreateInBoundsGEP(lhs, {result_});
-      result_ = Builder.CreateLoad(result_, is_volatile_);
+      if (node->GetQualType().IsAtomic()) {
+        result_ =
+            AtomicLoad(result_, llvm::AtomicOrdering::SequentiallyConsistent,
+                       node->GetQualType().IsVolatile());
+      } else {
+        result_ = Builder.CreateLoad(result_, is_volatile_);
+      }
       is_volatile_ = false;
     }
   } else if (IsFuncPointer(node->GetExpr()->GetType()->GetLLVMType())) {
@@ -398,7 +405,11 @@ llvm::Value *CodeGen::Deref(const UnaryOpExpr *node) {
   } else {
     node->GetExpr()->Accept(*this);
     TryEmitLocation(node);
-    if (!node->GetType()->IsArrayTy()) {
+    if (node->GetQualType().IsAtomic()) {
+      result_ =
+          AtomicLoad(result_, llvm::AtomicOrdering::SequentiallyConsistent,
+                     node->GetQualType().IsVolatile());
+    } else if (!node->GetType()->IsArrayTy()) {
       result_ = Builder.CreateLoad(result_, is_volatile_);
     }
     is_volatile_ = false;
@@ -407,6 +418,36 @@ llvm::Value *CodeGen::Deref(const UnaryOpExpr *node) {
   return result_;
 }
 
+// 算术和位运算, 也用于 _Atomic 对象的复合赋值
+llvm::Value *CodeGen::ArithmeticOp(Tag op, llvm::Value *lhs, llvm::Value *rhs,
+                                   bool is_unsigned) {
+  switch (op) {
+    case Tag::kPlus:
+      return AddOp(lhs, rhs, is_unsigned);
+    case Tag::kMinus:
+      return SubOp(lhs, rhs, is_unsigned);
+    case Tag::kStar:
+      return MulOp(lhs, rhs, is_unsigned);
+    case Tag::kSlash:
+      return DivOp(lhs, rhs, is_unsigned);
+    case Tag::kPercent:
+      return ModOp(lhs, rhs, is_unsigned);
+    case Tag::kPipe:
+      return OrOp(lhs, rhs);
+    case Tag::kAmp:
+      return AndOp(lhs, rhs);
+    case Tag::kCaret:
+      return XorOp(lhs, rhs);
+    case Tag::kLessLess:
+      return ShlOp(lhs, rhs);
+    case Tag::kGreaterGreater:
+      return ShrOp(lhs, rhs, is_unsigned);
+    default:
+      assert(false);
+      return nullptr;
+  }
+}
+
 llvm::Value *CodeGen::AddOp(llvm::Value *lhs, llvm::Value *rhs,
                             bool is_unsigned) {
   if (IsIntegerTy(lhs)) {
@@ -539,7 +580,7 @@ llvm::Value *CodeGen::LessEqualOp(llvm::Value *lhs, llvm::Value *rhs,
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
 }
 
 llvm::Value *CodeGen::LessOp(llvm::Value *lhs, llvm::Value *rhs,
@@ -561,7 +602,7 @@ llvm::Value *CodeGen::LessOp(llvm::Value *lhs, llvm::Value *rhs,
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
 }
 
 llvm::Value *CodeGen::GreaterEqualOp(llvm::Value *lhs, llvm::Value *rhs,
@@ -583,7 +624,7 @@ llvm::Value *CodeGen::GreaterEqualOp(llvm::Value *lhs, llvm::Value *rhs,
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
 }
 
 llvm::Value *CodeGen::GreaterOp(llvm::Value *lhs, llvm::Value *rhs,
@@ -605,7 +646,7 @@ llvm::Value *CodeGen::GreaterOp(llvm::Value *lhs, llvm::Value *rhs,
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
 }
 
 llvm::Value *CodeGen::EqualOp(llvm::Value *lhs, llvm::Value *rhs) {
@@ -620,7 +661,7 @@ llvm::Value *CodeGen::EqualOp(llvm::Value *lhs, llvm::Value *rhs) {
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
 }
 
 llvm::Value *CodeGen::NotEqualOp(llvm::Value *lhs, llvm::Value *rhs) {
@@ -635,7 +676,16 @@ llvm::Value *CodeGen::NotEqualOp(llvm::Value *lhs, llvm::Value *rhs) {
     return nullptr;
   }
 
-  return Builder.CreateZExt(value, Builder.getInt32Ty());
+  return CmpResult(value, lhs->getType());
+}
+
+// 向量比较的结果是元素宽度相同的有符号整数向量, 真为 -1
+llvm::Value *CodeGen::CmpResult(llvm::Value *value, llvm::Type *operand_type) {
+  if (auto vector_type{llvm::dyn_cast<llvm::VectorType>(operand_type)}) {
+    return Builder.CreateSExt(value, llvm::VectorType::getInteger(vector_type));
+  } else {
+    return Builder.CreateZExt(value, Builder.getInt32Ty());
+  }
 }
 
 llvm::Value *CodeGen::LogicOrOp(const BinaryOpExpr *node) {
@@ -705,6 +755,28 @@ llvm::Value *CodeGen::LogicAndOp(const BinaryOpExpr *node) {
 }
 
 llvm::Value *CodeGen::AssignOp(const BinaryOpExpr *node) {
+  if (node->GetLHS()->GetQualType().IsAtomic()) {
+    if (auto value{AtomicCompoundAssign(node)}) {
+      return value;
+    }
+  }
+
+  if (IsMemCpyAggregate(node->GetRHS())) {
+    auto lhs_ptr{GetPtr(node->GetLHS())};
+    auto is_volatile{is_volatile_};
+    TryEmitLocation(node);
+
+    CopyAggregate(lhs_ptr, node->GetRHS(), is_volatile);
+    is_volatile_ = false;
+    is_atomic_ = false;
+
+    if (!TestAndClearIgnoreAssignResult()) {
+      return Builder.CreateLoad(lhs_ptr, is_volatile);
+    } else {
+      return lhs_ptr;
+    }
+  }
+
   Load_Struct_Obj();
   node->GetRHS()->Accept(*this);
   Finish_Load();
@@ -735,11 +807,16 @@ llvm::Value *CodeGen::MemberRef(const BinaryOpExpr *node) {
   } else {
     if (type->isArrayTy() || (type->isStructTy() && !load_struct_)) {
       result_ = ptr;
+    } else if (is_atomic_) {
+      result_ = AtomicLoad(ptr, llvm::AtomicOrdering::SequentiallyConsistent,
+                           is_volatile_);
     } else {
       result_ = Builder.CreateLoad(ptr, is_volatile_);
     }
   }
 
+  is_atomic_ = false;
+
   return result_;
 }
 
@@ -775,6 +852,18 @@ llvm::Value *CodeGen::Assign(llvm::Value *lhs_ptr, llvm::Value *rhs,
       bit_field_ = nullptr;
       is_volatile_ = false;
 
+      return lhs_ptr;
+    }
+  } else if (is_atomic_) {
+    AtomicStore(rhs, lhs_ptr, llvm::AtomicOrdering::SequentiallyConsistent,
+                is_volatile_);
+    is_atomic_ = false;
+    is_volatile_ = false;
+
+    // 不重新读取原子对象, 赋值表达式的值就是存储的值
+    if (!TestAndClearIgnoreAssignResult()) {
+      return rhs;
+    } else {
       return lhs_ptr;
     }
   } else {
@@ -791,6 +880,316 @@ llvm::Value *CodeGen::Assign(llvm::Value *lhs_ptr, llvm::Value *rhs,
   }
 }
 
+// 较大的结构体 / 联合体作为 LLVM 的聚合类型加载和存储时, 会被拆分为大量
+// 的标量操作, 此时如果能获取源对象的地址, 直接使用 llvm.memcpy 复制
+// 能放入两个寄存器的结构体仍然使用聚合类型
+bool CodeGen::IsMemCpyAggregate(const Expr *expr) {
+  auto type{expr->GetType()};
+  return type->IsStructOrUnionTy() && type->GetWidth() > 16 &&
+         expr->IsLValue() && !expr->GetQualType().IsAtomic();
+}
+
+void CodeGen::CopyAggregate(llvm::Value *dest, const Expr *src,
+                            bool is_volatile) {
+  auto backup{is_volatile_};
+  is_volatile_ = false;
+  auto src_ptr{GetPtr(src)};
+  is_volatile = is_volatile || is_volatile_;
+
+  auto type{src->GetType()};
+  auto align{llvm::MaybeAlign{static_cast<std::uint64_t>(type->GetAlign())}};
+  Builder.CreateMemCpy(dest, align, src_ptr, align, type->GetWidth(),
+                       is_volatile);
+
+  is_volatile_ = backup;
+  is_atomic_ = false;
+}
+
+// 内存序的值与 __ATOMIC_RELAXED 等预定义宏相同
+// 不是常量时使用最强的 seq_cst
+llvm::AtomicOrdering CodeGen::GetAtomicOrdering(const Expr *order) {
+  auto value{CalcConstantExpr{}.CalcInteger(order, false)};
+  if (!value) {
+    return llvm::AtomicOrdering::SequentiallyConsistent;
+  }
+
+  switch (*value) {
+    case 0:
+      return llvm::AtomicOrdering::Monotonic;
+    // consume 按 acquire 处理
+    case 1:
+    case 2:
+      return llvm::AtomicOrdering::Acquire;
+    case 3:
+      return llvm::AtomicOrdering::Release;
+    case 4:
+      return llvm::AtomicOrdering::AcquireRelease;
+    default:
+      return llvm::AtomicOrdering::SequentiallyConsistent;
+  }
+}
+
+// LLVM 的原子指令要求操作数是宽度为 8 的整数倍的整数,
+// 这里将指针, 浮点数和 _Bool (i1) 转换为等宽的整数再操作
+llvm::Value *CodeGen::ToAtomicInt(llvm::Value *value, llvm::Type *int_type) {
+  auto type{value->getType()};
+
+  if (type == int_type) {
+    return value;
+  } else if (type->isPointerTy()) {
+    return Builder.CreatePtrToInt(value, int_type);
+  } else if (type->isFloatingPointTy()) {
+    return Builder.CreateBitCast(value, int_type);
+  } else {
+    return Builder.CreateZExt(value, int_type);
+  }
+}
+
+llvm::Value *CodeGen::FromAtomicInt(llvm::Value *value, llvm::Type *type) {
+  if (value->getType() == type) {
+    return value;
+  } else if (type->isPointerTy()) {
+    return Builder.CreateIntToPtr(value, type);
+  } else if (type->isFloatingPointTy()) {
+    return Builder.CreateBitCast(value, type);
+  } else {
+    return Builder.CreateTrunc(value, type);
+  }
+}
+
+// 是否为 volatile 由调用者根据所指向的类型给出, 不使用 is_volatile_,
+// e.g. __atomic_load_n 不经过 GetPtr, is_volatile_ 是之前的表达式留下的
+llvm::Value *CodeGen::AtomicLoad(llvm::Value *ptr, llvm::AtomicOrdering order,
+                                 bool is_volatile) {
+  // load 不能使用 release / acq_rel
+  if (order == llvm::AtomicOrdering::Release ||
+      order == llvm::AtomicOrdering::AcquireRelease) {
+    order = llvm::AtomicOrdering::SequentiallyConsistent;
+  }
+
+  auto type{ptr->getType()->getPointerElementType()};
+  auto width{GetLLVMTypeSize(type)};
+  auto int_type{Builder.getIntNTy(width * 8)};
+
+  auto load{Builder.CreateLoad(
+      Builder.CreateBitCast(ptr, int_type->getPointerTo()), is_volatile)};
+  load->setAtomic(order);
+  load->setAlignment(llvm::Align{static_cast<std::uint64_t>(width)});
+
+  return FromAtomicInt(load, type);
+}
+
+llvm::Value *CodeGen::AtomicStore(llvm::Value *value, llvm::Value *ptr,
+                                  llvm::AtomicOrdering order,
+                                  bool is_volatile) {
+  // store 不能使用 acquire / acq_rel
+  if (order == llvm::AtomicOrdering::Acquire ||
+      order == llvm::AtomicOrdering::AcquireRelease) {
+    order = llvm::AtomicOrdering::SequentiallyConsistent;
+  }
+
+  auto width{GetLLVMTypeSize(ptr->getType()->getPointerElementType())};
+  auto int_type{Builder.getIntNTy(width * 8)};
+
+  auto store{Builder.CreateStore(
+      ToAtomicInt(value, int_type),
+      Builder.CreateBitCast(ptr, int_type->getPointerTo()), is_volatile)};
+  store->setAtomic(order);
+  store->setAlignment(llvm::Align{static_cast<std::uint64_t>(width)});
+
+  return store;
+}
+
+llvm::Value *CodeGen::AtomicIncOrDec(llvm::Value *ptr, const Type *type,
+                                     bool is_inc, bool is_postfix) {
+  auto llvm_type{type->GetLLVMType()};
+  auto order{llvm::AtomicOrdering::SequentiallyConsistent};
+
+  if (llvm_type->isFloatingPointTy()) {
+    auto one{llvm::ConstantFP::get(llvm_type, 1.0)};
+    auto old{Builder.CreateAtomicRMW(is_inc ? llvm::AtomicRMWInst::FAdd
+                                            : llvm::AtomicRMWInst::FSub,
+                                     ptr, one, order)};
+
+    if (is_postfix) {
+      return old;
+    } else {
+      return is_inc ? Builder.CreateFAdd(old, one) : Builder.CreateFSub(old, one);
+    }
+  } else if (llvm_type->isPointerTy()) {
+    // 指针按字节偏移, 偏移量为所指向类型的大小
+    auto size{Builder.getInt64(type->PointerGetElementType()->GetWidth())};
+    auto int_ptr{
+        Builder.CreateBitCast(ptr, Builder.getInt64Ty()->getPointerTo())};
+    auto old{Builder.CreateAtomicRMW(
+        is_inc ? llvm::AtomicRMWInst::Add : llvm::AtomicRMWInst::Sub, int_ptr,
+        size, order)};
+    auto old_ptr{Builder.CreateIntToPtr(old, llvm_type)};
+
+    if (is_postfix) {
+      return old_ptr;
+    } else {
+      return Builder.CreateInBoundsGEP(
+          old_ptr, {is_inc ? Builder.getInt64(1) : Builder.getInt64(-1)});
+    }
+  } else if (llvm_type->isIntegerTy(1)) {
+    // atomicrmw 不能用于 i1, 按 i8 进行: ++ 的结果总是 1, -- 将原值取反
+    auto i8{Builder.getInt8Ty()};
+    auto old{Builder.CreateIsNotNull(Builder.CreateAtomicRMW(
+        is_inc ? llvm::AtomicRMWInst::Xchg : llvm::AtomicRMWInst::Xor,
+        Builder.CreateBitCast(ptr, i8->getPointerTo()), Builder.getInt8(1),
+        order))};
+
+    if (is_postfix) {
+      return old;
+    } else {
+      return is_inc ? Builder.getTrue() : Builder.CreateNot(old);
+    }
+  } else {
+    auto one{llvm::ConstantInt::get(llvm_type, 1)};
+    auto old{Builder.CreateAtomicRMW(
+        is_inc ? llvm::AtomicRMWInst::Add : llvm::AtomicRMWInst::Sub, ptr, one,
+        order)};
+
+    if (is_postfix) {
+      return old;
+    } else {
+      return is_inc ? Builder.CreateAdd(old, one) : Builder.CreateSub(old, one);
+    }
+  }
+}
+
+// 复合赋值运算符被转换为了 a = (T)((U)a op b), a 是 _Atomic 限定时整个
+// 读-改-写必须是原子的(C11 6.5.16.2p3), 整数的 + - & | ^ 使用一条
+// atomicrmw 指令, 其他情况(e.g. *= / <<= / 浮点数 / 指针)使用 cmpxchg 循环
+llvm::Value *CodeGen::AtomicCompoundAssign(const BinaryOpExpr *node) {
+  auto lhs{node->GetLHS()};
+
+  std::vector<const TypeCastExpr *> result_casts;
+  auto rhs{node->GetRHS()};
+  while (auto cast{dynamic_cast<const TypeCastExpr *>(rhs)}) {
+    result_casts.push_back(cast);
+    rhs = cast->GetExpr();
+  }
+
+  auto binary{dynamic_cast<const BinaryOpExpr *>(rhs)};
+  if (!binary) {
+    return nullptr;
+  }
+
+  std::vector<const TypeCastExpr *> lhs_casts;
+  auto binary_lhs{binary->GetLHS()};
+  while (auto cast{dynamic_cast<const TypeCastExpr *>(binary_lhs)}) {
+    lhs_casts.push_back(cast);
+    binary_lhs = cast->GetExpr();
+  }
+
+  if (binary_lhs != lhs) {
+    return nullptr;
+  }
+
+  std::optional<llvm::AtomicRMWInst::BinOp> rmw_op;
+  switch (binary->GetOp()) {
+    case Tag::kPlus:
+      rmw_op = llvm::AtomicRMWInst::Add;
+      break;
+    case Tag::kMinus:
+      rmw_op = llvm::AtomicRMWInst::Sub;
+      break;
+    case Tag::kAmp:
+      rmw_op = llvm::AtomicRMWInst::And;
+      break;
+    case Tag::kPipe:
+      rmw_op = llvm::AtomicRMWInst::Or;
+      break;
+    case Tag::kCaret:
+      rmw_op = llvm::AtomicRMWInst::Xor;
+      break;
+    case Tag::kStar:
+    case Tag::kSlash:
+    case Tag::kPercent:
+    case Tag::kLessLess:
+    case Tag::kGreaterGreater:
+      break;
+    default:
+      return nullptr;
+  }
+
+  // atomicrmw 不能用于 i1
+  auto type{lhs->GetType()};
+  if (!type->IsIntegerTy() || type->IsBoolTy()) {
+    rmw_op.reset();
+  }
+
+  binary->GetRHS()->Accept(*this);
+  auto value{result_};
+
+  auto ptr{GetPtr(lhs)};
+  auto is_volatile{is_volatile_};
+  is_atomic_ = false;
+  is_volatile_ = false;
+
+  TryEmitLocation(node);
+
+  auto order{llvm::AtomicOrdering::SequentiallyConsistent};
+  llvm::Value *new_value{};
+
+  if (rmw_op) {
+    value = CastTo(value, type->GetLLVMType(),
+                   binary->GetRHS()->GetType()->IsUnsigned());
+    auto rmw{Builder.CreateAtomicRMW(*rmw_op, ptr, value, order)};
+    rmw->setVolatile(is_volatile);
+    new_value = ArithmeticOp(binary->GetOp(), rmw, value, true);
+  } else {
+    // 与非原子对象相同地计算新值, 期间值被其他线程修改时重试
+    auto llvm_type{type->GetLLVMType()};
+    auto int_type{Builder.getIntNTy(GetLLVMTypeSize(llvm_type) * 8)};
+    auto int_ptr{Builder.CreateBitCast(ptr, int_type->getPointerTo())};
+
+    auto old{AtomicLoad(ptr, order, is_volatile)};
+    auto entry_block{Builder.GetInsertBlock()};
+    auto loop_block{CreateBasicBlock("atomic.cmpxchg")};
+    auto end_block{CreateBasicBlock("atomic.cmpxchg.end")};
+
+    EmitBlock(loop_block);
+    auto phi{Builder.CreatePHI(llvm_type, 2)};
+    phi->addIncoming(old, entry_block);
+
+    new_value = phi;
+    for (auto iter{std::rbegin(lhs_casts)}; iter != std::rend(lhs_casts);
+         ++iter) {
+      new_value = CastTo(new_value, (*iter)->GetCastToType()->GetLLVMType(),
+                         (*iter)->GetExpr()->GetType()->IsUnsigned());
+    }
+    new_value = ArithmeticOp(binary->GetOp(), new_value, value,
+                             binary->GetLHS()->GetType()->IsUnsigned());
+    for (auto iter{std::rbegin(result_casts)};
+         iter != std::rend(result_casts); ++iter) {
+      new_value = CastTo(new_value, (*iter)->GetCastToType()->GetLLVMType(),
+                         (*iter)->GetExpr()->GetType()->IsUnsigned());
+    }
+
+    auto cmpxchg{Builder.CreateAtomicCmpXchg(
+        int_ptr, ToAtomicInt(phi, int_type), ToAtomicInt(new_value, int_type),
+        order, order)};
+    cmpxchg->setVolatile(is_volatile);
+
+    phi->addIncoming(
+        FromAtomicInt(Builder.CreateExtractValue(cmpxchg, 0), llvm_type),
+        Builder.GetInsertBlock());
+    Builder.CreateCondBr(Builder.CreateExtractValue(cmpxchg, 1), end_block,
+                         loop_block);
+
+    EmitBlock(end_block);
+  }
+
+  if (TestAndClearIgnoreAssignResult()) {
+    return ptr;
+  } else {
+    return new_value;
+  }
+}
+
 bool CodeGen::MayCallBuiltinFunc(const FuncCallExpr *node) {
   auto func_name{node->GetFuncType()->FuncGetName()};
 
@@ -811,6 +1210,25 @@ bool CodeGen::MayCallBuiltinFunc(const FuncCallExpr *node) {
   } else if (func_name == "__sync_synchronize") {
     result_ = SyncSynchronize();
     return true;
+  } else if (AtomicBuiltins.count(func_name)) {
+    result_ = AtomicBuiltin(node);
+    return true;
+  } else if (func_name == "__atomic_thread_fence") {
+    result_ = AtomicFence(node->GetArgs().front(), false);
+    return true;
+  } else if (func_name == "__atomic_signal_fence") {
+    result_ = AtomicFence(node->GetArgs().front(), true);
+    return true;
+  } else if (func_name == "__atomic_test_and_set") {
+    result_ = AtomicTestAndSet(node->GetArgs()[0], node->GetArgs()[1]);
+    return true;
+  } else if (func_name == "__atomic_clear") {
+    result_ = AtomicClear(node->GetArgs()[0], node->GetArgs()[1]);
+    return true;
+  } else if (func_name == "__atomic_always_lock_free" ||
+             func_name == "__atomic_is_lock_free") {
+    result_ = AtomicIsLockFree(node->GetArgs().front());
+    return true;
   } else if (func_name == "__builtin_alloca") {
     result_ = Alloc(node->GetArgs().front());
     return true;
@@ -823,8 +1241,9 @@ bool CodeGen::MayCallBuiltinFunc(const FuncCallExpr *node) {
   } else if (func_name == "__builtin_ctz") {
     result_ = Ctz(node->GetArgs().front());
     return true;
-  } else if (func_name == "__builtin_expect") {
-    node->GetArgs().front()->Accept(*this);
+  } else if (func_name == "__builtin_expect" ||
+             func_name == "__builtin_expect_with_probability") {
+    result_ = Expect(node);
     return true;
   } else if (func_name == "__builtin_isinf_sign") {
     result_ = IsInfSign(node->GetArgs().front());
@@ -841,6 +1260,48 @@ bool CodeGen::MayCallBuiltinFunc(const FuncCallExpr *node) {
   } else if (func_name == "__builtin_bswap64") {
     result_ = Bswap64(node->GetArgs().front());
     return true;
+  } else if (func_name.find("__builtin_rotateleft") == 0) {
+    result_ = Rotate(node, true);
+    return true;
+  } else if (func_name.find("__builtin_rotateright") == 0) {
+    result_ = Rotate(node, false);
+    return true;
+  } else if (func_name.find("__builtin_ffs") == 0) {
+    result_ = Ffs(node->GetArgs().front());
+    return true;
+  } else if (func_name.find("__builtin_parity") == 0) {
+    result_ = Parity(node->GetArgs().front());
+    return true;
+  } else if (func_name == "__builtin_prefetch") {
+    result_ = Prefetch(node);
+    return true;
+  } else if (func_name == "__builtin_unreachable") {
+    result_ = Unreachable();
+    return true;
+  } else if (func_name == "__builtin_assume_aligned") {
+    result_ = AssumeAligned(node);
+    return true;
+  } else if (func_name == "__builtin_constant_p") {
+    result_ = ConstantP(node->GetArgs().front());
+    return true;
+  } else if (func_name == "__builtin_memcpy") {
+    result_ = MemCpy(node, false);
+    return true;
+  } else if (func_name == "__builtin_memmove") {
+    result_ = MemCpy(node, true);
+    return true;
+  } else if (func_name == "__builtin_memset") {
+    result_ = MemSet(node);
+    return true;
+  } else if (OverflowBuiltins.count(func_name)) {
+    result_ = OverflowBuiltin(node);
+    return true;
+  } else if (func_name == "__builtin_shufflevector") {
+    result_ = ShuffleVector(node);
+    return true;
+  } else if (func_name == "__builtin_shuffle") {
+    result_ = Shuffle(node);
+    return true;
   } else {
     return false;
   }
@@ -884,11 +1345,15 @@ llvm::Value *CodeGen::VaArg(Expr *arg, llvm::Type *type) {
   arg->Accept(*this);
   auto ptr{result_};
 
+  // __int128 占用两个通用寄存器, 在栈上按 16 字节对齐
+  auto is_int128{type->isIntegerTy(128)};
+  std::int32_t gp_size{is_int128 ? 16 : 8};
+
   if (type->isIntegerTy() || type->isPointerTy()) {
     offset_ptr = Builder.CreateStructGEP(ptr, 0);
     offset = Builder.CreateLoad(offset_ptr);
     result_ = Builder.CreateICmpULE(
-        offset, llvm::ConstantInt::get(Builder.getInt32Ty(), 40));
+        offset, llvm::ConstantInt::get(Builder.getInt32Ty(), 48 - gp_size));
   } else if (type->isFloatingPointTy()) {
     offset_ptr = Builder.CreateStructGEP(ptr, 1);
     offset = Builder.CreateLoad(offset_ptr);
@@ -908,7 +1373,7 @@ llvm::Value *CodeGen::VaArg(Expr *arg, llvm::Type *type) {
 
   if (type->isIntegerTy() || type->isPointerTy()) {
     result_ = Builder.CreateAdd(
-        offset, llvm::ConstantInt::get(Builder.getInt32Ty(), 8));
+        offset, llvm::ConstantInt::get(Builder.getInt32Ty(), gp_size));
   } else if (type->isFloatingPointTy()) {
     result_ = Builder.CreateAdd(
         offset, llvm::ConstantInt::get(Builder.getInt32Ty(), 16));
@@ -922,9 +1387,15 @@ llvm::Value *CodeGen::VaArg(Expr *arg, llvm::Type *type) {
   EmitBlock(rhs_block);
   auto pp{Builder.CreateStructGEP(ptr, 2)};
   result_ = Builder.CreateLoad(pp);
+  if (is_int128) {
+    result_ = Builder.CreatePtrToInt(result_, Builder.getInt64Ty());
+    result_ = Builder.CreateAdd(result_, Builder.getInt64(15));
+    result_ = Builder.CreateAnd(result_, Builder.getInt64(-16));
+    result_ = Builder.CreateIntToPtr(result_, Builder.getInt8PtrTy());
+  }
   auto result_ptr2{Builder.CreateBitCast(result_, type->getPointerTo())};
-  result_ = Builder.CreateGEP(result_,
-                              llvm::ConstantInt::get(Builder.getInt32Ty(), 8));
+  result_ = Builder.CreateGEP(
+      result_, llvm::ConstantInt::get(Builder.getInt32Ty(), gp_size));
   Builder.CreateStore(result_, pp);
   EmitBranch(end_block);
 
@@ -960,6 +1431,250 @@ llvm::Value *CodeGen::SyncSynchronize() {
                              llvm::SyncScope::System);
 }
 
+llvm::Value *CodeGen::AtomicBuiltin(const FuncCallExpr *node) {
+  auto name{node->GetFuncType()->FuncGetName()};
+  const auto &args{node->GetArgs()};
+
+  auto pointee{args.front()->GetType()->PointerGetElementType()};
+  auto type{pointee->GetLLVMType()};
+  auto is_volatile{pointee.IsVolatile()};
+  auto width{GetLLVMTypeSize(type)};
+  auto int_type{Builder.getIntNTy(width * 8)};
+  auto int_ptr_type{int_type->getPointerTo()};
+
+  auto emit_value{[&](Expr *arg) {
+    arg->Accept(*this);
+    return ToAtomicInt(result_, int_type);
+  }};
+  auto emit_ptr{[&](Expr *arg) {
+    arg->Accept(*this);
+    return Builder.CreateBitCast(result_, int_ptr_type);
+  }};
+
+  auto ptr{emit_ptr(args[0])};
+  auto is_sync{name.find("__sync_") == 0};
+
+  if (name == "__atomic_load_n" || name == "__atomic_load") {
+    auto order{GetAtomicOrdering(args.back())};
+    TryEmitLocation(node);
+    auto value{AtomicLoad(ptr, order, is_volatile)};
+
+    if (name == "__atomic_load_n") {
+      return FromAtomicInt(value, type);
+    } else {
+      return Builder.CreateStore(value, emit_ptr(args[1]));
+    }
+  } else if (name == "__atomic_store_n" || name == "__atomic_store") {
+    llvm::Value *value{};
+    if (name == "__atomic_store_n") {
+      value = emit_value(args[1]);
+    } else {
+      value = Builder.CreateLoad(emit_ptr(args[1]));
+    }
+
+    TryEmitLocation(node);
+    return AtomicStore(value, ptr, GetAtomicOrdering(args.back()),
+                       is_volatile);
+  } else if (name == "__sync_lock_release") {
+    TryEmitLocation(node);
+    return AtomicStore(llvm::ConstantInt::get(int_type, 0), ptr,
+                       llvm::AtomicOrdering::Release, is_volatile);
+  } else if (name == "__atomic_compare_exchange_n" ||
+             name == "__atomic_compare_exchange" ||
+             name == "__sync_bool_compare_and_swap" ||
+             name == "__sync_val_compare_and_swap") {
+    llvm::Value *expected_ptr{}, *expected{}, *desired{};
+    auto success_order{llvm::AtomicOrdering::SequentiallyConsistent};
+    auto is_weak{false};
+
+    if (is_sync) {
+      expected = emit_value(args[1]);
+      desired = emit_value(args[2]);
+    } else {
+      expected_ptr = emit_ptr(args[1]);
+      expected = Builder.CreateLoad(expected_ptr);
+      if (name == "__atomic_compare_exchange_n") {
+        desired = emit_value(args[2]);
+      } else {
+        desired = Builder.CreateLoad(emit_ptr(args[2]));
+      }
+
+      if (auto weak{CalcConstantExpr{}.CalcInteger(args[3], false)}) {
+        is_weak = *weak;
+      }
+      success_order = GetAtomicOrdering(args[4]);
+    }
+
+    TryEmitLocation(node);
+
+    // 失败时的内存序不能强于成功时的内存序, 也不能是 release / acq_rel
+    auto cmpxchg{Builder.CreateAtomicCmpXchg(
+        ptr, expected, desired, success_order,
+        llvm::AtomicCmpXchgInst::getStrongestFailureOrdering(success_order))};
+    cmpxchg->setWeak(is_weak);
+
+    auto old{Builder.CreateExtractValue(cmpxchg, 0)};
+    auto success{Builder.CreateExtractValue(cmpxchg, 1)};
+
+    if (name == "__sync_val_compare_and_swap") {
+      return FromAtomicInt(old, type);
+    } else if (name == "__sync_bool_compare_and_swap") {
+      return success;
+    }
+
+    // 失败时将当前值写回 expected
+    auto store_block{CreateBasicBlock("cmpxchg.store.expected")};
+    auto end_block{CreateBasicBlock("cmpxchg.continue")};
+
+    Builder.CreateCondBr(success, end_block, store_block);
+
+    EmitBlock(store_block);
+    Builder.CreateStore(old, expected_ptr);
+    EmitBranch(end_block);
+
+    EmitBlock(end_block);
+    return success;
+  }
+
+  llvm::AtomicRMWInst::BinOp op;
+  // 是否返回操作之后的值
+  auto return_new{false};
+
+  if (name == "__atomic_exchange_n" || name == "__atomic_exchange" ||
+      name == "__sync_lock_test_and_set") {
+    op = llvm::AtomicRMWInst::Xchg;
+  } else {
+    auto op_name{name};
+    if (is_sync) {
+      // __sync_fetch_and_add / __sync_add_and_fetch
+      if (op_name.find("__sync_fetch_and_") == 0) {
+        op_name = op_name.substr(std::size("__sync_fetch_and_") - 1);
+      } else {
+        op_name = op_name.substr(std::size("__sync_") - 1);
+        op_name = op_name.substr(0, op_name.find('_'));
+        return_new = true;
+      }
+    } else {
+      // __atomic_fetch_add / __atomic_add_fetch
+      if (op_name.find("__atomic_fetch_") == 0) {
+        op_name = op_name.substr(std::size("__atomic_fetch_") - 1);
+      } else {
+        op_name = op_name.substr(std::size("__atomic_") - 1);
+        op_name = op_name.substr(0, op_name.find('_'));
+        return_new = true;
+      }
+    }
+
+    if (op_name == "add") {
+      op = llvm::AtomicRMWInst::Add;
+    } else if (op_name == "sub") {
+      op = llvm::AtomicRMWInst::Sub;
+    } else if (op_name == "and") {
+      op = llvm::AtomicRMWInst::And;
+    } else if (op_name == "or") {
+      op = llvm::AtomicRMWInst::Or;
+    } else if (op_name == "xor") {
+      op = llvm::AtomicRMWInst::Xor;
+    } else if (op_name == "nand") {
+      op = llvm::AtomicRMWInst::Nand;
+    } else {
+      assert(false);
+      return nullptr;
+    }
+  }
+
+  llvm::Value *value{};
+  if (name == "__atomic_exchange") {
+    value = Builder.CreateLoad(emit_ptr(args[1]));
+  } else {
+    value = emit_value(args[1]);
+  }
+
+  llvm::AtomicOrdering order;
+  if (name == "__sync_lock_test_and_set") {
+    order = llvm::AtomicOrdering::Acquire;
+  } else if (is_sync) {
+    order = llvm::AtomicOrdering::SequentiallyConsistent;
+  } else {
+    order = GetAtomicOrdering(args.back());
+  }
+
+  TryEmitLocation(node);
+  llvm::Value *old{Builder.CreateAtomicRMW(op, ptr, value, order)};
+
+  if (name == "__atomic_exchange") {
+    return Builder.CreateStore(old, emit_ptr(args[2]));
+  }
+
+  if (return_new) {
+    switch (op) {
+      case llvm::AtomicRMWInst::Add:
+        old = Builder.CreateAdd(old, value);
+        break;
+      case llvm::AtomicRMWInst::Sub:
+        old = Builder.CreateSub(old, value);
+        break;
+      case llvm::AtomicRMWInst::And:
+        old = Builder.CreateAnd(old, value);
+        break;
+      case llvm::AtomicRMWInst::Or:
+        old = Builder.CreateOr(old, value);
+        break;
+      case llvm::AtomicRMWInst::Xor:
+        old = Builder.CreateXor(old, value);
+        break;
+      case llvm::AtomicRMWInst::Nand:
+        old = Builder.CreateNot(Builder.CreateAnd(old, value));
+        break;
+      default:
+        assert(false);
+    }
+  }
+
+  return FromAtomicInt(old, type);
+}
+
+llvm::Value *CodeGen::AtomicFence(Expr *order, bool is_signal) {
+  auto ordering{GetAtomicOrdering(order)};
+
+  // relaxed 的 fence 没有作用
+  if (ordering == llvm::AtomicOrdering::Monotonic) {
+    return nullptr;
+  }
+
+  return Builder.CreateFence(ordering, is_signal ? llvm::SyncScope::SingleThread
+                                                 : llvm::SyncScope::System);
+}
+
+llvm::Value *CodeGen::AtomicTestAndSet(Expr *arg, Expr *order) {
+  arg->Accept(*this);
+  auto ptr{Builder.CreateBitCast(result_, Builder.getInt8PtrTy())};
+
+  auto old{Builder.CreateAtomicRMW(llvm::AtomicRMWInst::Xchg, ptr,
+                                   Builder.getInt8(1),
+                                   GetAtomicOrdering(order))};
+  return Builder.CreateICmpNE(old, Builder.getInt8(0));
+}
+
+llvm::Value *CodeGen::AtomicClear(Expr *arg, Expr *order) {
+  arg->Accept(*this);
+  auto ptr{Builder.CreateBitCast(result_, Builder.getInt8PtrTy())};
+
+  return AtomicStore(Builder.getInt8(0), ptr, GetAtomicOrdering(order),
+                     arg->GetType()->PointerGetElementType().IsVolatile());
+}
+
+// 宽度为 1 / 2 / 4 / 8 字节的对象总是无锁的
+llvm::Value *CodeGen::AtomicIsLockFree(Expr *size) {
+  auto value{CalcConstantExpr{}.CalcInteger(size, false)};
+
+  if (value && (*value == 1 || *value == 2 || *value == 4 || *value == 8)) {
+    return Builder.getTrue();
+  } else {
+    return Builder.getFalse();
+  }
+}
+
 llvm::Value *CodeGen::Alloc(Expr *arg) {
   arg->Accept(*this);
   return Builder.CreateAlloca(Builder.getInt8Ty(), result_);
@@ -1085,4 +1800,383 @@ llvm::Value *CodeGen::Bswap64(Expr *arg) {
   return Builder.CreateCall(bswap_i64, {result_});
 }
 
+// rotl(x, n) == fshl(x, x, n)
+llvm::Value *CodeGen::Rotate(const FuncCallExpr *node, bool is_left) {
+  const auto &args{node->GetArgs()};
+
+  args[0]->Accept(*this);
+  auto value{result_};
+  args[1]->Accept(*this);
+  auto amount{result_};
+
+  auto intrinsic{llvm::Intrinsic::getDeclaration(
+      Module.get(), is_left ? llvm::Intrinsic::fshl : llvm::Intrinsic::fshr,
+      {value->getType()})};
+
+  return Builder.CreateCall(intrinsic, {value, value, amount});
+}
+
+// ffs(x) == x == 0 ? 0 : cttz(x) + 1
+llvm::Value *CodeGen::Ffs(Expr *arg) {
+  arg->Accept(*this);
+  auto value{result_};
+  auto type{value->getType()};
+
+  auto cttz{llvm::Intrinsic::getDeclaration(Module.get(),
+                                            llvm::Intrinsic::cttz, {type})};
+
+  auto index{
+      Builder.CreateAdd(Builder.CreateCall(cttz, {value, Builder.getTrue()}),
+                        llvm::ConstantInt::get(type, 1))};
+  auto is_zero{Builder.CreateICmpEQ(value, llvm::ConstantInt::get(type, 0))};
+  auto result{Builder.CreateSelect(is_zero, llvm::ConstantInt::get(type, 0),
+                                   index)};
+
+  return Builder.CreateIntCast(result, Builder.getInt32Ty(), false);
+}
+
+// parity(x) == ctpop(x) & 1
+llvm::Value *CodeGen::Parity(Expr *arg) {
+  arg->Accept(*this);
+  auto value{result_};
+  auto type{value->getType()};
+
+  auto ctpop{llvm::Intrinsic::getDeclaration(Module.get(),
+                                             llvm::Intrinsic::ctpop, {type})};
+
+  auto result{Builder.CreateAnd(Builder.CreateCall(ctpop, {value}),
+                                llvm::ConstantInt::get(type, 1))};
+  return Builder.CreateIntCast(result, Builder.getInt32Ty(), false);
+}
+
+llvm::Value *CodeGen::Expect(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+
+  args[0]->Accept(*this);
+  auto value{result_};
+
+  // 预期值不是常量时忽略
+  auto expected{CalcConstantExpr{}.CalcInteger(args[1], false)};
+  if (!expected) {
+    return value;
+  }
+
+  if (std::size(args) == 2) {
+    static auto func_type{llvm::FunctionType::get(
+        Builder.getInt64Ty(), {Builder.getInt64Ty(), Builder.getInt64Ty()},
+        false)};
+
+    static auto expect_i64{llvm::Function::Create(
+        func_type, llvm::Function::ExternalLinkage, "llvm.expect.i64",
+        Module.get())};
+
+    return Builder.CreateCall(expect_i64,
+                              {value, Builder.getInt64(*expected)});
+  }
+
+  auto probability{llvm::dyn_cast_or_null<llvm::ConstantFP>(
+      CalcConstantExpr{}.Calc(args[2]))};
+  if (!probability) {
+    Error(args[2], "probability must be constant floating-point expression");
+  }
+
+  auto val{probability->getValueAPF().convertToDouble()};
+  if (!(val >= 0.0 && val <= 1.0)) {
+    Error(args[2], "probability must be in the range [0.0, 1.0]");
+  }
+
+  static auto func_type{llvm::FunctionType::get(
+      Builder.getInt64Ty(),
+      {Builder.getInt64Ty(), Builder.getInt64Ty(), Builder.getDoubleTy()},
+      false)};
+
+  static auto expect_with_probability_i64{llvm::Function::Create(
+      func_type, llvm::Function::ExternalLinkage,
+      "llvm.expect.with.probability.i64", Module.get())};
+
+  return Builder.CreateCall(expect_with_probability_i64,
+                            {value, Builder.getInt64(*expected), probability});
+}
+
+llvm::Value *CodeGen::Prefetch(const FuncCallExpr *node) {
+  static auto func_type{llvm::FunctionType::get(
+      Builder.getVoidTy(),
+      {Builder.getInt8PtrTy(), Builder.getInt32Ty(), Builder.getInt32Ty(),
+       Builder.getInt32Ty()},
+      false)};
+
+  static auto prefetch{llvm::Function::Create(func_type,
+                                              llvm::Function::ExternalLinkage,
+                                              "llvm.prefetch.p0i8",
+                                              Module.get())};
+
+  const auto &args{node->GetArgs()};
+
+  // rw 默认为 0(读), locality 默认为 3(保持在所有级别的缓存中)
+  std::int64_t rw{0}, locality{3};
+  if (std::size(args) > 1) {
+    rw = *CalcConstantExpr{}.CalcInteger(args[1]);
+    if (rw != 0 && rw != 1) {
+      Error(args[1], "argument must be 0 or 1");
+    }
+  }
+  if (std::size(args) > 2) {
+    locality = *CalcConstantExpr{}.CalcInteger(args[2]);
+    if (locality < 0 || locality > 3) {
+      Error(args[2], "argument must be in the range [0, 3]");
+    }
+  }
+  if (std::size(args) > 3) {
+    Error(node, "too many arguments for function call");
+  }
+
+  args[0]->Accept(*this);
+  auto ptr{Builder.CreateBitCast(result_, Builder.getInt8PtrTy())};
+
+  // 最后一个参数为 1 表示数据缓存
+  return Builder.CreateCall(
+      prefetch, {ptr, Builder.getInt32(rw), Builder.getInt32(locality),
+                 Builder.getInt32(1)});
+}
+
+llvm::Value *CodeGen::Unreachable() {
+  Builder.CreateUnreachable();
+  // 之后的代码都不可访问, 但当前表达式的剩余部分仍需要一个插入点
+  EmitBlock(CreateBasicBlock("unreachable.cont"));
+  return nullptr;
+}
+
+llvm::Value *CodeGen::AssumeAligned(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+
+  auto align{*CalcConstantExpr{}.CalcInteger(args[1])};
+  if (align <= 0 || !llvm::isPowerOf2_64(align)) {
+    Error(args[1], "requested alignment is not a power of 2");
+  }
+  if (std::size(args) > 3) {
+    Error(node, "too many arguments for function call");
+  }
+
+  args[0]->Accept(*this);
+  auto ptr{Builder.CreateBitCast(result_, Builder.getInt8PtrTy())};
+
+  llvm::Value *offset{};
+  if (std::size(args) == 3) {
+    args[2]->Accept(*this);
+    offset = Builder.CreateSExtOrTrunc(result_, Builder.getInt64Ty());
+  }
+
+  Builder.CreateAlignmentAssumption(Module->getDataLayout(), ptr,
+                                    static_cast<unsigned>(align), offset);
+  return ptr;
+}
+
+// 参数不会被求值
+llvm::Value *CodeGen::ConstantP(Expr *arg) {
+  return Builder.getInt32(CalcConstantExpr{}.Calc(arg) != nullptr);
+}
+
+llvm::Value *CodeGen::MemCpy(const FuncCallExpr *node, bool is_move) {
+  const auto &args{node->GetArgs()};
+
+  args[0]->Accept(*this);
+  auto dest{result_};
+  args[1]->Accept(*this);
+  auto src{result_};
+  args[2]->Accept(*this);
+  auto size{result_};
+
+  // 参数是 void *, 与 memset 相同, 不是 volatile 的访问
+  TryEmitLocation(node);
+  if (is_move) {
+    Builder.CreateMemMove(dest, llvm::MaybeAlign{}, src, llvm::MaybeAlign{},
+                          size, false);
+  } else {
+    Builder.CreateMemCpy(dest, llvm::MaybeAlign{}, src, llvm::MaybeAlign{},
+                         size, false);
+  }
+
+  return dest;
+}
+
+llvm::Value *CodeGen::MemSet(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+
+  args[0]->Accept(*this);
+  auto dest{result_};
+  args[1]->Accept(*this);
+  auto value{Builder.CreateTrunc(result_, Builder.getInt8Ty())};
+  args[2]->Accept(*this);
+  auto size{result_};
+
+  TryEmitLocation(node);
+  Builder.CreateMemSet(dest, value, size, llvm::MaybeAlign{});
+
+  return dest;
+}
+
+// 和 clang 一样, 先将参数扩展到能表示参数和结果所有值的整数类型上计算,
+// 然后检查截断到结果类型时是否丢失了信息
+llvm::Value *CodeGen::OverflowBuiltin(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+  const auto &[signed_id, unsigned_id]{
+      OverflowBuiltins.at(node->GetFuncType()->FuncGetName())};
+
+  auto lhs_type{args[0]->GetType()};
+  auto rhs_type{args[1]->GetType()};
+  auto result_type{args[2]->GetType()->PointerGetElementType().GetType()};
+
+  auto is_signed{!lhs_type->IsUnsigned() || !rhs_type->IsUnsigned() ||
+                 !result_type->IsUnsigned()};
+  std::int32_t width{};
+  for (const auto &type : {lhs_type, rhs_type, result_type}) {
+    // 有符号数需要多一位来表示无符号数
+    width = std::max(width, type->GetWidth() * 8 +
+                                (is_signed && type->IsUnsigned() ? 1 : 0));
+  }
+  auto encompassing_type{Builder.getIntNTy(width)};
+
+  auto emit_arg{[&](Expr *arg) {
+    arg->Accept(*this);
+    return Builder.CreateIntCast(result_, encompassing_type,
+                                 !arg->GetType()->IsUnsigned());
+  }};
+
+  auto lhs{emit_arg(args[0])};
+  auto rhs{emit_arg(args[1])};
+  args[2]->Accept(*this);
+  auto result_ptr{result_};
+
+  TryEmitLocation(node);
+  llvm::Value *result{}, *overflow{};
+  if (is_signed && signed_id == llvm::Intrinsic::smul_with_overflow &&
+      width > 64) {
+    std::tie(result, overflow) = SignedWideMulOverflow(lhs, rhs);
+  } else {
+    auto intrinsic{llvm::Intrinsic::getDeclaration(
+        Module.get(), is_signed ? signed_id : unsigned_id,
+        {encompassing_type})};
+
+    auto call{Builder.CreateCall(intrinsic, {lhs, rhs})};
+    result = Builder.CreateExtractValue(call, 0);
+    overflow = Builder.CreateExtractValue(call, 1);
+  }
+
+  auto result_llvm_type{result_type->GetLLVMType()};
+  if (encompassing_type != result_llvm_type) {
+    auto truncated{Builder.CreateTrunc(result, result_llvm_type)};
+    auto extended{Builder.CreateIntCast(truncated, encompassing_type,
+                                        !result_type->IsUnsigned())};
+    overflow =
+        Builder.CreateOr(overflow, Builder.CreateICmpNE(extended, result));
+    result = truncated;
+  }
+
+  Builder.CreateStore(result, result_ptr);
+  return overflow;
+}
+
+// 超过 64 位的 llvm.smul.with.overflow 会调用 compiler-rt 中的 __muloti4,
+// libgcc 中没有该函数, 这里转换为绝对值的无符号乘法, 再根据符号检查范围
+std::pair<llvm::Value *, llvm::Value *> CodeGen::SignedWideMulOverflow(
+    llvm::Value *lhs, llvm::Value *rhs) {
+  auto type{llvm::cast<llvm::IntegerType>(lhs->getType())};
+  auto zero{llvm::ConstantInt::get(type, 0)};
+
+  auto lhs_neg{Builder.CreateICmpSLT(lhs, zero)};
+  auto rhs_neg{Builder.CreateICmpSLT(rhs, zero)};
+  auto lhs_abs{Builder.CreateSelect(lhs_neg, Builder.CreateNeg(lhs), lhs)};
+  auto rhs_abs{Builder.CreateSelect(rhs_neg, Builder.CreateNeg(rhs), rhs)};
+
+  auto intrinsic{llvm::Intrinsic::getDeclaration(
+      Module.get(), llvm::Intrinsic::umul_with_overflow, {type})};
+  auto call{Builder.CreateCall(intrinsic, {lhs_abs, rhs_abs})};
+  auto abs_result{Builder.CreateExtractValue(call, 0)};
+  auto overflow{Builder.CreateExtractValue(call, 1)};
+
+  // 结果为负数时绝对值最大可以为 2^(n-1), 否则为 2^(n-1) - 1
+  auto is_neg{Builder.CreateXor(lhs_neg, rhs_neg)};
+  auto limit{Builder.CreateAdd(
+      llvm::ConstantInt::get(type, llvm::APInt::getSignedMaxValue(
+                                       type->getBitWidth())),
+      Builder.CreateZExt(is_neg, type))};
+  overflow = Builder.CreateOr(overflow,
+                              Builder.CreateICmpUGT(abs_result, limit));
+
+  auto result{Builder.CreateSelect(is_neg, Builder.CreateNeg(abs_result),
+                                   abs_result)};
+  return {result, overflow};
+}
+
+llvm::Value *CodeGen::ShuffleVector(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+
+  args[0]->Accept(*this);
+  auto lhs{result_};
+  args[1]->Accept(*this);
+  auto rhs{result_};
+
+  std::vector<std::int32_t> mask;
+  for (std::size_t i{2}; i < std::size(args); ++i) {
+    mask.push_back(*CalcConstantExpr{}.CalcInteger(args[i]));
+  }
+
+  TryEmitLocation(node);
+  return Builder.CreateShuffleVector(lhs, rhs, mask);
+}
+
+// 掩码是常量时生成 shufflevector, 否则逐个元素取出再插入
+llvm::Value *CodeGen::Shuffle(const FuncCallExpr *node) {
+  const auto &args{node->GetArgs()};
+  auto has_two_vector{std::size(args) == 3};
+
+  args[0]->Accept(*this);
+  auto lhs{result_};
+  auto rhs{lhs};
+  if (has_two_vector) {
+    args[1]->Accept(*this);
+    rhs = result_;
+  }
+  args.back()->Accept(*this);
+  auto mask{result_};
+
+  TryEmitLocation(node);
+
+  auto num_elements{node->GetType()->VectorGetNumElements()};
+  // 一个向量时下标按 n 取模, 两个向量时按 2n 取模
+  auto limit{has_two_vector ? 2 * num_elements : num_elements};
+
+  if (auto constant{llvm::dyn_cast<llvm::Constant>(mask)}) {
+    std::vector<std::int32_t> indices;
+    for (std::size_t i{}; i < num_elements; ++i) {
+      auto index{llvm::dyn_cast_or_null<llvm::ConstantInt>(
+          constant->getAggregateElement(i))};
+      indices.push_back(index ? index->getZExtValue() & (limit - 1) : -1);
+    }
+
+    return Builder.CreateShuffleVector(lhs, rhs, indices);
+  }
+
+  mask = Builder.CreateAnd(mask,
+                           llvm::ConstantInt::get(mask->getType(), limit - 1));
+
+  llvm::Value *value{llvm::UndefValue::get(lhs->getType())};
+  for (std::size_t i{}; i < num_elements; ++i) {
+    auto index{Builder.CreateExtractElement(mask, i)};
+    auto element_index{Builder.CreateAnd(index, num_elements - 1)};
+
+    llvm::Value *element{Builder.CreateExtractElement(lhs, element_index)};
+    if (has_two_vector) {
+      auto is_rhs{Builder.CreateICmpUGE(
+          index, llvm::ConstantInt::get(index->getType(), num_elements))};
+      element = Builder.CreateSelect(
+          is_rhs, Builder.CreateExtractElement(rhs, element_index), element);
+    }
+
+    value = Builder.CreateInsertElement(value, element, i);
+  }
+
+  return value;
+}
+
 }  // namespace kcc
@@ -6,6 +6,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <optional>
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/Transforms/Utils/CodeExtractor.h>
 
 #include "calc.h"
 #include "error.h"
@@ -56,9 +63,22 @@ void CodeGen::Visit(const DefaultStmt *node) {
 }
 
 void CodeGen::Visit(const CompoundStmt *node) {
+  if (node->HasVLA()) {
+    static auto stack_save{llvm::Intrinsic::getDeclaration(
+        Module.get(), llvm::Intrinsic::stacksave)};
+
+    EnsureInsertPoint();
+    stack_saves_.push_back(Builder.CreateCall(stack_save));
+  }
+
   for (const auto &item : node->GetStmts()) {
     EmitStmt(item);
   }
+
+  if (node->HasVLA()) {
+    EmitStackRestore(std::size(stack_saves_) - 1);
+    stack_saves_.pop_back();
+  }
 }
 
 void CodeGen::Visit(const ExprStmt *node) {
@@ -127,10 +147,12 @@ void CodeGen::Visit(const SwitchStmt *node) {
   Builder.ClearInsertionPoint();
 
   llvm::BasicBlock *continue_block{};
+  std::optional<std::size_t> continue_depth;
   if (!std::empty(break_continue_stack_)) {
     continue_block = break_continue_stack_.top().continue_block;
+    continue_depth = break_continue_stack_.top().continue_depth;
   }
-  PushBlock(end_block, continue_block);
+  PushBlock(end_block, continue_block, continue_depth);
   EmitStmt(node->GetStmt());
   PopBlock();
 
@@ -173,6 +195,7 @@ void CodeGen::Visit(const WhileStmt *node) {
   PopBlock();
 
   EmitBranch(cond_block);
+  EmitLoopMetadata(cond_block, node->GetLoopHints());
 
   EmitBlock(end_block, true);
 
@@ -212,6 +235,7 @@ void CodeGen::Visit(const DoWhileStmt *node) {
   }
   if (emit_br) {
     Builder.CreateCondBr(cond_val, body_block, end_block);
+    EmitLoopMetadata(body_block, node->GetLoopHints());
   }
 
   EmitBlock(end_block);
@@ -258,13 +282,28 @@ void CodeGen::Visit(const ForStmt *node) {
   }
 
   EmitBranch(cond_block);
+  EmitLoopMetadata(cond_block, node->GetLoopHints());
 
   EmitBlock(end_block, true);
 }
 
 void CodeGen::Visit(const GotoStmt *node) {
   TryEmitLocation(node);
-  EmitBranchThroughCleanup(GetBasicBlockForLabel(node->GetLabel()));
+
+  if (auto expr{node->GetExpr()}) {
+    expr->Accept(*this);
+    if (!HaveInsertPoint()) {
+      return;
+    }
+
+    auto block{GetIndirectGotoBlock()};
+    indirect_goto_phi_->addIncoming(
+        Builder.CreateBitCast(result_, Builder.getInt8PtrTy()),
+        Builder.GetInsertBlock());
+    EmitBranchThroughCleanup(block);
+  } else {
+    EmitBranchThroughCleanup(GetBasicBlockForLabel(node->GetLabel()));
+  }
 }
 
 void CodeGen::Visit(const ContinueStmt *node) {
@@ -273,6 +312,7 @@ void CodeGen::Visit(const ContinueStmt *node) {
   if (std::empty(break_continue_stack_)) {
     Error(node->GetLoc(), "continue stmt not in a loop or switch");
   } else {
+    EmitStackRestore(break_continue_stack_.top().continue_depth);
     EmitBranchThroughCleanup(break_continue_stack_.top().continue_block);
   }
 }
@@ -283,6 +323,7 @@ void CodeGen::Visit(const BreakStmt *node) {
   if (std::empty(break_continue_stack_)) {
     Error(node->GetLoc(), "break stmt not in a loop or switch");
   } else {
+    EmitStackRestore(break_continue_stack_.top().break_depth);
     EmitBranchThroughCleanup(break_continue_stack_.top().break_block);
   }
 }
@@ -297,10 +338,36 @@ void CodeGen::Visit(const ReturnStmt *node) {
     return;
   }
 
-  if (return_value_) {
+  if (node->IsMustTail()) {
+    expr->Accept(*this);
+
+    auto call{llvm::dyn_cast<llvm::CallInst>(result_)};
+    if (!call) {
+      Error(node->GetLoc(), "cannot perform a tail call to a builtin function");
+    }
+
+    // musttail 调用之后必须紧跟 ret, 不经过 return 基本块
+    call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+    if (call->getType()->isVoidTy()) {
+      Builder.CreateRetVoid();
+    } else {
+      Builder.CreateRet(call);
+    }
+    Builder.ClearInsertionPoint();
+    return;
+  }
+
+  if (return_value_ && IsMemCpyAggregate(expr)) {
+    CopyAggregate(return_value_, expr, false);
+  } else if (return_value_) {
     Load_Struct_Obj();
     node->GetExpr()->Accept(*this);
     Finish_Load();
+
+    if (auto call{llvm::dyn_cast<llvm::CallInst>(result_)};
+        call && expr->Kind() == AstNodeType::kFuncCallExpr) {
+      tail_calls_.push_back(call);
+    }
     Builder.CreateStore(result_, return_value_);
   } else {
     Error(node->GetLoc(), "void function '{}' should not return a value",
@@ -310,4 +377,884 @@ void CodeGen::Visit(const ReturnStmt *node) {
   EmitBranchThroughCleanup(return_block_);
 }
 
+// 参考 clang 的 CodeGenFunction::EmitAsmStmt
+void CodeGen::Visit(const AsmStmt *node) {
+  TryEmitLocation(node);
+
+  const auto &outputs{node->GetOutputs()};
+  const auto &inputs{node->GetInputs()};
+
+  // 约束已经在语义分析时检查过了, 这里只是为了获取约束的信息
+  std::vector<clang::TargetInfo::ConstraintInfo> output_infos, input_infos;
+  for (const auto &[name, constraint, expr] : outputs) {
+    output_infos.emplace_back(constraint, name);
+    TargetInfo->validateOutputConstraint(output_infos.back());
+  }
+  for (const auto &[name, constraint, expr] : inputs) {
+    input_infos.emplace_back(constraint, name);
+    TargetInfo->validateInputConstraint(output_infos, input_infos.back());
+  }
+
+  auto use_register{[](const clang::TargetInfo::ConstraintInfo &info,
+                       const Type *type) {
+    return (info.allowsRegister() || !info.allowsMemory()) &&
+           (type->IsScalarTy() || type->IsVectorTy());
+  }};
+
+  std::string constraints, in_out_constraints;
+  std::vector<llvm::Value *> args, in_out_args, result_ptrs;
+  std::vector<llvm::Type *> arg_types, result_types;
+  // 用于在没有副作用时标记为不访问内存或只读内存
+  bool read_none{true}, read_only{true};
+
+  for (std::size_t i{}; i < std::size(outputs); ++i) {
+    const auto &info{output_infos[i]};
+    auto expr{outputs[i].expr};
+
+    // 跳过开头的 '=' 或 '+'
+    auto constraint{
+        SimplifyConstraint(outputs[i].constraint.c_str() + 1, output_infos)};
+    auto ptr{GetPtr(expr)};
+
+    if (!std::empty(constraints)) {
+      constraints += ',';
+    }
+
+    if (use_register(info, expr->GetType())) {
+      // 寄存器输出作为内联汇编的返回值
+      constraints += "=" + constraint;
+      result_ptrs.push_back(ptr);
+      result_types.push_back(expr->GetType()->GetLLVMType());
+    } else {
+      // 内存输出以指针的形式作为参数
+      constraints += "=*" + constraint;
+      args.push_back(ptr);
+      arg_types.push_back(ptr->getType());
+      read_none = read_only = false;
+    }
+
+    // '+' 相当于一个与该输出绑定的输入, 放在所有输入之后
+    if (info.isReadWrite()) {
+      in_out_constraints += ',';
+
+      if (use_register(info, expr->GetType())) {
+        in_out_args.push_back(Builder.CreateLoad(ptr, is_volatile_));
+        in_out_constraints += std::to_string(i);
+      } else {
+        in_out_args.push_back(ptr);
+        in_out_constraints += "*" + constraint;
+      }
+    }
+  }
+
+  for (std::size_t i{}; i < std::size(inputs); ++i) {
+    const auto &info{input_infos[i]};
+    auto expr{inputs[i].expr};
+
+    auto constraint{
+        SimplifyConstraint(inputs[i].constraint.c_str(), output_infos)};
+
+    if (!std::empty(constraints)) {
+      constraints += ',';
+    }
+
+    if (info.allowsMemory()) {
+      read_none = false;
+    }
+
+    llvm::Value *arg;
+    if (use_register(info, expr->GetType())) {
+      expr->Accept(*this);
+      arg = result_;
+
+      // 绑定到输出的输入需要和输出的类型相同
+      if (info.hasTiedOperand()) {
+        auto output{outputs[info.getTiedOperand()].expr};
+        auto output_type{output->GetType()->GetLLVMType()};
+
+        if (arg->getType() != output_type && output_type->isIntegerTy() &&
+            (arg->getType()->isIntegerTy() || arg->getType()->isPointerTy())) {
+          arg = CastTo(arg, output_type, expr->GetType()->IsUnsigned());
+        }
+      }
+    } else {
+      arg = GetPtr(expr);
+      constraints += '*';
+    }
+
+    constraints += constraint;
+    args.push_back(arg);
+    arg_types.push_back(arg->getType());
+  }
+
+  constraints += in_out_constraints;
+  for (auto arg : in_out_args) {
+    args.push_back(arg);
+    arg_types.push_back(arg->getType());
+  }
+
+  // asm goto 的跳转目标以 blockaddress 的形式作为参数
+  std::vector<llvm::BasicBlock *> transfer;
+  for (const auto &item : node->GetLabels()) {
+    auto block{GetBasicBlockForLabel(item->GetLabel())};
+    transfer.push_back(block);
+
+    auto addr{llvm::BlockAddress::get(func_, block)};
+    args.push_back(addr);
+    arg_types.push_back(addr->getType());
+
+    if (!std::empty(constraints)) {
+      constraints += ',';
+    }
+    constraints += 'X';
+  }
+
+  for (const auto &item : node->GetClobbers()) {
+    std::string clobber{item};
+
+    if (clobber == "memory") {
+      read_none = read_only = false;
+    } else if (clobber != "cc") {
+      clobber = TargetInfo->getNormalizedGCCRegisterName(clobber).str();
+    }
+
+    if (!std::empty(constraints)) {
+      constraints += ',';
+    }
+    constraints += "~{" + clobber + "}";
+  }
+
+  // 目标平台默认破坏的寄存器, 如 x86 上的 ~{dirflag},~{fpsr},~{flags}
+  if (std::string machine_clobbers{TargetInfo->getClobbers()};
+      !std::empty(machine_clobbers)) {
+    if (!std::empty(constraints)) {
+      constraints += ',';
+    }
+    constraints += machine_clobbers;
+  }
+
+  llvm::Type *result_type;
+  if (std::empty(result_types)) {
+    result_type = Builder.getVoidTy();
+  } else if (std::size(result_types) == 1) {
+    result_type = result_types.front();
+  } else {
+    result_type = llvm::StructType::get(Context, result_types);
+  }
+
+  auto func_type{llvm::FunctionType::get(result_type, arg_types, false)};
+  if (!llvm::InlineAsm::Verify(func_type, constraints)) {
+    Error(node->GetLoc(), "invalid constraints '{}' in asm", constraints);
+  }
+
+  // 没有输出的内联汇编被认为是 volatile 的
+  auto has_side_effect{node->IsVolatile() || std::empty(outputs)};
+  auto inline_asm{llvm::InlineAsm::get(
+      func_type, ConvertAsmString(node, std::size(in_out_args)), constraints,
+      has_side_effect, false, llvm::InlineAsm::AD_ATT)};
+
+  llvm::CallBase *call;
+  if (node->IsAsmGoto()) {
+    auto fallthrough{CreateBasicBlock("asm.fallthrough")};
+    call = Builder.CreateCallBr(inline_asm, fallthrough, transfer, args);
+    EmitBlock(fallthrough);
+  } else {
+    call = Builder.CreateCall(inline_asm, args);
+  }
+
+  call->setDoesNotThrow();
+  if (!has_side_effect) {
+    if (read_none) {
+      call->setDoesNotAccessMemory();
+    } else if (read_only) {
+      call->setOnlyReadsMemory();
+    }
+  }
+
+  for (std::size_t i{}; i < std::size(result_ptrs); ++i) {
+    llvm::Value *value{call};
+    if (std::size(result_ptrs) > 1) {
+      value = Builder.CreateExtractValue(call, static_cast<std::uint32_t>(i));
+    }
+    Builder.CreateStore(value, result_ptrs[i]);
+  }
+}
+
+// 将 GCC 的约束转换为 LLVM 的约束, 参考 clang 的 SimplifyConstraint
+std::string CodeGen::SimplifyConstraint(
+    const char *constraint,
+    llvm::ArrayRef<clang::TargetInfo::ConstraintInfo> output_infos) {
+  std::string result;
+
+  while (*constraint) {
+    switch (*constraint) {
+      default:
+        // e.g. 在 x86 上 a -> {ax}
+        result += TargetInfo->convertConstraint(constraint);
+        break;
+      case '*':
+      case '?':
+      case '!':
+      case '=':
+      case '+':
+        break;
+      case '#':
+        while (constraint[1] && constraint[1] != ',') {
+          ++constraint;
+        }
+        break;
+      case '&':
+      case '%':
+        result += *constraint;
+        while (constraint[1] && constraint[1] == *constraint) {
+          ++constraint;
+        }
+        break;
+      case ',':
+        result += '|';
+        break;
+      case 'g':
+        result += "imr";
+        break;
+      case '[': {
+        // [name], 绑定到具名的输出操作数
+        std::uint32_t index{};
+        [[maybe_unused]] auto ok{
+            TargetInfo->resolveSymbolicName(constraint, output_infos, index)};
+        assert(ok);
+        result += std::to_string(index);
+        break;
+      }
+    }
+
+    ++constraint;
+  }
+
+  return result;
+}
+
+// 将 GCC 风格的汇编模板转换为 LLVM 的格式, 参考 clang 的
+// GCCAsmStmt::AnalyzeAsmString, e.g. %0 -> $0, %[name] -> $N, %c0 -> ${0:c}
+std::string CodeGen::ConvertAsmString(const AsmStmt *node,
+                                      std::size_t num_in_out) {
+  const auto &str{node->GetAsmString()};
+  const auto &outputs{node->GetOutputs()};
+  const auto &inputs{node->GetInputs()};
+  const auto &labels{node->GetLabels()};
+
+  auto num_operands{std::size(outputs) + std::size(inputs)};
+  auto has_variants{!TargetInfo->hasNoAsmVariants()};
+
+  auto find_named_operand{
+      [&](const std::string &name) -> std::optional<std::size_t> {
+        for (std::size_t i{}; i < std::size(outputs); ++i) {
+          if (outputs[i].name == name) {
+            return i;
+          }
+        }
+        for (std::size_t i{}; i < std::size(inputs); ++i) {
+          if (inputs[i].name == name) {
+            return std::size(outputs) + i;
+          }
+        }
+        for (std::size_t i{}; i < std::size(labels); ++i) {
+          if (labels[i]->GetName() == name) {
+            return num_operands + i;
+          }
+        }
+        return {};
+      }};
+
+  std::string result;
+  for (std::size_t i{}; i < std::size(str); ++i) {
+    auto ch{str[i]};
+
+    switch (ch) {
+      case '$':
+        result += "$$";
+        continue;
+      case '{':
+        result += has_variants ? "$(" : "{";
+        continue;
+      case '|':
+        result += has_variants ? "$|" : "|";
+        continue;
+      case '}':
+        result += has_variants ? "$)" : "}";
+        continue;
+      case '%':
+        break;
+      default:
+        result += ch;
+        continue;
+    }
+
+    if (++i == std::size(str)) {
+      Error(node->GetLoc(), "invalid % escape in inline assembly string");
+    }
+
+    ch = str[i];
+    if (ch == '%') {
+      result += '%';
+      continue;
+    } else if (ch == '=') {
+      // 每个内联汇编实例唯一的数字
+      result += "${:uid}";
+      continue;
+    }
+
+    // 修饰符, e.g. %c0 / %l[label]
+    char modifier{};
+    if (std::isalpha(ch)) {
+      if (++i == std::size(str)) {
+        Error(node->GetLoc(), "invalid % escape in inline assembly string");
+      }
+      modifier = ch;
+      ch = str[i];
+    }
+
+    std::size_t index{};
+    if (std::isdigit(ch)) {
+      while (i < std::size(str) && std::isdigit(str[i])) {
+        index = index * 10 + (str[i] - '0');
+        ++i;
+      }
+      --i;
+
+      if (index >= num_operands + std::size(labels)) {
+        Error(node->GetLoc(), "invalid operand number in inline asm string");
+      }
+    } else if (ch == '[') {
+      auto end{str.find(']', i)};
+      if (end == std::string::npos) {
+        Error(node->GetLoc(), "unterminated symbolic operand name in inline "
+                              "asm string");
+      }
+
+      auto name{str.substr(i + 1, end - i - 1)};
+      auto operand{find_named_operand(name)};
+      if (!operand) {
+        Error(node->GetLoc(), "unknown symbolic operand name '{}' in inline "
+                              "asm string", name);
+      }
+
+      index = *operand;
+      i = end;
+    } else {
+      Error(node->GetLoc(), "invalid % escape in inline assembly string");
+    }
+
+    // 绑定的输入位于所有输入之后, 标签之前
+    if (index >= num_operands) {
+      index += num_in_out;
+    }
+
+    if (modifier) {
+      result += "${" + std::to_string(index) + ":" + modifier + "}";
+    } else {
+      result += "$" + std::to_string(index);
+    }
+  }
+
+  return result;
+}
+
+// 循环体中的基本块位于 header 与函数末尾之间(循环结束块尚未插入),
+// 跳回 header 的终结指令即为回边, 在其上设置 llvm.loop
+void CodeGen::EmitLoopMetadata(llvm::BasicBlock *header,
+                               const LoopHints &hints) {
+  auto i32{Builder.getInt32Ty()};
+  auto make_int{[&](std::string_view name, std::int32_t value) {
+    return llvm::MDNode::get(
+        Context,
+        {llvm::MDString::get(Context, name),
+         llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i32, value))});
+  }};
+  auto make_flag{[&](std::string_view name) {
+    return llvm::MDNode::get(Context, {llvm::MDString::get(Context, name)});
+  }};
+
+  // 第一个操作数留给自身引用
+  llvm::SmallVector<llvm::Metadata *, 8> props{nullptr};
+
+  if (hints.unroll_disable) {
+    props.push_back(make_flag("llvm.loop.unroll.disable"));
+  } else if (hints.unroll_full) {
+    props.push_back(make_flag("llvm.loop.unroll.full"));
+  } else if (hints.unroll_count > 0) {
+    props.push_back(make_int("llvm.loop.unroll.count", hints.unroll_count));
+  } else if (hints.unroll_enable) {
+    props.push_back(make_flag("llvm.loop.unroll.enable"));
+  }
+
+  if (hints.vectorize) {
+    props.push_back(llvm::MDNode::get(
+        Context,
+        {llvm::MDString::get(Context, "llvm.loop.vectorize.enable"),
+         llvm::ConstantAsMetadata::get(Builder.getInt1(*hints.vectorize))}));
+  }
+  if (hints.vectorize_width > 0) {
+    props.push_back(
+        make_int("llvm.loop.vectorize.width", hints.vectorize_width));
+  }
+  if (hints.interleave_count > 0) {
+    props.push_back(
+        make_int("llvm.loop.interleave.count", hints.interleave_count));
+  }
+
+  // ivdep: 循环中的内存访问属于同一个 access group, 迭代之间没有依赖
+  llvm::MDNode *access_group{};
+  if (hints.ivdep) {
+    access_group = llvm::MDNode::getDistinct(Context, {});
+    props.push_back(llvm::MDNode::get(
+        Context,
+        {llvm::MDString::get(Context, "llvm.loop.parallel_accesses"),
+         access_group}));
+  }
+
+  if (std::size(props) == 1) {
+    return;
+  }
+
+  auto loop_id{llvm::MDNode::getDistinct(Context, props)};
+  loop_id->replaceOperandWith(0, loop_id);
+
+  for (auto iter{header->getIterator()}; iter != std::end(*header->getParent());
+       ++iter) {
+    for (auto &inst : *iter) {
+      if (access_group && inst.mayReadOrWriteMemory()) {
+        // 已属于内层循环的 access group 时, 使用 access group 的列表
+        auto group{inst.getMetadata(llvm::LLVMContext::MD_access_group)};
+        if (group == nullptr) {
+          group = access_group;
+        } else if (group->getNumOperands() == 0) {
+          group = llvm::MDNode::get(Context, {group, access_group});
+        } else {
+          group = llvm::MDNode::concatenate(
+              group, llvm::MDNode::get(Context, {access_group}));
+        }
+        inst.setMetadata(llvm::LLVMContext::MD_access_group, group);
+      }
+    }
+
+    if (auto term{iter->getTerminator()}) {
+      if (llvm::is_contained(llvm::successors(term), header)) {
+        term->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+      }
+    }
+  }
+}
+
+// OpenMP 构造调用 libgomp(GCC 的 OpenMP 运行时库)
+void CodeGen::Visit(const OmpStmt *node) {
+  TryEmitLocation(node);
+
+  // private / reduction 的副本只在构造中使用
+  auto privates_backup{omp_privates_};
+
+  switch (node->GetDirective()) {
+    case OmpStmt::Directive::kParallel:
+    case OmpStmt::Directive::kParallelFor:
+      EmitOmpParallel(node);
+      break;
+    case OmpStmt::Directive::kFor:
+      EmitOmpFor(node);
+      break;
+    case OmpStmt::Directive::kCritical:
+      EmitOmpCritical(node);
+      break;
+    case OmpStmt::Directive::kBarrier:
+      Builder.CreateCall(
+          Module->getOrInsertFunction("GOMP_barrier", Builder.getVoidTy()));
+      break;
+    default:
+      assert(false);
+  }
+
+  omp_privates_ = std::move(privates_backup);
+}
+
+// 区域先在当前函数中生成, 函数结束时由 OutlineOmpRegions 提取为函数
+void CodeGen::EmitOmpParallel(const OmpStmt *node) {
+  // 0 表示由运行时决定线程数
+  llvm::Value *num_threads{Builder.getInt32(0)};
+  if (auto expr{node->GetClauses().num_threads}) {
+    expr->Accept(*this);
+    num_threads = CastTo(result_, Builder.getInt32Ty(),
+                         expr->GetType()->IsUnsigned());
+  }
+
+  auto entry_block{CreateBasicBlock("omp.par.entry")};
+  auto exit_block{CreateBasicBlock("omp.par.exit")};
+  omp_regions_.push_back(
+      {entry_block, exit_block, num_threads, node->GetLoc()});
+
+  EmitBlock(entry_block);
+
+  // 区域中的局部变量属于各个线程, 在区域的入口分配
+  llvm::Instruction *alloc_insert_point_backup{alloc_insert_point_};
+  auto undef{llvm::UndefValue::get(Builder.getInt32Ty())};
+  alloc_insert_point_ =
+      new llvm::BitCastInst{undef, Builder.getInt32Ty(), "", entry_block};
+
+  if (node->GetDirective() == OmpStmt::Directive::kParallelFor) {
+    EmitOmpFor(node);
+  } else {
+    auto shared_ptrs{EmitOmpDataSharing(node)};
+    EmitStmt(node->GetBlock());
+    if (HaveInsertPoint()) {
+      EmitOmpReduction(node, shared_ptrs);
+    }
+  }
+
+  llvm::Instruction *placeholder{alloc_insert_point_};
+  alloc_insert_point_ = alloc_insert_point_backup;
+  placeholder->eraseFromParent();
+
+  EmitBlock(exit_block);
+}
+
+// 工作共享循环, 每个线程通过 GOMP_loop_*_start / next 取得若干段迭代
+// if (GOMP_loop_static_start(lb, ub, step, chunk, &istart, &iend)) {
+//   do {
+//     for (iv = istart; iv < iend; iv += step) body
+//   } while (GOMP_loop_static_next(&istart, &iend));
+// }
+// GOMP_loop_end();
+// 64 位无符号的循环变量使用 GOMP_loop_ull_*, 多一个表示方向的参数 up
+void CodeGen::EmitOmpFor(const OmpStmt *node) {
+  auto i8{Builder.getInt8Ty()};
+  auto i64{Builder.getInt64Ty()};
+  auto i64_ptr{i64->getPointerTo()};
+
+  auto iter_var{node->GetIterVar()};
+  auto is_ull{iter_var->GetType()->IsUnsigned() &&
+              iter_var->GetType()->GetWidth() == 8};
+
+  auto eval{[&](const Expr *expr) {
+    expr->Accept(*this);
+    return CastTo(result_, i64, expr->GetType()->IsUnsigned());
+  }};
+
+  auto lower_bound{eval(node->GetLowerBound())};
+  auto upper_bound{eval(node->GetUpperBound())};
+  auto step{node->GetStep() ? eval(node->GetStep()) : Builder.getInt64(1)};
+  if (node->IsDecrement()) {
+    step = Builder.CreateNeg(step);
+  }
+
+  // libgomp 的迭代区间不包括上界
+  if (node->GetCondOp() == Tag::kLessEqual) {
+    upper_bound = Builder.CreateAdd(upper_bound, Builder.getInt64(1));
+  } else if (node->GetCondOp() == Tag::kGreaterEqual) {
+    upper_bound = Builder.CreateSub(upper_bound, Builder.getInt64(1));
+  }
+
+  const auto &clauses{node->GetClauses()};
+  bool is_dynamic{clauses.schedule == OmpStmt::Schedule::kDynamic};
+  // static 的块大小为 0 时将迭代平均分配给各个线程
+  auto chunk_size{clauses.chunk_size ? eval(clauses.chunk_size)
+                                     : Builder.getInt64(is_dynamic)};
+
+  auto shared_ptrs{EmitOmpDataSharing(node)};
+
+  // 循环变量是私有的
+  auto iter_type{iter_var->GetType()->GetLLVMType()};
+  auto iter_ptr{CreateEntryBlockAlloca(iter_type, iter_var->GetAlign(),
+                                       iter_var->GetName())};
+  omp_privates_[iter_var] = iter_ptr;
+
+  auto istart{CreateEntryBlockAlloca(i64, 8, "omp.istart")};
+  auto iend{CreateEntryBlockAlloca(i64, 8, "omp.iend")};
+  auto iv{CreateEntryBlockAlloca(i64, 8, "omp.iv")};
+
+  std::string prefix{is_ull ? "GOMP_loop_ull_" : "GOMP_loop_"};
+  prefix += is_dynamic ? "dynamic_" : "static_";
+
+  std::vector<llvm::Type *> start_params{i64, i64, i64, i64, i64_ptr, i64_ptr};
+  std::vector<llvm::Value *> start_args{lower_bound, upper_bound, step,
+                                        chunk_size,  istart,      iend};
+  if (is_ull) {
+    start_params.insert(std::begin(start_params), i8);
+    start_args.insert(std::begin(start_args),
+                      Builder.getInt8(!node->IsDecrement()));
+  }
+
+  auto start_func{Module->getOrInsertFunction(
+      prefix + "start", llvm::FunctionType::get(i8, start_params, false))};
+  auto next_func{
+      Module->getOrInsertFunction(prefix + "next", i8, i64_ptr, i64_ptr)};
+
+  auto chunk_block{CreateBasicBlock("omp.loop.chunk")};
+  auto cond_block{CreateBasicBlock("omp.loop.cond")};
+  auto body_block{CreateBasicBlock("omp.loop.body")};
+  auto inc_block{CreateBasicBlock("omp.loop.inc")};
+  auto next_block{CreateBasicBlock("omp.loop.next")};
+  auto end_block{CreateBasicBlock("omp.loop.end")};
+
+  auto more{Builder.CreateCall(start_func, start_args)};
+  Builder.CreateCondBr(Builder.CreateIsNotNull(more), chunk_block, end_block);
+
+  EmitBlock(chunk_block);
+  Builder.CreateStore(Builder.CreateLoad(istart), iv);
+
+  EmitBlock(cond_block);
+  auto value{Builder.CreateLoad(iv)};
+  auto end{Builder.CreateLoad(iend)};
+  llvm::Value *cond;
+  if (is_ull) {
+    // 无符号的步长不会为负数, 方向只由 ++ / -- 决定
+    cond = node->IsDecrement() ? Builder.CreateICmpUGT(value, end)
+                               : Builder.CreateICmpULT(value, end);
+  } else if (auto constant{llvm::dyn_cast<llvm::ConstantInt>(step)}) {
+    cond = constant->isNegative() ? Builder.CreateICmpSGT(value, end)
+                                  : Builder.CreateICmpSLT(value, end);
+  } else {
+    // 步长的符号在编译时未知
+    cond = Builder.CreateSelect(
+        Builder.CreateICmpSGT(step, Builder.getInt64(0)),
+        Builder.CreateICmpSLT(value, end), Builder.CreateICmpSGT(value, end));
+  }
+  Builder.CreateCondBr(cond, body_block, next_block);
+
+  EmitBlock(body_block);
+  Builder.CreateStore(
+      CastTo(value, iter_type, iter_var->GetType()->IsUnsigned()), iter_ptr);
+
+  PushBlock(next_block, inc_block);
+  EmitStmt(node->GetLoop()->GetBlock());
+  PopBlock();
+
+  EmitBlock(inc_block);
+  Builder.CreateStore(Builder.CreateAdd(Builder.CreateLoad(iv), step), iv);
+  EmitBranch(cond_block);
+  EmitLoopMetadata(cond_block, node->GetLoop()->GetLoopHints());
+
+  EmitBlock(next_block);
+  more = Builder.CreateCall(next_func, {istart, iend});
+  Builder.CreateCondBr(Builder.CreateIsNotNull(more), chunk_block, end_block);
+
+  EmitBlock(end_block);
+  EmitOmpReduction(node, shared_ptrs);
+
+  // parallel for 在区域结束时同步
+  bool nowait{clauses.nowait ||
+              node->GetDirective() == OmpStmt::Directive::kParallelFor};
+  Builder.CreateCall(Module->getOrInsertFunction(
+      nowait ? "GOMP_loop_end_nowait" : "GOMP_loop_end", Builder.getVoidTy()));
+}
+
+void CodeGen::EmitOmpCritical(const OmpStmt *node) {
+  const auto &name{node->GetClauses().name};
+  auto void_type{Builder.getVoidTy()};
+
+  if (std::empty(name)) {
+    Builder.CreateCall(
+        Module->getOrInsertFunction("GOMP_critical_start", void_type));
+    EmitStmt(node->GetBlock());
+    if (HaveInsertPoint()) {
+      Builder.CreateCall(
+          Module->getOrInsertFunction("GOMP_critical_end", void_type));
+    }
+    return;
+  }
+
+  // 与 GCC 相同, 同名的 critical 在所有翻译单元中使用同一个锁
+  auto lock{llvm::cast<llvm::GlobalVariable>(Module->getOrInsertGlobal(
+      ".gomp_critical_user_" + name, Builder.getInt8PtrTy()))};
+  if (!lock->hasInitializer()) {
+    lock->setLinkage(llvm::GlobalVariable::CommonLinkage);
+    lock->setInitializer(
+        llvm::ConstantPointerNull::get(Builder.getInt8PtrTy()));
+    lock->setAlignment(llvm::MaybeAlign{8});
+  }
+
+  auto lock_type{lock->getType()};
+  Builder.CreateCall(Module->getOrInsertFunction("GOMP_critical_name_start",
+                                                 void_type, lock_type),
+                     {lock});
+  EmitStmt(node->GetBlock());
+  if (HaveInsertPoint()) {
+    Builder.CreateCall(Module->getOrInsertFunction("GOMP_critical_name_end",
+                                                   void_type, lock_type),
+                       {lock});
+  }
+}
+
+// private 和 reduction 子句中的变量在构造中使用新分配的副本,
+// 返回 reduction 变量原来的地址
+std::vector<llvm::Value *> CodeGen::EmitOmpDataSharing(const OmpStmt *node) {
+  const auto &clauses{node->GetClauses()};
+
+  for (const auto &obj : clauses.privates) {
+    omp_privates_[obj] = CreateEntryBlockAlloca(
+        obj->GetType()->GetLLVMType(), obj->GetAlign(), obj->GetName());
+  }
+
+  std::vector<llvm::Value *> shared_ptrs;
+  for (const auto &[op, obj] : clauses.reductions) {
+    shared_ptrs.push_back(GetObjectPtr(obj));
+
+    auto ptr{CreateEntryBlockAlloca(obj->GetType()->GetLLVMType(),
+                                    obj->GetAlign(), obj->GetName())};
+    Builder.CreateStore(GetOmpReductionInit(op, obj->GetType()), ptr);
+    omp_privates_[obj] = ptr;
+  }
+
+  return shared_ptrs;
+}
+
+// 各线程依次将部分结果合并到原来的变量中
+void CodeGen::EmitOmpReduction(const OmpStmt *node,
+                               const std::vector<llvm::Value *> &shared_ptrs) {
+  const auto &reductions{node->GetClauses().reductions};
+  if (std::empty(reductions)) {
+    return;
+  }
+
+  auto void_type{Builder.getVoidTy()};
+  Builder.CreateCall(
+      Module->getOrInsertFunction("GOMP_atomic_start", void_type));
+
+  for (std::size_t i{}; i < std::size(reductions); ++i) {
+    const auto &[op, obj]{reductions[i]};
+    auto type{obj->GetType()};
+    auto is_unsigned{type->IsUnsigned()};
+
+    auto lhs{Builder.CreateLoad(shared_ptrs[i])};
+    auto rhs{Builder.CreateLoad(omp_privates_.at(obj))};
+
+    llvm::Value *value;
+    if (op == "+" || op == "-") {
+      value = AddOp(lhs, rhs, is_unsigned);
+    } else if (op == "*") {
+      value = MulOp(lhs, rhs, is_unsigned);
+    } else if (op == "&") {
+      value = AndOp(lhs, rhs);
+    } else if (op == "|") {
+      value = OrOp(lhs, rhs);
+    } else if (op == "^") {
+      value = XorOp(lhs, rhs);
+    } else if (op == "&&" || op == "||") {
+      auto lhs_bool{CastToBool(lhs)};
+      auto rhs_bool{CastToBool(rhs)};
+      value = CastTo(op == "&&" ? Builder.CreateAnd(lhs_bool, rhs_bool)
+                                : Builder.CreateOr(lhs_bool, rhs_bool),
+                     lhs->getType(), true);
+    } else {
+      bool is_max{op == "max"};
+      llvm::Value *cmp;
+      if (type->IsFloatPointTy()) {
+        cmp = is_max ? Builder.CreateFCmpOGT(lhs, rhs)
+                     : Builder.CreateFCmpOLT(lhs, rhs);
+      } else if (is_unsigned) {
+        cmp = is_max ? Builder.CreateICmpUGT(lhs, rhs)
+                     : Builder.CreateICmpULT(lhs, rhs);
+      } else {
+        cmp = is_max ? Builder.CreateICmpSGT(lhs, rhs)
+                     : Builder.CreateICmpSLT(lhs, rhs);
+      }
+      value = Builder.CreateSelect(cmp, lhs, rhs);
+    }
+
+    Builder.CreateStore(value, shared_ptrs[i]);
+  }
+
+  Builder.CreateCall(Module->getOrInsertFunction("GOMP_atomic_end", void_type));
+}
+
+// 归约运算的单位元
+llvm::Constant *CodeGen::GetOmpReductionInit(const std::string &op,
+                                             Type *type) {
+  auto llvm_type{type->GetLLVMType()};
+
+  if (op == "*" || op == "&&") {
+    if (type->IsFloatPointTy()) {
+      return llvm::ConstantFP::get(llvm_type, 1.0);
+    } else {
+      return llvm::ConstantInt::get(llvm_type, 1);
+    }
+  } else if (op == "&") {
+    return llvm::Constant::getAllOnesValue(llvm_type);
+  } else if (op == "max" || op == "min") {
+    bool is_max{op == "max"};
+    if (type->IsFloatPointTy()) {
+      return llvm::ConstantFP::getInfinity(llvm_type, is_max);
+    }
+
+    auto width{llvm_type->getIntegerBitWidth()};
+    if (type->IsUnsigned()) {
+      return llvm::ConstantInt::get(
+          llvm_type, is_max ? llvm::APInt::getMinValue(width)
+                            : llvm::APInt::getMaxValue(width));
+    } else {
+      return llvm::ConstantInt::get(
+          llvm_type, is_max ? llvm::APInt::getSignedMinValue(width)
+                            : llvm::APInt::getSignedMaxValue(width));
+    }
+  } else {
+    return GetConstantZero(llvm_type);
+  }
+}
+
+// 将 parallel 区域提取为函数, 由 GOMP_parallel 在每个线程中调用,
+// 区域中使用的外部变量通过参数结构体按地址传递, 即默认是共享的
+// 外层的区域先提取, 这样内层区域的参数结构体分配在外层提取出的函数中
+void CodeGen::OutlineOmpRegions() {
+  auto i8_ptr{Builder.getInt8PtrTy()};
+  auto i32{Builder.getInt32Ty()};
+  auto parallel_func{Module->getOrInsertFunction(
+      "GOMP_parallel", Builder.getVoidTy(), i8_ptr, i8_ptr, i32, i32)};
+
+  for (const auto &[entry, exit, num_threads, loc] : omp_regions_) {
+    auto func{entry->getParent()};
+
+    // 区域中的基本块按生成的顺序位于 entry 和 exit 之间
+    std::vector<llvm::BasicBlock *> blocks;
+    for (auto iter{entry->getIterator()}; &*iter != exit; ++iter) {
+      blocks.push_back(&*iter);
+    }
+    for (const auto &block : blocks) {
+      for (const auto &succ : llvm::successors(block)) {
+        if (succ != exit && !llvm::is_contained(blocks, succ)) {
+          Error(loc, "invalid branch out of OpenMP structured block");
+        }
+      }
+    }
+
+    llvm::CodeExtractorAnalysisCache cache{*func};
+    llvm::CodeExtractor extractor{blocks,  nullptr, true, nullptr,
+                                  nullptr, nullptr, false, true,
+                                  "omp_outlined"};
+    auto outlined{extractor.extractCodeRegion(cache)};
+    if (outlined == nullptr) {
+      Error(loc, "can not outline OpenMP parallel region");
+    }
+
+    // 区域中的局部变量移到入口, 以便 mem2reg 处理
+    auto insert_point{outlined->getEntryBlock().getTerminator()};
+    for (auto &inst : llvm::make_early_inc_range(*entry)) {
+      if (auto alloca{llvm::dyn_cast<llvm::AllocaInst>(&inst)};
+          alloca && llvm::isa<llvm::ConstantInt>(alloca->getArraySize())) {
+        alloca->moveBefore(insert_point);
+      }
+    }
+
+    auto call{llvm::cast<llvm::CallInst>(outlined->user_back())};
+    Builder.SetInsertPoint(call);
+
+    llvm::Value *data{llvm::ConstantPointerNull::get(i8_ptr)};
+    if (call->arg_size() != 0) {
+      data = Builder.CreateBitCast(call->getArgOperand(0), i8_ptr);
+    }
+    Builder.CreateCall(parallel_func,
+                       {Builder.CreateBitCast(outlined, i8_ptr), data,
+                        num_threads, Builder.getInt32(0)});
+    call->eraseFromParent();
+  }
+
+  omp_regions_.clear();
+  Builder.ClearInsertionPoint();
+}
+
 }  // namespace kcc
@@ -12,6 +12,7 @@
 #include <clang/Frontend/Utils.h>
 #include <clang/Lex/DirectoryLookup.h>
 #include <fmt/format.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include "error.h"
@@ -40,10 +41,8 @@ Preprocessor::Preprocessor() {
                      "#define __GNUC__ 11\n"
                      "#define __GNUC_MINOR__ 1\n"
                      "#define __GNUC_PATCHLEVEL__ 0\n"
-                     "#define __STDC_NO_ATOMICS__ 1\n"
                      "#define __STDC_NO_COMPLEX__ 1\n"
                      "#define __STDC_NO_THREADS__ 1\n"
-                     "#define __STDC_NO_VLA__ 1\n"
                      "#define __builtin_va_arg(args,type) "
                      "  *(type*)__builtin_va_arg_sub(args,type)\n");
 }
@@ -74,6 +73,8 @@ void Preprocessor::AddMacroDefinitions(
 }
 
 std::string Preprocessor::Cpp(const std::string &input_file) {
+  llvm::TimeTraceScope scope{"Preprocessor::Cpp", input_file};
+
   Module->setSourceFileName(input_file);
 
   auto file{Ci.getFileManager().getFileRef(input_file).get()};
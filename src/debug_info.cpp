@@ -59,17 +59,19 @@ void DebugInfo::EmitFuncStart(const FuncDef *node) {
 
   auto func_type{node->GetFuncType()};
   auto func_name{func_type->FuncGetName()};
+  // 有 asm 标号时函数以标号作为符号名
+  auto link_name{node->GetIdent()->GetLinkName()};
 
   auto line_no{node->GetLoc().GetRow()};
 
-  subprogram_ = builder_.createFunction(file_, func_name, func_name, file_,
+  subprogram_ = builder_.createFunction(file_, func_name, link_name, file_,
                                         line_no, CreateFunctionType(func_type),
                                         line_no, llvm::DINode::FlagPrototyped,
                                         llvm::DISubprogram::SPFlagDefinition);
 
   lexical_blocks_.push_back(subprogram_);
 
-  auto func{Module->getFunction(func_name)};
+  auto func{Module->getFunction(link_name)};
   assert(func != nullptr);
   func->setSubprogram(subprogram_);
 }
@@ -154,6 +156,8 @@ llvm::DIType *DebugInfo::GetOrCreateType(Type *type, const Location &loc) {
     cache = CreatePointerType(type);
   } else if (type->IsArrayTy()) {
     cache = CreateArrayType(type);
+  } else if (type->IsVectorTy()) {
+    cache = CreateVectorType(type);
   } else if (type->IsStructOrUnionTy()) {
     cache = CreateStructType(type, loc);
   } else if (type->IsFunctionTy()) {
@@ -220,6 +224,16 @@ llvm::DIType *DebugInfo::CreateArrayType(Type *type) {
       builder_.getOrCreateArray(subscripts));
 }
 
+llvm::DIType *DebugInfo::CreateVectorType(Type *type) {
+  llvm::Metadata *subscript{
+      builder_.getOrCreateSubrange(0, type->VectorGetNumElements())};
+
+  return builder_.createVectorType(
+      type->GetWidth() * 8, type->GetAlign() * 8,
+      GetOrCreateType(type->VectorGetElementType().GetType()),
+      builder_.getOrCreateArray(subscript));
+}
+
 llvm::DIType *DebugInfo::CreateStructType(Type *type, const Location &loc) {
   std::int32_t tag{};
   if (type->IsStructTy()) {
@@ -56,10 +56,13 @@ KeywordsDictionary::KeywordsDictionary() {
   keywords_.insert({"__builtin_offsetof", Tag::kOffsetof});
   keywords_.insert({"__builtin_huge_val", Tag::kHugeVal});
   keywords_.insert({"__builtin_inff", Tag::kInff});
+  keywords_.insert({"__builtin_embed", Tag::kEmbed});
 
   // GNU 扩展
   keywords_.insert({"typeof", Tag::kTypeof});
   keywords_.insert({"__typeof__", Tag::kTypeof});
+  keywords_.insert({"__auto_type", Tag::kAutoType});
+  keywords_.insert({"__int128", Tag::kInt128});
   keywords_.insert({"__attribute__", Tag::kAttribute});
   keywords_.insert({"__extension__", Tag::kExtension});
   keywords_.insert({"__FUNCTION__", Tag::kFuncName});
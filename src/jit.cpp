@@ -0,0 +1,150 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+#include "jit.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "error.h"
+#include "llvm_common.h"
+#include "mem_report.h"
+#include "util.h"
+
+namespace kcc {
+
+namespace {
+
+void CheckError(llvm::Error error) {
+  if (error) {
+    Error("JIT error: {}", llvm::toString(std::move(error)));
+  }
+}
+
+template <typename T>
+T CheckError(llvm::Expected<T> value) {
+  if (!value) {
+    Error("JIT error: {}", llvm::toString(value.takeError()));
+  }
+  return std::move(*value);
+}
+
+// Module 属于全局的 Context, 而 JIT 需要拥有模块和它的 LLVMContext,
+// 因此经过 bitcode 复制到新的 LLVMContext 中
+llvm::orc::ThreadSafeModule CloneToThreadSafeModule() {
+  llvm::SmallString<0> bitcode;
+  llvm::raw_svector_ostream os{bitcode};
+  llvm::WriteBitcodeToFile(*Module, os);
+
+  auto context{std::make_unique<llvm::LLVMContext>()};
+  auto module{CheckError(llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef{bitcode, Module->getName()}, *context))};
+  return {std::move(module), std::move(context)};
+}
+
+// 程序中调用的库函数通过 dlsym 在本进程中查找, -l / .so 指定的库
+// 以 RTLD_GLOBAL 加载后也能被找到
+void LoadLibraries() {
+  auto load{[](const std::string &lib) {
+    std::string error;
+    if (llvm::sys::DynamicLibrary::LoadLibraryPermanently(lib.c_str(),
+                                                          &error)) {
+      Warning("--run: can't load '{}': {}", lib, error);
+    }
+  }};
+
+  for (const auto &item : SoFile) {
+    load(item);
+  }
+
+  // CommandLineCheck 已经加上了 -l 前缀, libm 等已经在 kcc 进程中
+  for (const auto &item : Libs) {
+    auto name{item.substr(2)};
+    if (name != "m" && name != "c" && name != "dl" && name != "pthread") {
+      load("lib" + name + ".so");
+    }
+  }
+
+  if (FOpenMP) {
+    load("libgomp.so.1");
+  }
+}
+
+}  // namespace
+
+void RunJit(const std::string &file_name) {
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  llvm::JITEvaluatedSymbol main_symbol;
+  {
+    llvm::TimeTraceScope scope{"RunJit", file_name};
+
+    // 与生成目标文件时使用相同的 CPU, 特性和浮点选项
+    auto jtmb{CheckError(llvm::orc::JITTargetMachineBuilder::detectHost())};
+    jtmb.setCPU(TargetCPU);
+    jtmb.getFeatures() = llvm::SubtargetFeatures{TargetFeatures};
+    jtmb.setOptions(TargetMachine->Options);
+
+    auto module{CloneToThreadSafeModule()};
+    if (FJitLazy) {
+      // 函数在第一次被调用时才生成代码
+      auto lazy_jit{CheckError(llvm::orc::LLLazyJITBuilder{}
+                                   .setJITTargetMachineBuilder(std::move(jtmb))
+                                   .create())};
+      CheckError(lazy_jit->addLazyIRModule(std::move(module)));
+      jit = std::move(lazy_jit);
+    } else {
+      jit = CheckError(llvm::orc::LLJITBuilder{}
+                           .setJITTargetMachineBuilder(std::move(jtmb))
+                           .create());
+      CheckError(jit->addIRModule(std::move(module)));
+    }
+
+    LoadLibraries();
+    jit->getMainJITDylib().addGenerator(CheckError(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            jit->getDataLayout().getGlobalPrefix())));
+
+    main_symbol = CheckError(jit->lookup("main"));
+  }
+  MemReportPhase("JIT");
+
+  // 程序以 std::exit 结束, 在运行前输出编译过程的报告,
+  // -fjit-lazy 时之后才生成的函数不包括在内
+  TimeTraceEnd(GetAuxFileName(file_name, ".json"));
+  MemReportPrint(GetAuxFileName(file_name, ".mem.json"));
+
+  auto &dylib{jit->getMainJITDylib()};
+  auto main_func{reinterpret_cast<int (*)(int, char *[])>(
+      static_cast<std::uintptr_t>(main_symbol.getAddress()))};
+
+  // 延迟到这里输出, 以免与程序的输出交错
+  PrintWarnings();
+
+  CheckError(jit->initialize(dylib));
+  auto exit_code{llvm::orc::runAsMain(main_func, RunArgs,
+                                       llvm::StringRef{file_name})};
+  CheckError(jit->deinitialize(dylib));
+
+  // 程序用 atexit 注册的函数位于 JIT 的内存中, 必须在 jit 析构前退出
+  std::exit(exit_code);
+}
+
+}  // namespace kcc
@@ -211,6 +211,21 @@ void JsonGen::Visit(const StmtExpr *node) {
   result_ = root;
 }
 
+void JsonGen::Visit(const LabelAddrExpr *node) {
+  boost::json::object root;
+  root["name"] = node->KindQString();
+
+  boost::json::array children;
+
+  boost::json::object name;
+  name["name"] = "label: " + node->GetName();
+  children.push_back(name);
+
+  root["children"] = children;
+
+  result_ = root;
+}
+
 void JsonGen::Visit(const LabelStmt *node) {
   boost::json::object root;
   root["name"] = node->KindQString();
@@ -413,9 +428,14 @@ void JsonGen::Visit(const GotoStmt *node) {
   root["name"] = node->KindQString();
 
   boost::json::array children;
-  boost::json::object name;
-  name["name"] = "label: " + node->GetName();
-  children.push_back(name);
+  if (auto expr{node->GetExpr()}) {
+    expr->Accept(*this);
+    children.push_back(result_);
+  } else {
+    boost::json::object name;
+    name["name"] = "label: " + node->GetName();
+    children.push_back(name);
+  }
 
   root["children"] = children;
 
@@ -453,6 +473,72 @@ void JsonGen::Visit(const ReturnStmt *node) {
   result_ = root;
 }
 
+void JsonGen::Visit(const AsmStmt *node) {
+  boost::json::object root;
+  root["name"] = node->KindQString().append(": ").append(node->GetAsmString());
+
+  boost::json::array children;
+  auto add_operands{[&](const std::vector<AsmStmt::Operand> &operands,
+                         const std::string &kind) {
+    for (const auto &[name, constraint, expr] : operands) {
+      boost::json::object obj;
+      obj["name"] = kind + ": " + constraint;
+
+      boost::json::array operand;
+      expr->Accept(*this);
+      operand.push_back(result_);
+      obj["children"] = operand;
+
+      children.push_back(obj);
+    }
+  }};
+  add_operands(node->GetOutputs(), "output");
+  add_operands(node->GetInputs(), "input");
+
+  for (const auto &item : node->GetClobbers()) {
+    boost::json::object obj;
+    obj["name"] = "clobber: " + item;
+    children.push_back(obj);
+  }
+  for (const auto &item : node->GetLabels()) {
+    boost::json::object obj;
+    obj["name"] = "label: " + item->GetName();
+    children.push_back(obj);
+  }
+
+  root["children"] = children;
+
+  result_ = root;
+}
+
+void JsonGen::Visit(const OmpStmt *node) {
+  boost::json::object root;
+  root["name"] = node->KindQString().append(": ").append(
+      magic_enum::enum_name(node->GetDirective()));
+
+  boost::json::array children;
+  const auto &clauses{node->GetClauses()};
+  for (const auto &item : clauses.privates) {
+    boost::json::object obj;
+    obj["name"] = "private: " + item->GetName();
+    children.push_back(obj);
+  }
+  for (const auto &[op, item] : clauses.reductions) {
+    boost::json::object obj;
+    obj["name"] = "reduction: " + op + " " + item->GetName();
+    children.push_back(obj);
+  }
+
+  if (node->GetBlock()) {
+    node->GetBlock()->Accept(*this);
+    children.push_back(result_);
+  }
+
+  root["children"] = children;
+
+  result_ = root;
+}
+
 void JsonGen::Visit(const TranslationUnit *node) {
   boost::json::object root;
   root["name"] = node->KindQString();
@@ -4,17 +4,25 @@
 
 #include "lex.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cstring>
 
+#include <llvm/Support/TimeProfiler.h>
 #include <magic_enum.hpp>
 
 #include "error.h"
+#include "util.h"
 
 namespace kcc {
 
 namespace {
 
+// 不影响代码生成, 忽略时不需要警告
+constexpr const char *IgnoredPragmas[]{"GCC diagnostic", "clang diagnostic",
+                                       "GCC visibility", "once"};
+
 bool IsOctDigit(std::int32_t ch) { return ch >= '0' && ch <= '7'; }
 
 std::int32_t CharToDigit(std::int32_t ch) {
@@ -43,6 +51,8 @@ Scanner::Scanner(std::string code, const Location &loc)
 }
 
 std::vector<Token> Scanner::Tokenize() {
+  llvm::TimeTraceScope scope{"Scanner::Tokenize"};
+
   std::vector<Token> token_sequence;
   token_sequence.reserve(Scanner::TokenReserve);
 
@@ -328,7 +338,13 @@ const Token &Scanner::Scan() {
     case ',':
       return MakeToken(Tag::kComma);
     case '#':
-      SkipLineDirectives();
+      if (IsPragma()) {
+        if (SkipPragma()) {
+          return MakeToken(Tag::kPragma);
+        }
+      } else {
+        SkipLineDirectives();
+      }
       return Scan();
     case '0':
     case '1':
@@ -415,6 +431,62 @@ void Scanner::SkipLineDirectives() {
   buffer_.clear();
 }
 
+// clang 会原样输出它不认识的 #pragma
+bool Scanner::IsPragma() const {
+  auto begin{source_.find_first_not_of(" \t", index_)};
+  return begin != std::string::npos && source_.compare(begin, 6, "pragma") == 0;
+}
+
+// 只保留作用于循环的 #pragma 和 OpenMP 指令, token 的内容为 pragma 之后的部分
+// e.g. unroll 4 / GCC unroll 4 / GCC ivdep / clang loop vectorize(enable)
+bool Scanner::SkipPragma() {
+  buffer_.clear();
+
+  while (Test(' ') || Test('\t')) {
+    Next(false);
+  }
+  // eat pragma
+  for (std::int32_t i{}; i < 6; ++i) {
+    Next(false);
+  }
+
+  while (HasNext() && !Test('\n')) {
+    Next();
+  }
+
+  auto begin{buffer_.find_first_not_of(" \t")};
+  auto end{buffer_.find_last_not_of(" \t\r")};
+  buffer_ = begin == std::string::npos
+                ? ""
+                : buffer_.substr(begin, end - begin + 1);
+
+  for (const auto &prefix :
+       {"unroll", "nounroll", "GCC unroll", "GCC ivdep", "clang loop"}) {
+    if (buffer_.compare(0, std::strlen(prefix), prefix) == 0) {
+      return true;
+    }
+  }
+
+  // 没有 -fopenmp 时忽略 OpenMP 指令
+  if (buffer_.compare(0, 4, "omp ") == 0) {
+    if (FOpenMP) {
+      return true;
+    }
+  } else if (buffer_.compare(0, 4, "pack") == 0) {
+    // 忽略会使结构体布局与其他编译器不一致
+    Error(token_.GetLoc(), "'#pragma {}' is not supported", buffer_);
+  } else if (std::none_of(std::begin(IgnoredPragmas), std::end(IgnoredPragmas),
+                          [&](const char *prefix) {
+                            return buffer_.compare(0, std::strlen(prefix),
+                                                   prefix) == 0;
+                          })) {
+    Warning(token_.GetLoc(), "unknown pragma ignored: '#pragma {}'", buffer_);
+  }
+
+  buffer_.clear();
+  return false;
+}
+
 // pp-number:
 //  digit
 //  . digit
@@ -5,6 +5,7 @@
 #include "link.h"
 
 #include <lld/Common/Driver.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include "util.h"
@@ -12,6 +13,8 @@
 namespace kcc {
 
 bool Link() {
+  llvm::TimeTraceScope scope{"Link", OutputFilePath.getValue()};
+
   /*
    * Platform Specific Code
    */
@@ -78,18 +81,58 @@ bool Link() {
     args.push_back(item.c_str());
   }
 
+  // OpenMP 的区域和工作共享循环通过 GOMP_* 函数调用 libgomp
+  if (FOpenMP) {
+    args.push_back("-lgomp");
+  }
+
+  // -fprofile-generate 时需要链接 profile 运行时库, 它负责在程序退出时
+  // 写入 .profraw 文件
+  if (ProfileGenerate()) {
+    args.push_back("-u__llvm_profile_runtime");
+    args.push_back(KCC_CLANG_RESOURCE_DIR
+                   "/lib/linux/libclang_rt.profile-x86_64.a");
+  }
+
   std::string str{"-o" + OutputFilePath};
   args.push_back(str.c_str());
 
+  // 输入中有 bitcode 文件(-flto)时, lld 在进程内使用 llvm::lto::LTO
+  // 进行链接时优化, ThinLTO 的后端并行执行, 生成的目标文件不会写入磁盘
+  // --lto-O 只接受 0 ~ 3, -Os / -Oz 按 O2 处理
   auto level{static_cast<std::int32_t>(OptimizationLevel.getValue())};
-  std::string level_str{"-plugin-opt=O" + std::to_string(level)};
-  if (level != 0) {
-    args.push_back("-plugin=/usr/bin/../lib/LLVMgold.so");
-    args.push_back(level_str.c_str());
+  if (OptimizationLevel == OptLevel::kOs ||
+      OptimizationLevel == OptLevel::kOz) {
+    level = 2;
+  }
+  std::string level_str{"--lto-O" + std::to_string(level)};
+  args.push_back(level_str.c_str());
+  args.push_back("--thinlto-jobs=all");
+
+  std::string cache_dir_str{"--thinlto-cache-dir=" +
+                            FLtoCacheDir.getValue()};
+  if (FLto == LTOKind::kThin && !std::empty(FLtoCacheDir)) {
+    args.push_back(cache_dir_str.c_str());
   }
 
   // TODO 后两个参数的作用
   return lld::elf::link(args, false, llvm::outs(), llvm::errs());
 }
 
+bool LinkRelocatable(const std::vector<std::string> &obj_files,
+                     const std::string &output) {
+  llvm::TimeTraceScope scope{"LinkRelocatable", output};
+
+  // 第一个参数被当作程序名忽略
+  std::vector<const char *> args{"ld.lld", "-r"};
+  for (const auto &item : obj_files) {
+    args.push_back(item.c_str());
+  }
+
+  std::string str{"-o" + output};
+  args.push_back(str.c_str());
+
+  return lld::elf::link(args, false, llvm::outs(), llvm::errs());
+}
+
 }  // namespace kcc
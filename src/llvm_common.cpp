@@ -4,7 +4,10 @@
 
 #include "llvm_common.h"
 
+#include <algorithm>
 #include <cassert>
+#include <unordered_set>
+#include <vector>
 
 #include <clang/Basic/LangOptions.h>
 #include <clang/Basic/LangStandard.h>
@@ -12,6 +15,9 @@
 #include <clang/Frontend/FrontendOptions.h>
 #include <clang/Lex/PreprocessorOptions.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/DerivedTypes.h>
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/Host.h>
@@ -21,9 +27,80 @@
 #include <llvm/Target/TargetOptions.h>
 
 #include "error.h"
+#include "util.h"
 
 namespace kcc {
 
+namespace {
+
+std::string ResolveCPU(const std::string &cpu) {
+  if (cpu == "native") {
+    return llvm::sys::getHostCPUName().str();
+  } else {
+    return cpu;
+  }
+}
+
+// 返回 +feature / -feature 形式的列表
+std::vector<std::string> GetTargetFeatures(bool native) {
+  std::vector<std::string> features;
+
+  if (llvm::StringMap<bool> host_features;
+      native && llvm::sys::getHostCPUFeatures(host_features)) {
+    for (const auto &item : host_features) {
+      features.push_back((item.getValue() ? "+" : "-") + item.getKey().str());
+    }
+    // 保证结果稳定
+    std::sort(std::begin(features), std::end(features));
+  }
+
+  // 后出现的选项覆盖先出现的
+  for (const auto &item : TargetFeatureOptions) {
+    if (item.rfind("no-", 0) == 0) {
+      features.push_back("-" + item.substr(3));
+    } else {
+      features.push_back("+" + item);
+    }
+  }
+
+  return features;
+}
+
+// 根据 -ffast-math 等选项设置 Builder 创建浮点运算时默认使用的标志
+void InitFloatingPointModel() {
+  llvm::FastMathFlags fmf;
+
+  if (FFastMath) {
+    fmf.setFast();
+  }
+  if (FFiniteMathOnly) {
+    fmf.setNoNaNs();
+    fmf.setNoInfs();
+  }
+  if (FNoSignedZeros) {
+    fmf.setNoSignedZeros();
+  }
+  if (FReciprocalMath) {
+    fmf.setAllowReciprocal();
+  }
+  if (FAssociativeMath) {
+    fmf.setAllowReassoc();
+  }
+
+  // -ffast-math 隐含 -ffp-contract=fast, 除非显式指定
+  if (FFastMath && FFpContract.getNumOccurrences() == 0) {
+    FFpContract = FPContract::kFast;
+  }
+  if (FFpContract == FPContract::kFast) {
+    fmf.setAllowContract();
+  }
+
+  Builder.setFastMathFlags(fmf);
+  MathErrno = !(FFastMath || FNoMathErrno);
+}
+
+}  // namespace
+
 void InitLLVM() {
   llvm::InitializeAllTargets();
   llvm::InitializeAllTargetInfos();
@@ -33,11 +110,47 @@ void InitLLVM() {
 
   Ci.createDiagnostics();
 
+  InitFloatingPointModel();
+  auto fmf{Builder.getFastMathFlags()};
+
+  // 默认使用通用 CPU
+  TargetCPU = "generic";
+  if (!std::empty(March)) {
+    TargetCPU = ResolveCPU(March);
+  } else if (!std::empty(Mcpu)) {
+    TargetCPU = ResolveCPU(Mcpu);
+  }
+  if (!std::empty(Mtune)) {
+    TuneCPU = ResolveCPU(Mtune);
+  }
+
+  auto features{GetTargetFeatures(March == "native" ||
+                                  (std::empty(March) && Mcpu == "native"))};
+  TargetFeatures = llvm::join(features, ",");
+
   auto pto{std::make_shared<clang::TargetOptions>()};
   auto target_triple{llvm::sys::getDefaultTargetTriple()};
   pto->Triple = target_triple;
+  // clang 的 TargetInfo 会据此定义 __AVX2__ 等预定义宏
+  if (TargetCPU != "generic") {
+    pto->CPU = TargetCPU;
+  }
+  pto->TuneCPU = TuneCPU;
+  pto->FeaturesAsWritten = features;
 
   TargetInfo = clang::TargetInfo::CreateTargetInfo(Ci.getDiagnostics(), pto);
+  if (!TargetInfo) {
+    Error("invalid target CPU or feature");
+  }
+
+  // -m 是前缀选项, 只接受目标支持的特性名, 以免 -m64 等被当作特性
+  for (const auto &item : TargetFeatureOptions) {
+    auto name{item.rfind("no-", 0) == 0 ? item.substr(3) : item};
+    if (!TargetInfo->isValidFeatureName(name)) {
+      Error("unsupported option '-m{}': unknown target feature '{}'", item,
+            name);
+    }
+  }
 
   Ci.setTarget(TargetInfo);
   Ci.getInvocation().setLangDefaults(
@@ -51,6 +164,10 @@ void InitLLVM() {
   lang_opt.Trigraphs = true;
   lang_opt.GNUMode = true;
   lang_opt.GNUKeywords = true;
+  // 用于定义 __FAST_MATH__ 和 __FINITE_MATH_ONLY__
+  lang_opt.FastMath = FFastMath;
+  lang_opt.FiniteMathOnly = fmf.noNaNs() && fmf.noInfs();
+  lang_opt.MathErrno = MathErrno;
 
   Ci.createFileManager();
   Ci.createSourceManager(Ci.getFileManager());
@@ -62,6 +179,18 @@ void InitLLVM() {
   Module->addModuleFlag(llvm::Module::Max, "PIC Level", llvm::PICLevel::BigPIC);
   Module->addModuleFlag(llvm::Module::Max, "PIE Level", llvm::PIELevel::Large);
 
+  TargetMachine = CreateTargetMachine();
+
+  // 配置模块以指定目标机器和数据布局
+  Module->setTargetTriple(target_triple);
+  Module->setDataLayout(TargetMachine->createDataLayout());
+}
+
+// 每个代码生成线程需要自己的 TargetMachine, 见 -fparallel-codegen
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine() {
+  auto target_triple{llvm::sys::getDefaultTargetTriple()};
+  auto fmf{Builder.getFastMathFlags()};
+
   std::string error;
   auto target{llvm::TargetRegistry::lookupTarget(target_triple, error)};
 
@@ -69,17 +198,21 @@ void InitLLVM() {
     Error(error);
   }
 
-  // 使用通用CPU, 生成位置无关目标文件
-  std::string cpu("generic");
-  std::string features;
+  // 生成位置无关目标文件
   llvm::TargetOptions opt;
+  opt.UnsafeFPMath =
+      fmf.allowReassoc() && fmf.noSignedZeros() && fmf.allowReciprocal();
+  opt.NoInfsFPMath = fmf.noInfs();
+  opt.NoNaNsFPMath = fmf.noNaNs();
+  opt.NoSignedZerosFPMath = fmf.noSignedZeros();
+  if (FFpContract == FPContract::kFast) {
+    opt.AllowFPOpFusion = llvm::FPOpFusion::Fast;
+  } else if (FFpContract == FPContract::kOff) {
+    opt.AllowFPOpFusion = llvm::FPOpFusion::Strict;
+  }
   llvm::Optional<llvm::Reloc::Model> rm{llvm::Reloc::Model::PIC_};
-  TargetMachine = std::unique_ptr<llvm::TargetMachine>{
-      target->createTargetMachine(target_triple, cpu, features, opt, rm)};
-
-  // 配置模块以指定目标机器和数据布局
-  Module->setTargetTriple(target_triple);
-  Module->setDataLayout(TargetMachine->createDataLayout());
+  return std::unique_ptr<llvm::TargetMachine>{target->createTargetMachine(
+      target_triple, TargetCPU, TargetFeatures, opt, rm)};
 }
 
 std::string LLVMTypeToStr(llvm::Type *type) {
@@ -109,7 +242,7 @@ llvm::Constant *GetConstantZero(llvm::Type *type) {
     return llvm::ConstantFP::get(type, 0.0);
   } else if (type->isPointerTy()) {
     return llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(type));
-  } else if (type->isAggregateType()) {
+  } else if (type->isAggregateType() || type->isVectorTy()) {
     return llvm::ConstantAggregateZero::get(type);
   } else {
     assert(false);
@@ -145,14 +278,15 @@ bool IsArrCastToPtr(llvm::Value *value, llvm::Type *type) {
                  ->getPointerTo() == type;
 }
 
+// 对于向量判断的是元素类型
 bool IsIntegerTy(llvm::Value *value) {
   assert(value != nullptr);
-  return value->getType()->isIntegerTy();
+  return value->getType()->isIntOrIntVectorTy();
 }
 
 bool IsFloatingPointTy(llvm::Value *value) {
   assert(value != nullptr);
-  return value->getType()->isFloatingPointTy();
+  return value->getType()->isFPOrFPVectorTy();
 }
 
 bool IsPointerTy(llvm::Value *value) {
@@ -174,6 +308,16 @@ llvm::Constant *ConstantCastTo(llvm::Constant *value, llvm::Type *to,
                                bool is_unsigned) {
   assert(value != nullptr && to != nullptr);
 
+  if (auto vector_type{llvm::dyn_cast<llvm::FixedVectorType>(to)}) {
+    if (value->getType()->isVectorTy()) {
+      return llvm::ConstantExpr::getBitCast(value, to);
+    } else {
+      return llvm::ConstantVector::getSplat(
+          vector_type->getElementCount(),
+          ConstantCastTo(value, vector_type->getElementType(), is_unsigned));
+    }
+  }
+
   if (to->isIntegerTy(1)) {
     return ConstantCastToBool(value);
   }
@@ -246,6 +390,17 @@ llvm::Constant *ConstantCastToBool(llvm::Constant *value) {
 llvm::Value *CastTo(llvm::Value *value, llvm::Type *to, bool is_unsigned) {
   assert(value != nullptr && to != nullptr);
 
+  // 向量之间按位转换, 标量先转换为元素类型再复制到每个元素
+  if (auto vector_type{llvm::dyn_cast<llvm::FixedVectorType>(to)}) {
+    if (value->getType()->isVectorTy()) {
+      return Builder.CreateBitCast(value, to);
+    } else {
+      return Builder.CreateVectorSplat(
+          vector_type->getNumElements(),
+          CastTo(value, vector_type->getElementType(), is_unsigned));
+    }
+  }
+
   if (to->isIntegerTy(1)) {
     return CastToBool(value);
   }
@@ -317,6 +472,8 @@ llvm::Value *GetZero(llvm::Type *type) {
     return llvm::ConstantFP::get(type, 0.0);
   } else if (type->isPointerTy()) {
     return llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(type));
+  } else if (type->isVectorTy()) {
+    return llvm::ConstantAggregateZero::get(type);
   } else {
     assert(false);
     return nullptr;
@@ -353,7 +510,7 @@ llvm::GlobalVariable *CreateGlobalVar(const ObjectExpr *obj) {
     }
   }
 
-  auto name{obj->GetName()};
+  auto name{obj->GetLinkName()};
 
   if (auto iter{GlobalVarMap.find(name)}; iter != std::end(GlobalVarMap)) {
     ptr = iter->second;
@@ -382,6 +539,27 @@ llvm::GlobalVariable *CreateGlobalVar(const ObjectExpr *obj) {
   return ptr;
 }
 
+bool IsMathLibFunc(llvm::StringRef name) {
+  // 只包含可能设置 errno 的函数, lgamma 会修改 signgam, 不能视为无副作用
+  static const auto names{[] {
+    std::unordered_set<std::string> result;
+    for (std::string item :
+         {"acos", "asin", "atan", "atan2", "cos", "sin", "tan", "cosh", "sinh",
+          "tanh", "acosh", "asinh", "atanh", "exp", "exp2", "expm1", "log",
+          "log10", "log1p", "log2", "logb", "ilogb", "pow", "sqrt", "cbrt",
+          "hypot", "fmod", "remainder", "ldexp", "erf", "erfc", "tgamma", "fma",
+          "scalbn", "scalbln", "lrint", "llrint", "lround", "llround",
+          "nearbyint", "rint"}) {
+      result.insert(item);
+      result.insert(item + "f");
+      result.insert(item + "l");
+    }
+    return result;
+  }()};
+
+  return names.count(name.str());
+}
+
 const llvm::fltSemantics &GetFloatTypeSemantics(llvm::Type *type) {
   assert(type->isFloatingPointTy());
 
@@ -409,6 +587,10 @@ std::int32_t GetLLVMTypeSize(llvm::Type *type) {
   return Module->getDataLayout().getTypeAllocSize(type);
 }
 
+std::int32_t GetLLVMTypeAlign(llvm::Type *type) {
+  return Module->getDataLayout().getABITypeAlign(type).value();
+}
+
 llvm::Constant *GetBitField(llvm::Constant *value, std::int32_t size,
                             std::int32_t width, std::int32_t begin) {
   if (size == 8) {
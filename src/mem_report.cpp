@@ -0,0 +1,202 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+#include "mem_report.h"
+
+#include <sys/resource.h>
+
+#include <cstdint>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+#include <fmt/format.h>
+
+#include "llvm_common.h"
+#include "memory_pool.h"
+#include "util.h"
+
+namespace kcc {
+
+namespace {
+
+struct Entry {
+  std::string name;
+  std::size_t count;
+  std::size_t bytes;
+};
+
+std::vector<std::pair<std::string, std::int64_t>> Phases;
+std::vector<Entry> Buffers;
+
+// Linux 下单位为 KB
+std::int64_t GetPeakRSS() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+template <typename T>
+void AddPool(std::vector<Entry> &pools, std::string name,
+             const ObjectPool<T> &pool) {
+  pools.push_back({std::move(name), pool.GetCount(), pool.GetBytes()});
+}
+
+std::vector<Entry> GetPools() {
+  std::vector<Entry> pools;
+
+#define KCC_ADD_POOL(type) AddPool(pools, #type, type##Pool)
+  KCC_ADD_POOL(UnaryOpExpr);
+  KCC_ADD_POOL(TypeCastExpr);
+  KCC_ADD_POOL(BinaryOpExpr);
+  KCC_ADD_POOL(ConditionOpExpr);
+  KCC_ADD_POOL(FuncCallExpr);
+  KCC_ADD_POOL(ConstantExpr);
+  KCC_ADD_POOL(StringLiteralExpr);
+  KCC_ADD_POOL(IdentifierExpr);
+  KCC_ADD_POOL(EnumeratorExpr);
+  KCC_ADD_POOL(ObjectExpr);
+  KCC_ADD_POOL(StmtExpr);
+  KCC_ADD_POOL(LabelAddrExpr);
+
+  KCC_ADD_POOL(LabelStmt);
+  KCC_ADD_POOL(CaseStmt);
+  KCC_ADD_POOL(DefaultStmt);
+  KCC_ADD_POOL(CompoundStmt);
+  KCC_ADD_POOL(ExprStmt);
+  KCC_ADD_POOL(IfStmt);
+  KCC_ADD_POOL(SwitchStmt);
+  KCC_ADD_POOL(WhileStmt);
+  KCC_ADD_POOL(DoWhileStmt);
+  KCC_ADD_POOL(ForStmt);
+  KCC_ADD_POOL(GotoStmt);
+  KCC_ADD_POOL(ContinueStmt);
+  KCC_ADD_POOL(BreakStmt);
+  KCC_ADD_POOL(ReturnStmt);
+  KCC_ADD_POOL(AsmStmt);
+  KCC_ADD_POOL(OmpStmt);
+
+  KCC_ADD_POOL(TranslationUnit);
+  KCC_ADD_POOL(Declaration);
+  KCC_ADD_POOL(FuncDef);
+
+  KCC_ADD_POOL(VoidType);
+  KCC_ADD_POOL(ArithmeticType);
+  KCC_ADD_POOL(PointerType);
+  KCC_ADD_POOL(ArrayType);
+  KCC_ADD_POOL(VectorType);
+  KCC_ADD_POOL(StructType);
+  KCC_ADD_POOL(FunctionType);
+
+  KCC_ADD_POOL(Scope);
+#undef KCC_ADD_POOL
+
+  return pools;
+}
+
+boost::json::array ToJson(const std::vector<Entry> &entries) {
+  boost::json::array arr;
+  for (const auto &item : entries) {
+    arr.push_back(
+        {{"name", item.name}, {"count", item.count}, {"bytes", item.bytes}});
+  }
+  return arr;
+}
+
+}  // namespace
+
+void MemReportPhase(std::string_view phase) {
+  if (FMemReport) {
+    Phases.emplace_back(phase, GetPeakRSS());
+  }
+}
+
+void MemReportBuffer(std::string_view name, std::size_t count,
+                     std::size_t bytes) {
+  if (FMemReport) {
+    Buffers.push_back({std::string{name}, count, bytes});
+  }
+}
+
+void MemReportPrint(const std::string &json_file) {
+  if (!FMemReport) {
+    return;
+  }
+
+  boost::json::object root;
+  root["file"] = Module->getSourceFileName();
+
+  fmt::print(stderr, FMT_STRING("*** Memory Usage: {} ***\n"),
+             Module->getSourceFileName());
+
+  auto pools{GetPools()};
+  std::size_t total_count{}, total_bytes{};
+  fmt::print(stderr, FMT_STRING("{:<20}{:>12}{:>14}\n"), "Pool", "Objects",
+             "Bytes");
+  for (const auto &item : pools) {
+    if (item.count != 0) {
+      fmt::print(stderr, FMT_STRING("{:<20}{:>12}{:>14}\n"), item.name,
+                 item.count, item.bytes);
+    }
+    total_count += item.count;
+    total_bytes += item.bytes;
+  }
+  fmt::print(stderr, FMT_STRING("{:<20}{:>12}{:>14}\n\n"), "Total",
+             total_count, total_bytes);
+  root["pools"] = ToJson(pools);
+  root["pool_bytes"] = total_bytes;
+
+  fmt::print(stderr, FMT_STRING("{:<20}{:>12}{:>14}\n"), "Buffer", "Elements",
+             "Bytes");
+  for (const auto &item : Buffers) {
+    fmt::print(stderr, FMT_STRING("{:<20}{:>12}{:>14}\n"), item.name,
+               item.count, item.bytes);
+  }
+  fmt::print(stderr, "\n");
+  root["buffers"] = ToJson(Buffers);
+
+  auto [scope_size, scope_bucket_count]{Scope::GetHashMapStats()};
+  fmt::print(stderr,
+             FMT_STRING("Scopes: {}, identifiers: {}, hash buckets: {}\n"),
+             ScopePool.GetCount(), scope_size, scope_bucket_count);
+  root["scopes"] = {{"count", ScopePool.GetCount()},
+                    {"identifiers", scope_size},
+                    {"buckets", scope_bucket_count}};
+
+  fmt::print(stderr, FMT_STRING("StringMap: {}, GlobalVarMap: {}\n"),
+             std::size(StringMap), std::size(GlobalVarMap));
+  root["string_map"] = std::size(StringMap);
+  root["global_var_map"] = std::size(GlobalVarMap);
+
+  std::size_t functions{}, basic_blocks{}, instructions{};
+  for (const auto &func : *Module) {
+    if (func.isDeclaration()) {
+      continue;
+    }
+    ++functions;
+    basic_blocks += std::size(func);
+    instructions += func.getInstructionCount();
+  }
+  fmt::print(stderr,
+             FMT_STRING("LLVM Module: {} functions, {} basic blocks, {} "
+                        "instructions\n\n"),
+             functions, basic_blocks, instructions);
+  root["module"] = {{"functions", functions},
+                    {"basic_blocks", basic_blocks},
+                    {"instructions", instructions}};
+
+  boost::json::array phases;
+  fmt::print(stderr, FMT_STRING("{:<20}{:>14}\n"), "Phase", "Peak RSS (KB)");
+  for (const auto &[phase, rss] : Phases) {
+    fmt::print(stderr, FMT_STRING("{:<20}{:>14}\n"), phase, rss);
+    phases.push_back({{"phase", phase}, {"peak_rss_kb", rss}});
+  }
+  root["phases"] = phases;
+
+  std::ofstream ofs{json_file};
+  ofs << boost::json::serialize(root) << std::endl;
+}
+
+}  // namespace kcc
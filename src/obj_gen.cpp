@@ -4,18 +4,183 @@
 
 #include "obj_gen.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
 #include <system_error>
+#include <vector>
 
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/Error.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 
 #include "error.h"
+#include "link.h"
 #include "llvm_common.h"
+#include "util.h"
 
 namespace kcc {
 
+namespace {
+
+// 收集使用 value 的全局值(函数或全局变量), 经过常量表达式时继续向上查找
+void CollectGlobalUsers(
+    const llvm::Value *value,
+    llvm::SmallPtrSetImpl<const llvm::GlobalValue *> &users) {
+  for (auto user : value->users()) {
+    if (auto inst{llvm::dyn_cast<llvm::Instruction>(user)}) {
+      users.insert(inst->getFunction());
+    } else if (auto gv{llvm::dyn_cast<llvm::GlobalValue>(user)}) {
+      users.insert(gv);
+    } else {
+      CollectGlobalUsers(user, users);
+    }
+  }
+}
+
+// SplitModule 使用 PreserveLocals, 内部链接符号会和它的使用者分到同一分区,
+// 被多个函数或全局变量使用的符号若保持内部链接, 会把使用者都聚到一个分区,
+// 所以只将这些符号改为外部链接, 加上后缀以免与其他翻译单元中同名的 static
+// 符号冲突, 输出文件名可能相同(e.g. 不同目录下的 -o a.o),
+// 所以由源文件的绝对路径和模块中定义的外部符号得到
+void PromoteLocals(llvm::Module &module) {
+  llvm::MD5 md5;
+  md5.update(std::filesystem::absolute(module.getSourceFileName()).string());
+  md5.update(llvm::getUniqueModuleId(&module));
+
+  llvm::MD5::MD5Result result;
+  md5.final(result);
+  auto suffix{".kcc." + llvm::utohexstr(result.low())};
+
+  for (auto &gv : module.global_values()) {
+    if (!gv.hasLocalLinkage()) {
+      continue;
+    }
+
+    llvm::SmallPtrSet<const llvm::GlobalValue *, 4> users;
+    CollectGlobalUsers(&gv, users);
+    if (std::size(users) > 1) {
+      gv.setName(gv.getName() + suffix);
+      gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      gv.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+  }
+}
+
+// 在线程自己的 LLVMContext 中读入分区并生成目标文件
+// 工作线程中不能调用 Error 退出, 出错时返回错误信息, 由主线程报告
+std::string ObjGenPartition(llvm::StringRef bitcode,
+                            const std::string &obj_file) {
+  llvm::LLVMContext context;
+  auto module{llvm::parseBitcodeFile(llvm::MemoryBufferRef{bitcode, obj_file},
+                                     context)};
+  if (!module) {
+    return "Could not read partition: '" +
+           llvm::toString(module.takeError()) + "'";
+  }
+
+  std::error_code error_code;
+  llvm::raw_fd_ostream dest{obj_file, error_code, llvm::sys::fs::F_None};
+
+  if (error_code) {
+    return "Could not open file: '" + error_code.message() + "'";
+  }
+
+  auto target_machine{CreateTargetMachine()};
+  llvm::legacy::PassManager pass;
+
+  if (target_machine->addPassesToEmitFile(
+          pass, dest, nullptr, llvm::CodeGenFileType::CGFT_ObjectFile)) {
+    return "The TargetMachine can't emit a file of this type";
+  }
+
+  pass.run(**module);
+  dest.flush();
+
+  return {};
+}
+
+// -fparallel-codegen, 将优化后的模块划分为若干分区, 每个线程使用自己的
+// TargetMachine 生成一个目标文件, 最后用 ld -r 合并为 obj_file
+void ParallelObjGen(const std::string &obj_file) {
+  auto strategy{llvm::hardware_concurrency(FParallelCodegen)};
+
+  auto module{llvm::CloneModule(*Module)};
+  PromoteLocals(*module);
+
+  // LLVMContext 不是线程安全的, 分区以 bitcode 的形式交给代码生成线程
+  std::vector<llvm::SmallString<0>> bitcodes;
+  {
+    llvm::TimeTraceScope scope{"SplitModule", obj_file};
+    llvm::SplitModule(
+        std::move(module), strategy.compute_thread_count(),
+        [&](std::unique_ptr<llvm::Module> part) {
+          llvm::raw_svector_ostream os{bitcodes.emplace_back()};
+          llvm::WriteBitcodeToFile(*part, os);
+        },
+        true);
+  }
+
+  std::vector<std::string> part_files;
+  for (std::size_t i{}; i < std::size(bitcodes); ++i) {
+    part_files.push_back(obj_file + ".part" + std::to_string(i) + ".o");
+  }
+
+  std::vector<std::string> errors(std::size(bitcodes));
+  llvm::ThreadPool pool{strategy};
+  for (std::size_t i{}; i < std::size(bitcodes); ++i) {
+    pool.async(
+        [&, i] { errors[i] = ObjGenPartition(bitcodes[i], part_files[i]); });
+  }
+  pool.wait();
+
+  auto error{std::find_if(std::begin(errors), std::end(errors),
+                          [](const auto &item) { return !item.empty(); })};
+  auto success{error == std::end(errors) &&
+               LinkRelocatable(part_files, obj_file)};
+
+  std::error_code error_code;
+  for (const auto &item : part_files) {
+    std::filesystem::remove(item, error_code);
+  }
+
+  if (error != std::end(errors)) {
+    Error("{}", *error);
+  }
+  if (!success) {
+    Error("Could not link the partitions into '{}'", obj_file);
+  }
+}
+
+}  // namespace
+
 void ObjGen(const std::string &obj_file, llvm::CodeGenFileType file_type) {
+  llvm::TimeTraceScope scope{"ObjGen", obj_file};
+
+  // 汇编文件不能合并, 只有目标文件并行生成
+  if (FParallelCodegen != 1 &&
+      file_type == llvm::CodeGenFileType::CGFT_ObjectFile) {
+    ParallelObjGen(obj_file);
+    return;
+  }
+
   std::error_code error_code;
   llvm::raw_fd_ostream dest{obj_file, error_code, llvm::sys::fs::F_None};
 
@@ -34,4 +199,25 @@ void ObjGen(const std::string &obj_file, llvm::CodeGenFileType file_type) {
   dest.flush();
 }
 
+void BitcodeGen(const std::string &bc_file) {
+  llvm::TimeTraceScope scope{"BitcodeGen", bc_file};
+
+  std::error_code error_code;
+  llvm::raw_fd_ostream dest{bc_file, error_code, llvm::sys::fs::F_None};
+
+  if (error_code) {
+    Error("Could not open file: '{}'", error_code.message());
+  }
+
+  if (FLto == LTOKind::kThin) {
+    llvm::ProfileSummaryInfo psi{*Module};
+    auto index{llvm::buildModuleSummaryIndex(*Module, nullptr, &psi)};
+    llvm::WriteBitcodeToFile(*Module, dest, false, &index);
+  } else {
+    llvm::WriteBitcodeToFile(*Module, dest);
+  }
+
+  dest.flush();
+}
+
 }  // namespace kcc
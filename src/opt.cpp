@@ -4,130 +4,232 @@
 
 #include "opt.h"
 
-#include <cstdint>
+#include <cassert>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <string>
 
+#include <llvm/ADT/Optional.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
-#include <llvm/Analysis/TargetTransformInfo.h>
-#include <llvm/CodeGen/TargetPassConfig.h>
-#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/IR/PassManager.h>
 #include <llvm/IR/Verifier.h>
-#include <llvm/InitializePasses.h>
-#include <llvm/PassRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Casting.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Regex.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Target/TargetMachine.h>
-#include <llvm/Transforms/IPO.h>
-#include <llvm/Transforms/IPO/AlwaysInliner.h>
-#include <llvm/Transforms/IPO/PassManagerBuilder.h>
 
+#include "error.h"
 #include "llvm_common.h"
 #include "util.h"
 
 namespace kcc {
 
-void AddOptimizationPasses(llvm::legacy::PassManagerBase &mpm,
-                           llvm::legacy::FunctionPassManager &fpm,
-                           llvm::TargetMachine *tm, std::uint32_t opt_level) {
-  fpm.add(llvm::createVerifierPass());
-
-  llvm::PassManagerBuilder builder;
-  builder.OptLevel = opt_level;
-  builder.SizeLevel = 0;
+namespace {
+
+llvm::PassBuilder::OptimizationLevel GetOptimizationLevel() {
+  switch (OptimizationLevel.getValue()) {
+    case OptLevel::kO0:
+      return llvm::PassBuilder::OptimizationLevel::O0;
+    case OptLevel::kO1:
+      return llvm::PassBuilder::OptimizationLevel::O1;
+    case OptLevel::kO2:
+      return llvm::PassBuilder::OptimizationLevel::O2;
+    case OptLevel::kO3:
+      return llvm::PassBuilder::OptimizationLevel::O3;
+    case OptLevel::kOs:
+      return llvm::PassBuilder::OptimizationLevel::Os;
+    case OptLevel::kOz:
+      return llvm::PassBuilder::OptimizationLevel::Oz;
+    default:
+      assert(false);
+      return llvm::PassBuilder::OptimizationLevel::O0;
+  }
+}
 
-  if (opt_level > 1) {
-    builder.Inliner = llvm::createFunctionInliningPass(opt_level, 0, false);
+llvm::Optional<llvm::PGOOptions> GetPGOOptions() {
+  if (ProfileGenerate()) {
+    std::filesystem::path path{FProfileGenerate.getValue()};
+    // %m 会被替换为模块的签名, 使多个程序共享目录时不互相覆盖
+    path /= "default_%m.profraw";
+    return llvm::PGOOptions{path.string(), "", "", llvm::PGOOptions::IRInstr};
+  } else if (!std::empty(FProfileUse)) {
+    return llvm::PGOOptions{FProfileUse, "", "", llvm::PGOOptions::IRUse};
   } else {
-    builder.Inliner = llvm::createAlwaysInlinerLegacyPass();
+    return llvm::None;
   }
+}
 
-  builder.DisableUnrollLoops = false;
+// 打印 -Rpass 等选项匹配的优化备注, 如果使用了 -g 则包含源码位置
+class RemarkHandler : public llvm::DiagnosticHandler {
+ public:
+  RemarkHandler() {
+    pass_ = CreateRegex(RPass, "-Rpass");
+    missed_ = CreateRegex(RPassMissed, "-Rpass-missed");
+    analysis_ = CreateRegex(RPassAnalysis, "-Rpass-analysis");
+  }
 
-  if (builder.LoopVectorize) {
-    builder.LoopVectorize = (opt_level > 1);
+  bool isPassedOptRemarkEnabled(llvm::StringRef pass_name) const override {
+    return pass_ && pass_->match(pass_name);
   }
+  bool isMissedOptRemarkEnabled(llvm::StringRef pass_name) const override {
+    return missed_ && missed_->match(pass_name);
+  }
+  bool isAnalysisRemarkEnabled(llvm::StringRef pass_name) const override {
+    return analysis_ && analysis_->match(pass_name);
+  }
+
+  bool handleDiagnostics(const llvm::DiagnosticInfo &di) override {
+    auto remark{llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&di)};
+    // 其他诊断信息使用默认的处理方式
+    if (!remark) {
+      return false;
+    }
 
-  builder.SLPVectorize = (opt_level > 1);
+    std::string option;
+    switch (di.getKind()) {
+      case llvm::DK_OptimizationRemark:
+      case llvm::DK_MachineOptimizationRemark:
+        option = "-Rpass";
+        break;
+      case llvm::DK_OptimizationRemarkMissed:
+      case llvm::DK_MachineOptimizationRemarkMissed:
+        option = "-Rpass-missed";
+        break;
+      default:
+        option = "-Rpass-analysis";
+        break;
+    }
 
-  tm->adjustPassManager(builder);
+    std::string loc;
+    if (remark->isLocationAvailable()) {
+      loc = remark->getLocationStr();
+    } else {
+      loc = remark->getFunction().getName().str();
+    }
 
-  builder.populateFunctionPassManager(fpm);
-  builder.populateModulePassManager(mpm);
-}
+    fmt::print(fmt::fg(fmt::terminal_color::cyan), FMT_STRING("{}: remark: "),
+               loc);
+    fmt::print(FMT_STRING("{} [{}={}]\n"), remark->getMsg(), option,
+               remark->getPassName());
+    return true;
+  }
+
+ private:
+  static std::optional<llvm::Regex> CreateRegex(const std::string &pattern,
+                                                const std::string &option) {
+    if (std::empty(pattern)) {
+      return {};
+    }
+
+    llvm::Regex regex{pattern};
+    if (std::string error; !regex.isValid(error)) {
+      Error("invalid regular expression '{}' in '{}': {}", pattern, option,
+            error);
+    }
+    return regex;
+  }
 
-void AddStandardLinkPasses(llvm::legacy::PassManagerBase &pm) {
-  llvm::PassManagerBuilder builder;
-  builder.VerifyInput = true;
+  std::optional<llvm::Regex> pass_, missed_, analysis_;
+};
 
-  builder.Inliner = llvm::createFunctionInliningPass();
-  builder.populateLTOPassManager(pm);
+std::unique_ptr<llvm::ToolOutputFile> RemarksFile;
+
+}  // namespace
+
+void InitOptimizationRemarks(const std::string &file_name) {
+  if (!std::empty(RPass) || !std::empty(RPassMissed) ||
+      !std::empty(RPassAnalysis)) {
+    Context.setDiagnosticHandler(std::make_unique<RemarkHandler>(), true);
+  }
+
+  if (FSaveOptimizationRecord.getNumOccurrences() == 0) {
+    return;
+  }
+
+  std::string format{FSaveOptimizationRecord};
+  if (std::empty(format)) {
+    format = "yaml";
+  } else if (format != "yaml" && format != "bitstream") {
+    Error("unknown remark serializer format: '{}'", format);
+  }
+
+  auto path{GetAuxFileName(file_name, ".opt." + format)};
+
+  auto file{llvm::setupLLVMOptimizationRemarks(Context, path, "", format,
+                                               !std::empty(FProfileUse))};
+  if (!file) {
+    Error("{}", llvm::toString(file.takeError()));
+  }
+
+  RemarksFile = std::move(*file);
+  RemarksFile->keep();
 }
 
 void Optimization() {
-  auto level{static_cast<std::int32_t>(OptimizationLevel.getValue())};
-
-  if (level != 0) {
-    llvm::PassRegistry &registry{*llvm::PassRegistry::getPassRegistry()};
-
-    llvm::initializeCore(registry);
-    llvm::initializeCoroutines(registry);
-    llvm::initializeScalarOpts(registry);
-    llvm::initializeObjCARCOpts(registry);
-    llvm::initializeVectorization(registry);
-    llvm::initializeIPO(registry);
-    llvm::initializeAnalysis(registry);
-    llvm::initializeTransformUtils(registry);
-    llvm::initializeInstCombine(registry);
-    llvm::initializeAggressiveInstCombine(registry);
-    llvm::initializeInstrumentation(registry);
-    llvm::initializeTarget(registry);
-    llvm::initializeExpandMemCmpPassPass(registry);
-    llvm::initializeCodeGenPreparePass(registry);
-    llvm::initializeAtomicExpandPass(registry);
-    llvm::initializeRewriteSymbolsLegacyPassPass(registry);
-    llvm::initializeWinEHPreparePass(registry);
-    llvm::initializeSafeStackLegacyPassPass(registry);
-    llvm::initializeSjLjEHPreparePass(registry);
-    llvm::initializeStackProtectorPass(registry);
-    llvm::initializePreISelIntrinsicLoweringLegacyPassPass(registry);
-    llvm::initializeGlobalMergePass(registry);
-    llvm::initializeIndirectBrExpandPassPass(registry);
-    llvm::initializeInterleavedLoadCombinePass(registry);
-    llvm::initializeInterleavedAccessPass(registry);
-    llvm::initializeEntryExitInstrumenterPass(registry);
-    llvm::initializePostInlineEntryExitInstrumenterPass(registry);
-    llvm::initializeUnreachableBlockElimLegacyPassPass(registry);
-    llvm::initializeExpandReductionsPass(registry);
-    llvm::initializeWasmEHPreparePass(registry);
-    llvm::initializeWriteBitcodePassPass(registry);
-    llvm::initializeHardwareLoopsPass(registry);
-
-    llvm::legacy::PassManager passes;
-
-    llvm::TargetLibraryInfoImpl tlti(llvm::Triple{Module->getTargetTriple()});
-    passes.add(new llvm::TargetLibraryInfoWrapperPass(tlti));
-    passes.add(llvm::createTargetTransformInfoWrapperPass(
-        TargetMachine->getTargetIRAnalysis()));
-
-    auto fp_passes{
-        std::make_unique<llvm::legacy::FunctionPassManager>(Module.get())};
-
-    fp_passes->add(llvm::createTargetTransformInfoWrapperPass(
-        TargetMachine->getTargetIRAnalysis()));
-
-    auto &ltm{static_cast<llvm::LLVMTargetMachine &>(*TargetMachine)};
-    passes.add(ltm.createPassConfig(passes));
-
-    AddStandardLinkPasses(passes);
-    AddOptimizationPasses(passes, *fp_passes, TargetMachine.get(), level);
-
-    fp_passes->doInitialization();
-    for (auto &f : *Module) {
-      fp_passes->run(f);
-    }
-    fp_passes->doFinalization();
+  // 每个 pass 的时间由 PassManager 记录
+  llvm::TimeTraceScope scope{"Optimization"};
+
+  // -O0 时除了插桩以外不运行任何 pass
+  if (OptimizationLevel == OptLevel::kO0 && std::empty(Passes) &&
+      !ProfileGenerate()) {
+    return;
+  }
 
-    passes.add(llvm::createVerifierPass());
-    passes.run(*Module);
+  auto level{GetOptimizationLevel()};
+
+  // 与 clang 一致: -Oz 不做循环向量化
+  llvm::PipelineTuningOptions pto;
+  pto.LoopUnrolling = true;
+  pto.LoopInterleaving = true;
+  pto.LoopVectorization = level.getSpeedupLevel() > 1 &&
+                          OptimizationLevel != OptLevel::kOz;
+  pto.SLPVectorization = level.getSpeedupLevel() > 1;
+
+  llvm::PassBuilder pb{false, TargetMachine.get(), pto, GetPGOOptions()};
+
+  llvm::LoopAnalysisManager lam;
+  llvm::FunctionAnalysisManager fam;
+  llvm::CGSCCAnalysisManager cgam;
+  llvm::ModuleAnalysisManager mam;
+
+  // 必须在 registerFunctionAnalyses 之前注册, 否则会使用默认的版本
+  llvm::TargetLibraryInfoImpl tlii{llvm::Triple{Module->getTargetTriple()}};
+  fam.registerPass([&] { return llvm::TargetLibraryAnalysis{tlii}; });
+
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  llvm::ModulePassManager mpm;
+  if (!std::empty(Passes)) {
+    if (auto error{pb.parsePassPipeline(mpm, Passes)}) {
+      Error("invalid pass pipeline '{}': {}", Passes.getValue(),
+            llvm::toString(std::move(error)));
+    }
+  } else if (OptimizationLevel == OptLevel::kO0) {
+    mpm = pb.buildO0DefaultPipeline(level);
+  } else if (FLto == LTOKind::kFull) {
+    // 跨模块的优化在链接时进行
+    mpm = pb.buildLTOPreLinkDefaultPipeline(level);
+  } else if (FLto == LTOKind::kThin) {
+    mpm = pb.buildThinLTOPreLinkDefaultPipeline(level);
+  } else {
+    mpm = pb.buildPerModuleDefaultPipeline(level);
   }
+  mpm.addPass(llvm::VerifierPass{});
+
+  mpm.run(*Module, mam);
 }
 
 }  // namespace kcc
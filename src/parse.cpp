@@ -7,6 +7,10 @@
 #include <algorithm>
 #include <cassert>
 #include <limits>
+#include <string>
+#include <utility>
+
+#include <llvm/Support/TimeProfiler.h>
 
 #include "calc.h"
 #include "error.h"
@@ -23,7 +27,14 @@ Parser::Parser(std::vector<Token> tokens) : tokens_{std::move(tokens)} {
 }
 
 TranslationUnit *Parser::ParseTranslationUnit() {
+  llvm::TimeTraceScope scope{"Parser::ParseTranslationUnit"};
+
   while (HasNext()) {
+    if (Test(Tag::kPragma)) {
+      auto token{Next()};
+      Warning(token, "'#pragma {}' ignored at file scope", token.GetStr());
+      continue;
+    }
     unit_->AddExtDecl(ParseExternalDecl());
   }
 
@@ -271,7 +282,11 @@ Declaration *Parser::MakeDeclaration(const Token &token, QualType type,
     type->FuncSetFuncSpec(func_spec);
     type->FuncSetName(name);
 
+    // 重复声明时保留之前指定的汇编标签
+    auto asm_label{ident ? ident->GetAsmLabel() : ""};
+
     ident = MakeAstNode<IdentifierExpr>(token, name, type, linkage, false);
+    ident->SetAsmLabel(asm_label);
     scope_->InsertUsual(name, ident);
 
     return MakeAstNode<Declaration>(token, ident);
@@ -312,7 +327,6 @@ ExtDecl *Parser::ParseExternalDecl() {
     return nullptr;
   }
 
-  TryParseAsm();
   TryParseAttributeSpec();
 
   if (Test(Tag::kLeftBrace)) {
@@ -334,6 +348,8 @@ FuncDef *Parser::ParseFuncDef(const Declaration *decl) {
     Error(decl->GetLoc(), "func def need func type");
   }
 
+  llvm::TimeTraceScope scope{"Parser::ParseFuncDef", ident->GetName()};
+
   EnterFunc(ident);
   func_def_->SetBody(ParseCompoundStmt(ident->GetType()));
   auto ret{func_def_};
@@ -348,7 +364,17 @@ FuncDef *Parser::ParseFuncDef(const Declaration *decl) {
       Error(item->GetLoc(), "unknown label: {}", item->GetName());
     }
   }
+  for (auto &&item : label_addrs_) {
+    auto label{FindLabel(item->GetName())};
+    if (label) {
+      item->SetLabel(label);
+    } else {
+      Error(item->GetLoc(), "unknown label: {}", item->GetName());
+    }
+  }
+  ret->SetLabelAddrs(label_addrs_);
   gotos_.clear();
+  label_addrs_.clear();
   labels_.clear();
 
   return ret;
@@ -381,21 +407,21 @@ FuncDef *Parser::ParseFuncDef(const Declaration *decl) {
 //  expression
 //  expression-list ',' expression
 // 可以有多个
-void Parser::TryParseAttributeSpec() {
+void Parser::TryParseAttributeSpec(Attributes *attrs) {
   while (Try(Tag::kAttribute)) {
     Expect(Tag::kLeftParen);
     Expect(Tag::kLeftParen);
 
-    ParseAttributeList();
+    ParseAttributeList(attrs);
 
     Expect(Tag::kRightParen);
     Expect(Tag::kRightParen);
   }
 }
 
-void Parser::ParseAttributeList() {
+void Parser::ParseAttributeList(Attributes *attrs) {
   while (!Test(Tag::kRightParen)) {
-    ParseAttribute();
+    ParseAttribute(attrs);
 
     if (!Test(Tag::kRightParen)) {
       Expect(Tag::kComma);
@@ -403,10 +429,34 @@ void Parser::ParseAttributeList() {
   }
 }
 
-void Parser::ParseAttribute() {
-  Expect(Tag::kIdentifier);
+void Parser::ParseAttribute(Attributes *attrs) {
+  auto tok{Expect(Tag::kIdentifier)};
 
-  if (Try(Tag::kLeftParen)) {
+  // __vector_size__ 与 vector_size 等价
+  auto name{tok.GetIdentifier()};
+  if (std::size(name) > 4 && name.substr(0, 2) == "__" &&
+      name.substr(std::size(name) - 2) == "__") {
+    name = name.substr(2, std::size(name) - 4);
+  }
+
+  if (name == "vector_size") {
+    Expect(Tag::kLeftParen);
+    auto expr{ParseConstantExpr()};
+    Expect(Tag::kRightParen);
+
+    auto size{*CalcConstantExpr{}.CalcInteger(expr)};
+    if (attrs) {
+      attrs->vector_size = size;
+    } else {
+      Warning(tok, "'vector_size' attribute ignored");
+    }
+  } else if (name == "musttail") {
+    if (attrs) {
+      attrs->must_tail = true;
+    } else {
+      Warning(tok, "'musttail' attribute ignored");
+    }
+  } else if (Try(Tag::kLeftParen)) {
     ParseAttributeParamList();
     Expect(Tag::kRightParen);
   }
@@ -432,14 +482,132 @@ void Parser::ParseAttributeExprList() {
   }
 }
 
-void Parser::TryParseAsm() {
+// int foo(void) asm("bar");
+std::string Parser::TryParseAsmLabel() {
   if (Try(Tag::kAsm)) {
     Expect(Tag::kLeftParen);
-    ParseStringLiteral();
+    auto asm_label{ParseStringLiteral()->GetStr()};
     Expect(Tag::kRightParen);
+
+    if (std::empty(asm_label)) {
+      Error(Peek(), "asm label cannot be empty");
+    }
+
+    return asm_label;
+  } else {
+    return "";
   }
 }
 
+Stmt *Parser::ParseAsmStmt() {
+  auto token{Expect(Tag::kAsm)};
+
+  bool is_volatile{}, is_goto{};
+  while (Test(Tag::kVolatile) || Test(Tag::kInline) || Test(Tag::kGoto)) {
+    // inline 只影响 GCC 对汇编大小的估计, 忽略即可
+    auto tag{Next().GetTag()};
+    if (tag == Tag::kVolatile) {
+      is_volatile = true;
+    } else if (tag == Tag::kGoto) {
+      is_goto = true;
+    }
+  }
+
+  Expect(Tag::kLeftParen);
+  auto asm_str{ParseStringLiteral()->GetStr()};
+
+  std::vector<AsmStmt::Operand> outputs, inputs;
+  std::vector<std::string> clobbers;
+  std::vector<GotoStmt *> labels;
+
+  // 依次为输出操作数, 输入操作数, 破坏列表, 跳转标签, 均可省略
+  for (std::int32_t i{}; i < 4 && Try(Tag::kColon); ++i) {
+    switch (i) {
+      case 0:
+        outputs = ParseAsmOperands();
+        break;
+      case 1:
+        inputs = ParseAsmOperands();
+        break;
+      case 2:
+        clobbers = ParseAsmClobbers();
+        break;
+      default:
+        labels = ParseAsmLabels();
+        break;
+    }
+  }
+
+  Expect(Tag::kRightParen);
+  Expect(Tag::kSemicolon);
+
+  if (is_goto && std::empty(labels)) {
+    Error(token, "expected labels in asm goto");
+  } else if (!is_goto && !std::empty(labels)) {
+    Error(token, "labels are only allowed in asm goto");
+  }
+
+  return MakeAstNode<AsmStmt>(token, asm_str, is_volatile, std::move(outputs),
+                              std::move(inputs), std::move(clobbers),
+                              std::move(labels));
+}
+
+std::vector<AsmStmt::Operand> Parser::ParseAsmOperands() {
+  std::vector<AsmStmt::Operand> operands;
+
+  if (!Test(Tag::kStringLiteral) && !Test(Tag::kLeftSquare)) {
+    return operands;
+  }
+
+  do {
+    // [name] "constraint" (expr)
+    std::string name;
+    if (Try(Tag::kLeftSquare)) {
+      name = Expect(Tag::kIdentifier).GetIdentifier();
+      Expect(Tag::kRightSquare);
+    }
+
+    auto constraint{ParseStringLiteral()->GetStr()};
+
+    Expect(Tag::kLeftParen);
+    auto expr{ParseExpr()};
+    Expect(Tag::kRightParen);
+
+    operands.push_back({name, constraint, expr});
+  } while (Try(Tag::kComma));
+
+  return operands;
+}
+
+std::vector<std::string> Parser::ParseAsmClobbers() {
+  std::vector<std::string> clobbers;
+
+  if (!Test(Tag::kStringLiteral)) {
+    return clobbers;
+  }
+
+  do {
+    clobbers.push_back(ParseStringLiteral()->GetStr());
+  } while (Try(Tag::kComma));
+
+  return clobbers;
+}
+
+std::vector<GotoStmt *> Parser::ParseAsmLabels() {
+  std::vector<GotoStmt *> labels;
+
+  do {
+    auto tok{Expect(Tag::kIdentifier)};
+
+    // 和 goto 语句一样, 在函数定义结束时解析标签
+    auto label{MakeAstNode<GotoStmt>(tok, tok.GetIdentifier())};
+    gotos_.push_back(label);
+    labels.push_back(label);
+  } while (Try(Tag::kComma));
+
+  return labels;
+}
+
 QualType Parser::ParseTypeof() {
   Expect(Tag::kLeftParen);
 
@@ -457,6 +625,22 @@ QualType Parser::ParseTypeof() {
   return type;
 }
 
+// __auto_type name = expr, 类型为初始化表达式经过左值转换后的类型
+// 先向前解析初始化表达式得到类型, 再回退, 表达式保存下来由
+// ParseAutoTypeInit 使用, 不会解析两次
+QualType Parser::ParseAutoType() {
+  auto begin{index_};
+
+  Expect(Tag::kIdentifier);
+  Expect(Tag::kEqual);
+  auto_type_init_ = Expr::MayCast(ParseAssignExpr());
+  auto_type_end_ = index_;
+
+  index_ = begin;
+
+  return auto_type_init_->GetType();
+}
+
 Expr *Parser::TryParseStmtExpr() {
   Try(Tag::kExtension);
 
@@ -565,6 +749,12 @@ void Parser::AddBuiltin() {
                                                   ArrayType::Get(va_list, 1),
                                                   Linkage::kNone, true));
 
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__int128_t", ArithmeticType::Get(kInt128), Linkage::kNone, true));
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__uint128_t", ArithmeticType::Get(kInt128 | kUnsigned),
+      Linkage::kNone, true));
+
   auto va_list_ptr{MakeAstNode<ObjectExpr>(loc, "", va_list->GetPointerTo())};
   auto integer{MakeAstNode<ObjectExpr>(loc, "", ArithmeticType::Get(kInt))};
 
@@ -591,8 +781,54 @@ void Parser::AddBuiltin() {
   scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
       loc, "__sync_synchronize", sync_synchronize, Linkage::kExternal, false));
 
+  // 类型泛型的原子操作, 参数和返回值在 FuncCallExpr::Check 中确定
+  for (const auto &[name, signature] : AtomicBuiltins) {
+    auto atomic{FunctionType::Get(VoidType::Get(), {}, true)};
+    atomic->FuncSetName(name);
+    scope_->InsertUsual(MakeAstNode<IdentifierExpr>(loc, name, atomic,
+                                                    Linkage::kExternal, false));
+  }
+
+  auto void_ptr{
+      MakeAstNode<ObjectExpr>(loc, "", PointerType::Get(VoidType::Get()))};
+
+  auto test_and_set{
+      FunctionType::Get(ArithmeticType::Get(kBool), {void_ptr, integer})};
+  test_and_set->FuncSetName("__atomic_test_and_set");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__atomic_test_and_set", test_and_set, Linkage::kExternal, false));
+
+  auto clear{FunctionType::Get(VoidType::Get(), {void_ptr, integer})};
+  clear->FuncSetName("__atomic_clear");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__atomic_clear", clear, Linkage::kExternal, false));
+
+  auto thread_fence{FunctionType::Get(VoidType::Get(), {integer})};
+  thread_fence->FuncSetName("__atomic_thread_fence");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__atomic_thread_fence", thread_fence, Linkage::kExternal, false));
+
+  auto signal_fence{FunctionType::Get(VoidType::Get(), {integer})};
+  signal_fence->FuncSetName("__atomic_signal_fence");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__atomic_signal_fence", signal_fence, Linkage::kExternal, false));
+
   auto ulong{
       MakeAstNode<ObjectExpr>(loc, "", ArithmeticType::Get(kLong | kUnsigned))};
+
+  auto always_lock_free{
+      FunctionType::Get(ArithmeticType::Get(kBool), {ulong, void_ptr})};
+  always_lock_free->FuncSetName("__atomic_always_lock_free");
+  scope_->InsertUsual(
+      MakeAstNode<IdentifierExpr>(loc, "__atomic_always_lock_free",
+                                  always_lock_free, Linkage::kExternal, false));
+
+  auto is_lock_free{
+      FunctionType::Get(ArithmeticType::Get(kBool), {ulong, void_ptr})};
+  is_lock_free->FuncSetName("__atomic_is_lock_free");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__atomic_is_lock_free", is_lock_free, Linkage::kExternal, false));
+
   auto alloca{
       FunctionType::Get(ArithmeticType::Get(kChar)->GetPointerTo(), {ulong})};
   alloca->FuncSetName("__builtin_alloca");
@@ -650,6 +886,112 @@ void Parser::AddBuiltin() {
   bswap16->FuncSetName("__builtin_bswap16");
   scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
       loc, "__builtin_bswap16", bswap16, Linkage::kExternal, false));
+
+  // 后缀表示参数的宽度
+  for (const auto &[width, type_spec] :
+       {std::pair{8, kChar}, std::pair{16, kShort}, std::pair{32, kInt},
+        std::pair{64, kLong}}) {
+    auto type{ArithmeticType::Get(type_spec | kUnsigned)};
+    auto param{MakeAstNode<ObjectExpr>(loc, "", type)};
+
+    for (const auto &prefix :
+         {"__builtin_rotateleft", "__builtin_rotateright"}) {
+      auto name{prefix + std::to_string(width)};
+      auto rotate{FunctionType::Get(type, {param, param})};
+      rotate->FuncSetName(name);
+      scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+          loc, name, rotate, Linkage::kExternal, false));
+    }
+  }
+
+  for (const auto &[suffix, type_spec] :
+       {std::pair{"", kInt}, std::pair{"l", kLong},
+        std::pair{"ll", kLongLong}}) {
+    auto param{
+        MakeAstNode<ObjectExpr>(loc, "", ArithmeticType::Get(type_spec))};
+    auto ffs_name{"__builtin_ffs" + std::string{suffix}};
+    auto ffs{FunctionType::Get(ArithmeticType::Get(kInt), {param})};
+    ffs->FuncSetName(ffs_name);
+    scope_->InsertUsual(MakeAstNode<IdentifierExpr>(loc, ffs_name, ffs,
+                                                    Linkage::kExternal, false));
+
+    auto unsigned_param{MakeAstNode<ObjectExpr>(
+        loc, "", ArithmeticType::Get(type_spec | kUnsigned))};
+    auto parity_name{"__builtin_parity" + std::string{suffix}};
+    auto parity{FunctionType::Get(ArithmeticType::Get(kInt), {unsigned_param})};
+    parity->FuncSetName(parity_name);
+    scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+        loc, parity_name, parity, Linkage::kExternal, false));
+  }
+
+  auto double_param{
+      MakeAstNode<ObjectExpr>(loc, "", ArithmeticType::Get(kDouble))};
+  auto expect_with_probability{FunctionType::Get(
+      ArithmeticType::Get(kLong), {long_integer, long_integer, double_param})};
+  expect_with_probability->FuncSetName("__builtin_expect_with_probability");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_expect_with_probability", expect_with_probability,
+      Linkage::kExternal, false));
+
+  auto const_void_ptr{MakeAstNode<ObjectExpr>(
+      loc, "", PointerType::Get(QualType{VoidType::Get(), kConst}))};
+
+  // 可选参数 rw 和 locality 必须是整数常量表达式
+  auto prefetch{FunctionType::Get(VoidType::Get(), {const_void_ptr}, true)};
+  prefetch->FuncSetName("__builtin_prefetch");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_prefetch", prefetch, Linkage::kExternal, false));
+
+  auto unreachable{FunctionType::Get(VoidType::Get(), {})};
+  unreachable->FuncSetName("__builtin_unreachable");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_unreachable", unreachable, Linkage::kExternal, false));
+
+  auto assume_aligned{FunctionType::Get(PointerType::Get(VoidType::Get()),
+                                        {const_void_ptr, ulong}, true)};
+  assume_aligned->FuncSetName("__builtin_assume_aligned");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_assume_aligned", assume_aligned, Linkage::kExternal,
+      false));
+
+  // 参数可以是任意类型, 且不会被求值
+  auto constant_p{FunctionType::Get(ArithmeticType::Get(kInt), {}, true)};
+  constant_p->FuncSetName("__builtin_constant_p");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_constant_p", constant_p, Linkage::kExternal, false));
+
+  auto memcpy{FunctionType::Get(PointerType::Get(VoidType::Get()),
+                                {void_ptr, const_void_ptr, ulong})};
+  memcpy->FuncSetName("__builtin_memcpy");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_memcpy", memcpy, Linkage::kExternal, false));
+
+  auto memmove{FunctionType::Get(PointerType::Get(VoidType::Get()),
+                                 {void_ptr, const_void_ptr, ulong})};
+  memmove->FuncSetName("__builtin_memmove");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_memmove", memmove, Linkage::kExternal, false));
+
+  auto memset{FunctionType::Get(PointerType::Get(VoidType::Get()),
+                                {void_ptr, integer, ulong})};
+  memset->FuncSetName("__builtin_memset");
+  scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+      loc, "__builtin_memset", memset, Linkage::kExternal, false));
+
+  // 类型泛型, 参数和返回值在 FuncCallExpr::Check 中确定
+  for (const auto &[name, intrinsic] : OverflowBuiltins) {
+    auto overflow{FunctionType::Get(ArithmeticType::Get(kBool), {}, true)};
+    overflow->FuncSetName(name);
+    scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+        loc, name, overflow, Linkage::kExternal, false));
+  }
+
+  for (const auto &name : {"__builtin_shufflevector", "__builtin_shuffle"}) {
+    auto shuffle{FunctionType::Get(VoidType::Get(), {}, true)};
+    shuffle->FuncSetName(name);
+    scope_->InsertUsual(MakeAstNode<IdentifierExpr>(
+        loc, name, shuffle, Linkage::kExternal, false));
+  }
 }
 
 }  // namespace kcc
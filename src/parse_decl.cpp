@@ -9,6 +9,7 @@
 
 #include "calc.h"
 #include "error.h"
+#include "llvm_common.h"
 
 namespace kcc {
 
@@ -87,9 +88,10 @@ QualType Parser::ParseDeclSpec(std::uint32_t *storage_class_spec,
 
   Token tok;
   QualType type;
+  Attributes attrs;
 
   while (true) {
-    TryParseAttributeSpec();
+    TryParseAttributeSpec(&attrs);
 
     tok = Next();
 
@@ -104,6 +106,13 @@ QualType Parser::ParseDeclSpec(std::uint32_t *storage_class_spec,
         type = ParseTypeof();
         has_typeof = true;
         break;
+      case Tag::kAutoType:
+        if (type_spec != 0) {
+          Error(tok, "It is not allowed to use __auto_type here.");
+        }
+        type = ParseAutoType();
+        has_typeof = true;
+        break;
 
         // Storage Class Specifier, 至多有一个
       case Tag::kTypedef:
@@ -156,6 +165,12 @@ QualType Parser::ParseDeclSpec(std::uint32_t *storage_class_spec,
           type_spec |= kLong;
         }
         break;
+      case Tag::kInt128:
+        if (type_spec & ~kCompInt128) {
+          ERROR
+        }
+        TYPEOF_CHECK type_spec |= kInt128;
+        break;
       case Tag::kFloat:
         if (type_spec) {
           ERROR
@@ -204,7 +219,17 @@ QualType Parser::ParseDeclSpec(std::uint32_t *storage_class_spec,
       case Tag::kComplex:
         TYPEOF_CHECK Error(tok, "Does not support _Complex");
       case Tag::kAtomic:
-        TYPEOF_CHECK Error(tok, "Does not support _Atomic");
+        // _Atomic ( type-name ) 是类型说明符, 否则是类型限定符
+        if (Try(Tag::kLeftParen)) {
+          if (type_spec) {
+            ERROR
+          }
+          TYPEOF_CHECK type = ParseTypeName();
+          Expect(Tag::kRightParen);
+          type_spec |= kAtomicTypeSpec;
+        }
+        type_qual |= kAtomic;
+        break;
 
         // Type qualifier
       case Tag::kConst:
@@ -253,7 +278,7 @@ QualType Parser::ParseDeclSpec(std::uint32_t *storage_class_spec,
 finish:
   PutBack();
 
-  TryParseAttributeSpec();
+  TryParseAttributeSpec(&attrs);
 
   switch (type_spec) {
     case 0:
@@ -267,12 +292,19 @@ finish:
     case kStructUnionSpec:
     case kEnumSpec:
     case kTypedefName:
+    case kAtomicTypeSpec:
       break;
     default:
       type = ArithmeticType::Get(type_spec);
   }
 
-  return QualType{type.GetType(), type.GetTypeQual() | type_qual};
+  type = QualType{type.GetType(), type.GetTypeQual() | type_qual};
+  type = ApplyAttributes(tok, type, attrs);
+  if (type.IsAtomic()) {
+    CheckAtomicType(tok, type);
+  }
+
+  return type;
 
 #undef CHECK_AND_SET_STORAGE_CLASS_SPEC
 #undef CHECK_AND_SET_FUNC_SPEC
@@ -360,7 +392,9 @@ void Parser::ParseStructDeclList(StructType *type) {
 
         ParseDeclarator(tok, copy);
 
-        TryParseAttributeSpec();
+        Attributes attrs;
+        TryParseAttributeSpec(&attrs);
+        copy = ApplyAttributes(tok, copy, attrs);
 
         // 位域
         if (Try(Tag::kColon)) {
@@ -404,6 +438,8 @@ void Parser::ParseStructDeclList(StructType *type) {
             }
           } else if (copy->IsFunctionTy()) {
             Error(Peek(), "field '{}' declared as a function", name);
+          } else if (copy->IsVLATy()) {
+            Error(Peek(), "field '{}' has variable length array type", name);
           } else {
             auto member{MakeAstNode<ObjectExpr>(tok, name, copy)};
             type->AddMember(member);
@@ -441,6 +477,8 @@ void Parser::ParseBitField(StructType *type, const Token &tok,
   if (!member_type->IsIntTy() && !member_type->IsCharacterTy()) {
     Error(Peek(), "expect int or bool type for bitfield but got ('{}')",
           member_type.ToString());
+  } else if (member_type.IsAtomic()) {
+    Error(Peek(), "bitfield has atomic type ('{}')", member_type.ToString());
   }
 
   auto expr{ParseConstantExpr()};
@@ -564,6 +602,39 @@ std::int32_t Parser::ParseAlignas() {
   return align;
 }
 
+// 只支持宽度为 1 / 2 / 4 / 8 字节的标量类型, 它们可以直接使用 LLVM 的原子指令
+void Parser::CheckAtomicType(const Token &tok, QualType type) {
+  if (!type->IsScalarTy() || type->IsLongDoubleTy() || type->GetWidth() > 8) {
+    Error(tok, "Does not support _Atomic on type '{}'", type.ToString());
+  }
+}
+
+// vector_size 的参数是向量的字节数, 元素个数必须是 2 的幂
+QualType Parser::ApplyAttributes(const Token &tok, QualType type,
+                                 const Attributes &attrs) {
+  if (!attrs.vector_size) {
+    return type;
+  }
+
+  if (!type->IsArithmeticTy() || type->IsBoolTy() || type->IsLongDoubleTy()) {
+    Error(tok, "invalid vector element type '{}'", type.ToString());
+  }
+
+  auto size{*attrs.vector_size};
+  auto width{type->GetWidth()};
+  if (size <= 0 || size % width != 0) {
+    Error(tok, "vector size not an integral multiple of component size");
+  }
+
+  auto num_elements{static_cast<std::size_t>(size / width)};
+  if (num_elements & (num_elements - 1)) {
+    Error(tok, "number of components of the vector not a power of two");
+  }
+
+  return QualType{VectorType::Get(type.GetType(), num_elements),
+                  type.GetTypeQual()};
+}
+
 /*
  * Declarator
  */
@@ -595,13 +666,66 @@ Declaration *Parser::ParseInitDeclarator(QualType &base_type,
     Error(token, "expect identifier");
   }
 
+  auto asm_label{TryParseAsmLabel()};
+
+  Attributes attrs;
+  TryParseAttributeSpec(&attrs);
+  // 属性也可以出现在汇编标签之前, e.g. glibc 的 __REDIRECT_NTH
+  if (std::empty(asm_label)) {
+    asm_label = TryParseAsmLabel();
+    TryParseAttributeSpec(&attrs);
+  }
+  base_type = ApplyAttributes(tok, base_type, attrs);
+
+  if (!std::empty(asm_label)) {
+    if (storage_class_spec & kTypedef) {
+      Error(tok, "asm label is not allowed on typedef '{}'",
+            tok.GetIdentifier());
+    } else if (!scope_->IsFileScope() && !base_type->IsFunctionTy() &&
+               !(storage_class_spec & (kExtern | kStatic))) {
+      Error(tok, "asm label is not allowed on local variable '{}'",
+            tok.GetIdentifier());
+    }
+  }
+
+  if (base_type->IsVLATy()) {
+    if (storage_class_spec & kTypedef) {
+      Error(tok, "variable length array typedef '{}' is not supported",
+            tok.GetIdentifier());
+    } else if (storage_class_spec & (kExtern | kStatic)) {
+      Error(tok, "variable length array declaration cannot have '{}' storage",
+            storage_class_spec & kExtern ? "extern" : "static");
+    }
+  }
+
   auto decl{
       MakeDeclaration(tok, base_type, storage_class_spec, func_spec, align)};
+  if (decl && !std::empty(asm_label)) {
+    decl->GetIdent()->SetAsmLabel(asm_label);
+  }
 
   if (decl && decl->IsObjDecl()) {
+    auto type{decl->GetIdent()->GetType()};
+    if (type->IsVLATy()) {
+      // 保存声明时计算出的元素个数, 之后修改长度表达式中的变量不影响 sizeof
+      if (!type->ArrayGetVLASize()) {
+        type->ArraySetVLASize(MakeAstNode<ObjectExpr>(
+            tok, ".vla.size", ArithmeticType::Get(kLong | kUnsigned), 0,
+            Linkage::kNone, true));
+      }
+      compound_stmt_.top()->SetHasVLA();
+
+      if (Test(Tag::kEqual)) {
+        Error(tok, "variable-sized object may not be initialized");
+      }
+    }
+
     if (Try(Tag::kEqual)) {
-      if (!scope_->IsFileScope() &&
-          !(scope_->IsBlockScope() && storage_class_spec & kStatic)) {
+      auto is_local{!scope_->IsFileScope() &&
+                    !(scope_->IsBlockScope() && storage_class_spec & kStatic)};
+      if (auto_type_init_) {
+        ParseAutoTypeInit(decl, is_local);
+      } else if (is_local) {
         ParseInitDeclaratorSub(decl);
       } else {
         decl->SetConstant(
@@ -610,6 +734,8 @@ Declaration *Parser::ParseInitDeclarator(QualType &base_type,
     }
   }
 
+  auto_type_init_ = nullptr;
+
   return decl;
 }
 
@@ -634,14 +760,44 @@ void Parser::ParseInitDeclaratorSub(Declaration *decl) {
   }
 }
 
+// __auto_type 的初始化表达式已经在 ParseAutoType 中解析过了
+void Parser::ParseAutoTypeInit(Declaration *decl, bool is_local) {
+  auto expr{auto_type_init_};
+  auto type{decl->GetIdent()->GetType()};
+
+  auto_type_init_ = nullptr;
+  index_ = auto_type_end_;
+
+  if (is_local) {
+    decl->AddInits({Initializer{type, expr, indexs_}});
+  } else if (auto constant{CalcConstantExpr{}.Calc(expr)}) {
+    decl->SetConstant(ConstantCastTo(constant, type->GetLLVMType(),
+                                     expr->GetType()->IsUnsigned()));
+  } else {
+    Error(expr, "expect constant expression");
+  }
+}
+
 void Parser::ParseDeclarator(Token &tok, QualType &base_type) {
   ParsePointer(base_type);
   ParseDirectDeclarator(tok, base_type);
 }
 
 void Parser::ParsePointer(QualType &type) {
-  while (Try(Tag::kStar)) {
+  while (true) {
+    auto tok{Peek()};
+    if (!Try(Tag::kStar)) {
+      break;
+    }
+
+    if (type->IsVLATy()) {
+      Error(tok, "pointer to variable length array is not supported");
+    }
+
     type = QualType{PointerType::Get(type), ParseTypeQualList()};
+    if (type.IsAtomic()) {
+      CheckAtomicType(tok, type);
+    }
   }
 }
 
@@ -657,7 +813,7 @@ std::uint32_t Parser::ParseTypeQualList() {
     } else if (Try(Tag::kVolatile)) {
       type_qual |= kVolatile;
     } else if (Try(Tag::kAtomic)) {
-      Error(token, "Does not support _Atomic");
+      type_qual |= kAtomic;
     } else {
       break;
     }
@@ -696,16 +852,24 @@ void Parser::ParseDirectDeclaratorTail(QualType &base_type) {
       Error(Peek(), "the element of array cannot be a function");
     }
 
-    auto len{ParseArrayLength()};
+    Expr *vla_length{};
+    auto len{ParseArrayLength(&vla_length)};
     Expect(Tag::kRightSquare);
 
     ParseDirectDeclaratorTail(base_type);
 
     if (!base_type->IsComplete()) {
       Error(Peek(), "has incomplete element type");
+    } else if (base_type->IsVLATy()) {
+      Error(Peek(), "only the first dimension of a variable length array can "
+                    "be variable");
     }
 
-    base_type = ArrayType::Get(base_type, len);
+    if (vla_length) {
+      base_type = ArrayType::GetVLA(base_type, vla_length);
+    } else {
+      base_type = ArrayType::Get(base_type, len);
+    }
   } else if (Try(Tag::kLeftParen)) {
     if (base_type->IsFunctionTy()) {
       Error(Peek(), "the return value of function cannot be function");
@@ -725,7 +889,7 @@ void Parser::ParseDirectDeclaratorTail(QualType &base_type) {
   }
 }
 
-std::optional<std::size_t> Parser::ParseArrayLength() {
+std::optional<std::size_t> Parser::ParseArrayLength(Expr **vla_length) {
   // 忽略掉
   while (true) {
     if (Try(Tag::kTypedef) || Try(Tag::kExtern) || Try(Tag::kStatic) ||
@@ -740,6 +904,14 @@ std::optional<std::size_t> Parser::ParseArrayLength() {
     return {};
   }
 
+  // int a[*], 只能用于函数原型, 参数会被转换为指针
+  if (Try(Tag::kStar)) {
+    if (Test(Tag::kRightSquare)) {
+      return {};
+    }
+    PutBack();
+  }
+
   auto expr{ParseAssignExpr()};
 
   if (!expr->GetQualType()->IsIntegerTy()) {
@@ -750,7 +922,13 @@ std::optional<std::size_t> Parser::ParseArrayLength() {
   auto len{CalcConstantExpr{}.CalcInteger(expr, false)};
 
   if (!len) {
-    Error(Peek(), "not support VLA");
+    if (scope_->IsFileScope()) {
+      Error(expr, "variable length array declaration not allowed at file "
+                  "scope");
+    }
+
+    *vla_length = expr;
+    return {};
   } else if (*len < 0) {
     Error(Peek(), "Array size must be greater than zero: '{}'", *len);
   }
@@ -333,6 +333,16 @@ Expr *Parser::ParseUnaryExpr() {
       return ParseAlignof();
     case Tag::kOffsetof:
       return ParseOffsetof();
+    case Tag::kAmpAmp: {
+      // GNU 扩展, 标签的地址, 在函数定义结束时解析标签
+      if (func_def_ == nullptr) {
+        Error(token, "use of address-of-label outside of a function");
+      }
+      auto tok{Expect(Tag::kIdentifier)};
+      auto label_addr{MakeAstNode<LabelAddrExpr>(token, tok.GetIdentifier())};
+      label_addrs_.push_back(label_addr);
+      return label_addr;
+    }
     case Tag::kTypeid:
       return ParseTypeid();
     default:
@@ -362,6 +372,22 @@ Expr *Parser::ParseSizeof() {
     Error(token, "sizeof(incomplete type)");
   }
 
+  // 变长数组的大小需要在运行时计算
+  if (type->IsVLATy()) {
+    Expr *num_elements{type->ArrayGetVLASize()};
+    if (!num_elements) {
+      num_elements = type->ArrayGetVLALength();
+    }
+
+    auto ulong_type{ArithmeticType::Get(kLong | kUnsigned)};
+    return MakeAstNode<BinaryOpExpr>(
+        token, Tag::kStar, Expr::MayCastTo(num_elements, ulong_type),
+        MakeAstNode<ConstantExpr>(
+            token, ulong_type,
+            static_cast<std::uint64_t>(
+                type->ArrayGetElementType()->GetWidth())));
+  }
+
   return MakeAstNode<ConstantExpr>(
       token, ArithmeticType::Get(kLong | kUnsigned),
       static_cast<std::uint64_t>(type->GetWidth()));
@@ -411,6 +437,10 @@ Expr *Parser::TryParseCompoundLiteral() {
 }
 
 Expr *Parser::ParseCompoundLiteral(QualType type) {
+  if (type->IsVLATy()) {
+    Error(Peek(), "compound literal has variable-sized type");
+  }
+
   if (scope_->IsFileScope()) {
     auto obj{
         MakeAstNode<ObjectExpr>(Peek(), "", type, 0, Linkage::kInternal, true)};
@@ -470,6 +500,20 @@ Expr *Parser::ParseIndexExpr(Expr *expr) {
   auto rhs{ParseExpr()};
   Expect(Tag::kRightSquare);
 
+  // 向量的下标访问被转换为 *((T *)&v + i)
+  // 不是左值时没有地址可取, 保留为表达式, 在求值处提取元素
+  if (auto type{expr->GetQualType()}; type->IsVectorTy()) {
+    if (!expr->IsLValue()) {
+      return MakeAstNode<BinaryOpExpr>(token, Tag::kLeftSquare, expr, rhs);
+    }
+
+    auto element_type{QualType{type->VectorGetElementType().GetType(),
+                               type.GetTypeQual()}};
+    expr = MakeAstNode<TypeCastExpr>(
+        token, MakeAstNode<UnaryOpExpr>(token, Tag::kAmp, expr),
+        PointerType::Get(element_type));
+  }
+
   return MakeAstNode<UnaryOpExpr>(
       token, Tag::kStar,
       MakeAstNode<BinaryOpExpr>(token, Tag::kPlus, expr, rhs));
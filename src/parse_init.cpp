@@ -6,13 +6,177 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+#include <llvm/Support/MemoryBuffer.h>
 
 #include "calc.h"
 #include "error.h"
 #include "llvm_common.h"
+#include "util.h"
 
 namespace kcc {
 
+namespace {
+
+bool IsIntegerSuffix(std::string_view suffix) {
+  if (!std::empty(suffix) &&
+      (suffix.front() == 'u' || suffix.front() == 'U')) {
+    suffix.remove_prefix(1);
+  } else if (!std::empty(suffix) &&
+             (suffix.back() == 'u' || suffix.back() == 'U')) {
+    suffix.remove_suffix(1);
+  }
+
+  return std::empty(suffix) || suffix == "l" || suffix == "L" ||
+         suffix == "ll" || suffix == "LL";
+}
+
+// 返回整数字面量的值以及是否有 u / U 后缀, 不能处理时返回 std::nullopt,
+// 交给 ParseInteger 处理(或报错)
+std::optional<std::pair<std::uint64_t, bool>> DecodeInteger(
+    std::string_view str) {
+  std::int32_t base{10};
+  if (std::size(str) >= 2 && str[0] == '0' &&
+      (str[1] == 'x' || str[1] == 'X' || str[1] == 'b' || str[1] == 'B')) {
+    base = (str[1] == 'x' || str[1] == 'X') ? 16 : 2;
+    str.remove_prefix(2);
+  } else if (std::size(str) >= 2 && str[0] == '0') {
+    base = 8;
+    str.remove_prefix(1);
+  }
+
+  std::uint64_t val{};
+  auto end{std::data(str) + std::size(str)};
+  auto [ptr, ec]{std::from_chars(std::data(str), end, val, base)};
+  if (ec != std::errc{} || ptr == std::data(str)) {
+    return std::nullopt;
+  }
+
+  std::string_view suffix{ptr, static_cast<std::size_t>(end - ptr)};
+  if (!IsIntegerSuffix(suffix)) {
+    return std::nullopt;
+  }
+
+  return std::pair{val, suffix.find_first_of("uU") != std::string_view::npos};
+}
+
+template <typename T>
+void AppendValue(std::string &data, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  data.append(bytes, sizeof(T));
+}
+
+// 将一个 (可能带有正负号的) 字面量转换为元素类型后追加到 data 中
+bool AppendLiteral(std::string &data, Type *type, const Token &token,
+                   bool negative) {
+  auto str{token.GetStr()};
+
+  if (token.IsInteger()) {
+    auto result{DecodeInteger(str)};
+    if (!result) {
+      return false;
+    }
+
+    auto [val, is_unsigned]{*result};
+    // 例如 -1u / -0x80000000 的类型是无符号的, 交给常规路径处理
+    if (negative &&
+        (is_unsigned ||
+         val > static_cast<std::uint64_t>(
+                   std::numeric_limits<std::int32_t>::max()))) {
+      return false;
+    }
+    if (negative) {
+      val = -val;
+    }
+
+    if (type->IsFloatTy() || type->IsDoubleTy()) {
+      if (!negative && val > static_cast<std::uint64_t>(
+                                 std::numeric_limits<std::int64_t>::max())) {
+        return false;
+      }
+
+      auto signed_val{static_cast<std::int64_t>(val)};
+      if (type->IsFloatTy()) {
+        AppendValue(data, static_cast<float>(signed_val));
+      } else {
+        AppendValue(data, static_cast<double>(signed_val));
+      }
+      return true;
+    }
+
+    // 转换为整数类型时只需截断
+    switch (type->GetWidth()) {
+      case 1:
+        AppendValue(data, static_cast<std::uint8_t>(val));
+        break;
+      case 2:
+        AppendValue(data, static_cast<std::uint16_t>(val));
+        break;
+      case 4:
+        AppendValue(data, static_cast<std::uint32_t>(val));
+        break;
+      case 8:
+        AppendValue(data, val);
+        break;
+      default:
+        return false;
+    }
+    return true;
+  } else if (token.IsFloatPoint() &&
+             (type->IsFloatTy() || type->IsDoubleTy())) {
+    // 先得到字面量自身类型的值, 再转换为元素类型
+    char *end{};
+    auto expect_end{str.c_str() + std::size(str)};
+    long double val{};
+    errno = 0;
+    if (auto suffix{str.back()}; suffix == 'f' || suffix == 'F') {
+      val = std::strtof(str.c_str(), &end);
+      --expect_end;
+    } else if (suffix == 'l' || suffix == 'L') {
+      val = std::strtold(str.c_str(), &end);
+      --expect_end;
+    } else {
+      val = std::strtod(str.c_str(), &end);
+    }
+
+    if (errno != 0 || end != expect_end) {
+      return false;
+    }
+    if (negative) {
+      val = -val;
+    }
+
+    if (type->IsFloatTy()) {
+      AppendValue(data, static_cast<float>(val));
+    } else {
+      AppendValue(data, static_cast<double>(val));
+    }
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// 块作用域中的数组从该全局常量复制初始值
+llvm::Constant *GetConstantArrayPtr(llvm::Constant *arr, Type *type) {
+  auto var{CreateGlobalString(arr, type->GetAlign())};
+
+  auto zero{llvm::ConstantInt::get(Builder.getInt64Ty(), 0)};
+  llvm::Constant *indices[]{zero, zero};
+  return llvm::ConstantExpr::getInBoundsGetElementPtr(nullptr, var, indices);
+}
+
+}  // namespace
+
 /*
  * Init
  */
@@ -25,15 +189,30 @@ llvm::Constant *Parser::ParseInitializer(std::vector<Initializer> &inits,
   }
 
   if (type->IsArrayTy()) {
+    if (Test(Tag::kEmbed)) {
+      // 嵌套的初始化只能产生 Initializer, 无法使用整块的常量
+      if (!std::empty(indexs_)) {
+        Error(Peek(), "__builtin_embed can only initialize a whole object");
+      }
+      auto arr{ParseEmbedInitializer(type.GetType(), true)};
+      type->SetComplete(true);
+      return arr;
+    }
+
     // int a[2] = 1;
     // 不能直接 Expect , 如果有 '{' , 只能由 ParseArrayInitializer 来处理
     if (force_brace && !Test(Tag::kLeftBrace) && !Test(Tag::kStringLiteral)) {
       Expect(Tag::kLeftBrace);
-    } else if (auto str{ParseLiteralInitializer(type.GetType(), true)}; !str) {
-      ParseArrayInitializer(inits, type.GetType(), designated);
+    } else if (auto str{ParseLiteralInitializer(type.GetType(), true)}) {
+      return str;
+    } else if (auto arr{std::empty(indexs_)
+                            ? TryParseConstantDataArray(type.GetType(), true)
+                            : nullptr}) {
       type->SetComplete(true);
+      return arr;
     } else {
-      return str;
+      ParseArrayInitializer(inits, type.GetType(), designated);
+      type->SetComplete(true);
     }
   } else if (type->IsStructOrUnionTy()) {
     if (!Test(Tag::kPeriod) && !Test(Tag::kLeftBrace)) {
@@ -63,6 +242,20 @@ llvm::Constant *Parser::ParseInitializer(std::vector<Initializer> &inits,
     }
 
     ParseStructInitializer(inits, type.GetType(), designated);
+  } else if (type->IsVectorTy()) {
+    // v4si a = {1, 2, 3, 4};
+    // v4si b = a;
+    if (Test(Tag::kLeftBrace)) {
+      ParseVectorInitializer(inits, type.GetType());
+    } else {
+      auto expr{ParseAssignExpr()};
+      if (!type->Equal(expr->GetType())) {
+        Error(expr,
+              "initializing '{}' with an expression of incompatible type '{}'",
+              type.ToString(), expr->GetQualType().ToString());
+      }
+      inits.emplace_back(type.GetType(), expr, indexs_);
+    }
   } else {
     // 标量类型
     // int a={10}; / int a={10,}; 都是合法的
@@ -209,6 +402,31 @@ void Parser::ParseStructInitializer(std::vector<Initializer> &inits, Type *type,
   }
 }
 
+// 不支持指示符, 未初始化的元素为 0
+void Parser::ParseVectorInitializer(std::vector<Initializer> &inits,
+                                    Type *type) {
+  Expect(Tag::kLeftBrace);
+
+  std::size_t index{};
+  while (!Try(Tag::kRightBrace)) {
+    if (index == type->VectorGetNumElements()) {
+      Error(Peek(), "excess elements in vector initializer");
+    }
+
+    indexs_.push_back({type, index, 0, 0});
+    inits.emplace_back(type->VectorGetElementType().GetType(),
+                       ParseAssignExpr(), indexs_);
+    indexs_.pop_back();
+
+    ++index;
+
+    if (!Try(Tag::kComma)) {
+      Expect(Tag::kRightBrace);
+      break;
+    }
+  }
+}
+
 /*
  * ConstantInit
  */
@@ -219,6 +437,12 @@ llvm::Constant *Parser::ParseConstantInitializer(QualType type, bool designated,
   }
 
   if (type->IsArrayTy()) {
+    if (Test(Tag::kEmbed)) {
+      auto arr{ParseEmbedInitializer(type.GetType(), false)};
+      type->SetComplete(true);
+      return arr;
+    }
+
     if (force_brace && !Test(Tag::kLeftBrace) && !Test(Tag::kStringLiteral)) {
       Expect(Tag::kLeftBrace);
     } else if (auto p{ParseLiteralInitializer(type.GetType(), false)}; !p) {
@@ -230,6 +454,8 @@ llvm::Constant *Parser::ParseConstantInitializer(QualType type, bool designated,
     }
   } else if (type->IsStructOrUnionTy()) {
     return ParseConstantStructInitializer(type.GetType(), designated);
+  } else if (type->IsVectorTy()) {
+    return ParseConstantVectorInitializer(type.GetType());
   } else {
     auto has_brace{Try(Tag::kLeftBrace)};
     auto expr{ParseAssignExpr()};
@@ -254,6 +480,10 @@ llvm::Constant *Parser::ParseConstantInitializer(QualType type, bool designated,
 
 llvm::Constant *Parser::ParseConstantArrayInitializer(Type *type,
                                                       bool designated) {
+  if (auto arr{TryParseConstantDataArray(type, false)}) {
+    return arr;
+  }
+
   std::size_t index{};
   auto has_brace{Try(Tag::kLeftBrace)};
 
@@ -472,6 +702,46 @@ llvm::Constant *Parser::ParseConstantStructInitializer(Type *type,
       llvm::cast<llvm::StructType>(type->GetLLVMType()), val);
 }
 
+llvm::Constant *Parser::ParseConstantVectorInitializer(Type *type) {
+  if (!Test(Tag::kLeftBrace)) {
+    auto expr{ParseAssignExpr()};
+    if (!type->Equal(expr->GetType())) {
+      Error(expr,
+            "initializing '{}' with an expression of incompatible type '{}'",
+            type->ToString(), expr->GetQualType().ToString());
+    }
+
+    if (auto constant{CalcConstantExpr{}.Calc(expr)}) {
+      return constant;
+    } else {
+      Error(expr, "expect constant expression");
+    }
+  }
+
+  Expect(Tag::kLeftBrace);
+
+  auto element_type{type->VectorGetElementType()};
+  std::vector<llvm::Constant *> val(
+      type->VectorGetNumElements(),
+      GetConstantZero(element_type->GetLLVMType()));
+
+  std::size_t index{};
+  while (!Try(Tag::kRightBrace)) {
+    if (index == std::size(val)) {
+      Error(Peek(), "excess elements in vector initializer");
+    }
+
+    val[index++] = ParseConstantInitializer(element_type, false, false);
+
+    if (!Try(Tag::kComma)) {
+      Expect(Tag::kRightBrace);
+      break;
+    }
+  }
+
+  return llvm::ConstantVector::get(val);
+}
+
 llvm::Constant *Parser::ParseLiteralInitializer(Type *type, bool need_ptr) {
   if (!type->ArrayGetElementType()->IsIntegerTy()) {
     return nullptr;
@@ -519,4 +789,118 @@ llvm::Constant *Parser::ParseLiteralInitializer(Type *type, bool need_ptr) {
   }
 }
 
+// 只由整数 / 浮点数字面量组成的初始化列表(比如生成的
+// unsigned char blob[] = {0x7f, 0x45, ...}), 不构造 AST 节点,
+// 直接解码为 ConstantDataArray, 否则回退并返回 nullptr
+llvm::Constant *Parser::TryParseConstantDataArray(Type *type, bool need_ptr) {
+  auto element_type{type->ArrayGetElementType()};
+  if (!Test(Tag::kLeftBrace) ||
+      !(element_type->IsIntegerTy() || element_type->IsFloatTy() ||
+        element_type->IsDoubleTy())) {
+    return nullptr;
+  }
+
+  auto begin{index_};
+  Next();
+
+  std::string data;
+  std::size_t count{};
+  while (!Test(Tag::kRightBrace)) {
+    auto negative{Test(Tag::kMinus)};
+    if (negative || Test(Tag::kPlus)) {
+      Next();
+    }
+
+    if (!AppendLiteral(data, element_type.GetType(), Next(), negative)) {
+      index_ = begin;
+      return nullptr;
+    }
+    ++count;
+
+    if (!Try(Tag::kComma)) {
+      break;
+    }
+  }
+
+  // 元素过多或不完整类型的空初始化由常规路径报错
+  if (!Try(Tag::kRightBrace) ||
+      (type->IsComplete() ? count > type->ArrayGetNumElements()
+                          : count == 0)) {
+    index_ = begin;
+    return nullptr;
+  }
+
+  if (!type->IsComplete()) {
+    type->ArraySetNumElements(count);
+  }
+
+  auto size{type->ArrayGetNumElements()};
+  data.resize(size * element_type->GetWidth());
+  auto arr{llvm::ConstantDataArray::getRaw(data, size,
+                                           element_type->GetLLVMType())};
+
+  return need_ptr ? GetConstantArrayPtr(arr, type) : arr;
+}
+
+// e.g. static const unsigned char blob[] = __builtin_embed("blob.bin");
+// 文件相对于当前源文件所在的目录查找, 其次是 -I 指定的目录
+llvm::Constant *Parser::ParseEmbedInitializer(Type *type, bool need_ptr) {
+  auto token{Expect(Tag::kEmbed)};
+  Expect(Tag::kLeftParen);
+  auto name{ParseStringLiteral()->GetStr()};
+  Expect(Tag::kRightParen);
+
+  auto element_type{type->ArrayGetElementType()};
+  if (!element_type->IsIntegerTy() || element_type->GetWidth() != 1) {
+    Error(token,
+          "__builtin_embed requires an array of character type, not '{}'",
+          type->ToString());
+  }
+
+  std::vector<std::filesystem::path> dirs{
+      std::filesystem::path{token.GetLoc().GetFileName()}.parent_path()};
+  for (const auto &item : IncludePaths) {
+    dirs.emplace_back(item);
+  }
+
+  std::filesystem::path path;
+  for (const auto &dir : dirs) {
+    if (std::filesystem::is_regular_file(dir / name)) {
+      path = dir / name;
+      break;
+    }
+  }
+  if (std::empty(path)) {
+    Error(token, "'{}' file not found", name);
+  }
+
+  auto buffer{llvm::MemoryBuffer::getFile(path.string(), -1, false)};
+  if (!buffer) {
+    Error(token, "can not read '{}': {}", path.string(),
+          buffer.getError().message());
+  }
+
+  auto file_size{(*buffer)->getBufferSize()};
+  if (!type->IsComplete()) {
+    type->ArraySetNumElements(file_size);
+  } else if (file_size > type->ArrayGetNumElements()) {
+    Error(token, "'{}' ({} bytes) is too large for an array of {} elements",
+          name, file_size, type->ArrayGetNumElements());
+  }
+
+  auto size{type->ArrayGetNumElements()};
+  llvm::Constant *arr;
+  if (file_size == size) {
+    arr = llvm::ConstantDataArray::getRaw((*buffer)->getBuffer(), size,
+                                          element_type->GetLLVMType());
+  } else {
+    auto data{(*buffer)->getBuffer().str()};
+    data.resize(size);
+    arr = llvm::ConstantDataArray::getRaw(data, size,
+                                          element_type->GetLLVMType());
+  }
+
+  return need_ptr ? GetConstantArrayPtr(arr, type) : arr;
+}
+
 }  // namespace kcc
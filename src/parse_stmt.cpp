@@ -4,15 +4,89 @@
 
 #include "parse.h"
 
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
 #include "error.h"
+#include "lex.h"
 
 namespace kcc {
 
+namespace {
+
+// #pragma 中的整数, 与整数常量一样可以有进制前缀和后缀, 不能超出 int 的范围
+std::int32_t PragmaInteger(const Token &token) {
+  auto str{token.GetStr()};
+  std::uint64_t val{};
+  std::size_t end{};
+
+  try {
+    val = std::stoull(str, &end, 0);
+  } catch (const std::logic_error &) {
+    Error(token, "invalid integer '{}' in '#pragma'", str);
+  }
+
+  if (str.find_first_not_of("uUlL", end) != std::string::npos ||
+      val > std::numeric_limits<std::int32_t>::max()) {
+    Error(token, "invalid integer '{}' in '#pragma'", str);
+  }
+
+  return static_cast<std::int32_t>(val);
+}
+
+}  // namespace
+
 /*
  * Stmt
  */
 Stmt *Parser::ParseStmt() {
-  TryParseAttributeSpec();
+  // e.g.
+  // #pragma GCC unroll 4
+  // for (...) {}
+  if (Test(Tag::kPragma)) {
+    auto token{Peek()};
+    LoopHints hints;
+    while (Test(Tag::kPragma)) {
+      if (Peek().GetStr().compare(0, 4, "omp ") == 0) {
+        // 除 simd 外, OpenMP 指令之后的语句由 ParseOmpPragma 解析
+        if (auto stmt{ParseOmpPragma(hints)}) {
+          return stmt;
+        }
+      } else {
+        ParseLoopPragma(hints);
+      }
+    }
+
+    switch (Peek().GetTag()) {
+      case Tag::kWhile:
+        return ParseWhileStmt(hints);
+      case Tag::kDo:
+        return ParseDoWhileStmt(hints);
+      case Tag::kFor:
+        return ParseForStmt(hints);
+      default:
+        Error(token, "expected a loop to follow '#pragma {}'", token.GetStr());
+    }
+  }
+
+  auto token{Peek()};
+  Attributes attrs;
+  TryParseAttributeSpec(&attrs);
+
+  if (attrs.vector_size) {
+    Warning(token, "'vector_size' attribute ignored");
+  }
+
+  // e.g. __attribute__((musttail)) return f(a);
+  if (attrs.must_tail) {
+    if (!Test(Tag::kReturn)) {
+      Error(token, "'musttail' attribute only applies to return statements");
+    }
+    return ParseReturnStmt(true);
+  }
 
   switch (Peek().GetTag()) {
     case Tag::kIdentifier: {
@@ -49,6 +123,8 @@ Stmt *Parser::ParseStmt() {
       return ParseBreakStmt();
     case Tag::kReturn:
       return ParseReturnStmt();
+    case Tag::kAsm:
+      return ParseAsmStmt();
     default:
       return ParseExprStmt();
   }
@@ -151,17 +227,17 @@ Stmt *Parser::ParseSwitchStmt() {
   return MakeAstNode<SwitchStmt>(token, cond, ParseStmt());
 }
 
-Stmt *Parser::ParseWhileStmt() {
+Stmt *Parser::ParseWhileStmt(const LoopHints &hints) {
   auto token{Expect(Tag::kWhile)};
 
   Expect(Tag::kLeftParen);
   auto cond{ParseExpr()};
   Expect(Tag::kRightParen);
 
-  return MakeAstNode<WhileStmt>(token, cond, ParseStmt());
+  return MakeAstNode<WhileStmt>(token, cond, ParseStmt(), hints);
 }
 
-Stmt *Parser::ParseDoWhileStmt() {
+Stmt *Parser::ParseDoWhileStmt(const LoopHints &hints) {
   auto token{Expect(Tag::kDo)};
 
   auto stmt{ParseStmt()};
@@ -172,10 +248,10 @@ Stmt *Parser::ParseDoWhileStmt() {
   Expect(Tag::kRightParen);
   Expect(Tag::kSemicolon);
 
-  return MakeAstNode<DoWhileStmt>(token, cond, stmt);
+  return MakeAstNode<DoWhileStmt>(token, cond, stmt, hints);
 }
 
-Stmt *Parser::ParseForStmt() {
+Stmt *Parser::ParseForStmt(const LoopHints &hints) {
   auto token{Expect(Tag::kFor)};
   Expect(Tag::kLeftParen);
 
@@ -204,11 +280,278 @@ Stmt *Parser::ParseForStmt() {
   block = ParseStmt();
   ExitBlock();
 
-  return MakeAstNode<ForStmt>(token, init, cond, inc, block, decl);
+  return MakeAstNode<ForStmt>(token, init, cond, inc, block, decl, hints);
+}
+
+// #pragma unroll / unroll N / unroll(N) / nounroll
+// #pragma GCC unroll N / GCC ivdep
+// #pragma clang loop option(value) ...
+void Parser::ParseLoopPragma(LoopHints &hints) {
+  auto token{Expect(Tag::kPragma)};
+  auto tokens{Scanner{token.GetStr(), token.GetLoc()}.Tokenize()};
+  auto iter{std::begin(tokens)};
+
+  auto expect{[&](Tag tag) {
+    if (!iter->TagIs(tag)) {
+      Error(*iter, "unexpected '{}' in '#pragma {}'", iter->GetStr(),
+            token.GetStr());
+    }
+    return *iter++;
+  }};
+  auto expect_integer{[&] { return PragmaInteger(expect(Tag::kInteger)); }};
+
+  auto name{expect(Tag::kIdentifier).GetStr()};
+  if (name == "GCC" || name == "clang") {
+    name += " " + expect(Tag::kIdentifier).GetStr();
+  }
+
+  if (name == "unroll") {
+    if (iter->IsEof()) {
+      hints.unroll_full = true;
+    } else if (iter->TagIs(Tag::kLeftParen)) {
+      ++iter;
+      hints.unroll_count = expect_integer();
+      expect(Tag::kRightParen);
+    } else {
+      hints.unroll_count = expect_integer();
+    }
+  } else if (name == "nounroll") {
+    hints.unroll_disable = true;
+  } else if (name == "GCC unroll") {
+    // 0 和 1 表示不展开
+    if (auto count{expect_integer()}; count <= 1) {
+      hints.unroll_disable = true;
+    } else {
+      hints.unroll_count = count;
+    }
+  } else if (name == "GCC ivdep") {
+    hints.ivdep = true;
+  } else if (name == "clang loop") {
+    while (!iter->IsEof()) {
+      auto option{expect(Tag::kIdentifier)};
+      auto option_name{option.GetStr()};
+      expect(Tag::kLeftParen);
+
+      if (option_name == "vectorize_width") {
+        hints.vectorize_width = expect_integer();
+      } else if (option_name == "interleave_count") {
+        hints.interleave_count = expect_integer();
+      } else if (option_name == "unroll_count") {
+        hints.unroll_count = expect_integer();
+      } else {
+        auto value{expect(Tag::kIdentifier).GetStr()};
+
+        if (option_name == "vectorize" && value == "assume_safety") {
+          hints.vectorize = true;
+          hints.ivdep = true;
+        } else if (option_name == "vectorize") {
+          hints.vectorize = value == "enable";
+        } else if (option_name == "interleave") {
+          if (value == "enable") {
+            hints.vectorize = true;
+          } else {
+            hints.interleave_count = 1;
+          }
+        } else if (option_name == "unroll") {
+          hints.unroll_full = value == "full";
+          hints.unroll_enable = value == "enable";
+          hints.unroll_disable = value == "disable";
+        } else {
+          Warning(option, "unknown loop hint '{}' ignored", option_name);
+        }
+      }
+
+      expect(Tag::kRightParen);
+    }
+  } else {
+    Warning(token, "unknown loop pragma '{}' ignored", token.GetStr());
+  }
+
+  if (!iter->IsEof()) {
+    Warning(*iter, "extra tokens at end of '#pragma {}'", token.GetStr());
+  }
+}
+
+// #pragma omp parallel / parallel for [simd] / for [simd] / simd
+// #pragma omp critical [(name)] / barrier
+Stmt *Parser::ParseOmpPragma(LoopHints &hints) {
+  auto token{Expect(Tag::kPragma)};
+
+  // 子句中的表达式需要在当前的作用域中解析, 暂时将 pragma 的内容作为输入
+  auto tokens{Scanner{token.GetStr(), token.GetLoc()}.Tokenize()};
+  std::swap(tokens, tokens_);
+  auto index{std::exchange(index_, 0)};
+
+  auto try_identifier{[&](const std::string &name) {
+    if (Peek().IsIdentifier() && Peek().GetIdentifier() == name) {
+      Next();
+      return true;
+    }
+    return false;
+  }};
+
+  Next();  // omp
+
+  OmpStmt::Directive directive;
+  bool simd{false};
+  // 单独的 simd 不是工作共享循环
+  bool simd_only{false};
+  if (Try(Tag::kFor)) {
+    directive = OmpStmt::Directive::kFor;
+    simd = try_identifier("simd");
+  } else if (try_identifier("parallel")) {
+    if (Try(Tag::kFor)) {
+      directive = OmpStmt::Directive::kParallelFor;
+      simd = try_identifier("simd");
+    } else {
+      directive = OmpStmt::Directive::kParallel;
+    }
+  } else if (try_identifier("simd")) {
+    directive = OmpStmt::Directive::kFor;
+    simd = simd_only = true;
+  } else if (try_identifier("critical")) {
+    directive = OmpStmt::Directive::kCritical;
+  } else if (try_identifier("barrier")) {
+    directive = OmpStmt::Directive::kBarrier;
+  } else {
+    Error(Peek(), "unsupported OpenMP directive '#pragma {}'",
+          token.GetStr());
+  }
+
+  OmpStmt::Clauses clauses;
+  std::int32_t safelen{};
+  if (directive == OmpStmt::Directive::kCritical && Try(Tag::kLeftParen)) {
+    clauses.name = Expect(Tag::kIdentifier).GetIdentifier();
+    Expect(Tag::kRightParen);
+  }
+  ParseOmpClauses(clauses, safelen);
+
+  std::swap(tokens, tokens_);
+  index_ = index;
+
+  // 迭代之间没有依赖, 提示 LLVM 向量化
+  if (simd) {
+    hints.vectorize = true;
+    hints.ivdep = true;
+    hints.vectorize_width = safelen;
+  }
+  if (simd_only) {
+    return nullptr;
+  }
+
+  switch (directive) {
+    case OmpStmt::Directive::kFor:
+    case OmpStmt::Directive::kParallelFor:
+      if (!Test(Tag::kFor)) {
+        Error(token, "expected a for loop to follow '#pragma {}'",
+              token.GetStr());
+      }
+      return MakeAstNode<OmpStmt>(token, directive, clauses,
+                                  ParseForStmt(hints));
+    case OmpStmt::Directive::kBarrier:
+      return MakeAstNode<OmpStmt>(token, directive, clauses);
+    default:
+      return MakeAstNode<OmpStmt>(token, directive, clauses, ParseStmt());
+  }
+}
+
+// num_threads(expr) schedule(static|dynamic[, chunk]) nowait
+// private(list) shared(list) default(shared|none) reduction(op: list)
+// safelen(N) simdlen(N)
+void Parser::ParseOmpClauses(OmpStmt::Clauses &clauses,
+                             std::int32_t &safelen) {
+  while (HasNext()) {
+    Try(Tag::kComma);
+
+    // default 是关键字
+    if (Try(Tag::kDefault)) {
+      Expect(Tag::kLeftParen);
+      Expect(Tag::kIdentifier);
+      Expect(Tag::kRightParen);
+      continue;
+    }
+
+    auto token{Expect(Tag::kIdentifier)};
+    auto name{token.GetIdentifier()};
+
+    if (name == "nowait") {
+      clauses.nowait = true;
+      continue;
+    }
+
+    Expect(Tag::kLeftParen);
+    if (name == "num_threads") {
+      clauses.num_threads = ParseAssignExpr();
+    } else if (name == "schedule") {
+      auto kind{Expect(Tag::kIdentifier).GetIdentifier()};
+      if (kind == "dynamic") {
+        clauses.schedule = OmpStmt::Schedule::kDynamic;
+      } else if (kind != "static") {
+        // guided / auto / runtime 按 static 处理
+        Warning(token, "schedule kind '{}' is treated as 'static'", kind);
+      }
+      if (Try(Tag::kComma)) {
+        clauses.chunk_size = ParseAssignExpr();
+      }
+    } else if (name == "private") {
+      auto vars{ParseOmpVarList()};
+      clauses.privates.insert(std::end(clauses.privates), std::begin(vars),
+                              std::end(vars));
+    } else if (name == "shared") {
+      // 在区域外声明的变量默认是共享的
+      ParseOmpVarList();
+    } else if (name == "reduction") {
+      auto op{Next()};
+      if (!op.TagIs(Tag::kPlus) && !op.TagIs(Tag::kMinus) &&
+          !op.TagIs(Tag::kStar) && !op.TagIs(Tag::kAmp) &&
+          !op.TagIs(Tag::kPipe) && !op.TagIs(Tag::kCaret) &&
+          !op.TagIs(Tag::kAmpAmp) && !op.TagIs(Tag::kPipePipe) &&
+          op.GetStr() != "max" && op.GetStr() != "min") {
+        Error(op, "incorrect reduction identifier '{}'", op.GetStr());
+      }
+      Expect(Tag::kColon);
+      for (const auto &item : ParseOmpVarList()) {
+        clauses.reductions.emplace_back(op.GetStr(), item);
+      }
+    } else if (name == "safelen" || name == "simdlen") {
+      safelen = PragmaInteger(Expect(Tag::kInteger));
+    } else {
+      Error(token, "unsupported OpenMP clause '{}'", name);
+    }
+    Expect(Tag::kRightParen);
+  }
+}
+
+std::vector<ObjectExpr *> Parser::ParseOmpVarList() {
+  std::vector<ObjectExpr *> vars;
+
+  do {
+    auto token{Expect(Tag::kIdentifier)};
+    auto ident{scope_->FindUsual(token.GetIdentifier())};
+    if (!ident) {
+      Error(token, "undefined symbol: {}", token.GetIdentifier());
+    }
+
+    auto obj{dynamic_cast<ObjectExpr *>(ident)};
+    if (!obj) {
+      Error(token, "'{}' is not a variable", token.GetIdentifier());
+    }
+    vars.push_back(obj);
+  } while (Try(Tag::kComma));
+
+  return vars;
 }
 
 Stmt *Parser::ParseGotoStmt() {
-  Expect(Tag::kGoto);
+  auto token{Expect(Tag::kGoto)};
+
+  // GNU 扩展, goto *expr;
+  if (Try(Tag::kStar)) {
+    auto expr{Expr::MayCast(ParseExpr())};
+    Expect(Tag::kSemicolon);
+    return MakeAstNode<GotoStmt>(token, expr);
+  }
+
   auto tok{Expect(Tag::kIdentifier)};
   Expect(Tag::kSemicolon);
 
@@ -232,18 +575,19 @@ Stmt *Parser::ParseBreakStmt() {
   return MakeAstNode<BreakStmt>(token);
 }
 
-Stmt *Parser::ParseReturnStmt() {
+Stmt *Parser::ParseReturnStmt(bool must_tail) {
   auto token{Expect(Tag::kReturn)};
+  auto func_type{func_def_->GetFuncType()};
 
   if (Try(Tag::kSemicolon)) {
-    return MakeAstNode<ReturnStmt>(token);
+    return MakeAstNode<ReturnStmt>(token, nullptr, func_type, must_tail);
   } else {
     auto expr{ParseExpr()};
-    expr = Expr::MayCastTo(expr, func_def_->GetFuncType()->FuncGetReturnType());
+    expr = Expr::MayCastTo(expr, func_type->FuncGetReturnType());
 
     Expect(Tag::kSemicolon);
 
-    return MakeAstNode<ReturnStmt>(token, expr);
+    return MakeAstNode<ReturnStmt>(token, expr, func_type, must_tail);
   }
 }
 
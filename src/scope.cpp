@@ -4,12 +4,22 @@
 
 #include "scope.h"
 
+#include <vector>
+
 #include "memory_pool.h"
 
 namespace kcc {
 
+namespace {
+
+std::vector<Scope *> Scopes;
+
+}  // namespace
+
 Scope *Scope::Get(Scope *parent, enum ScopeType type) {
-  return new (ScopePool.malloc()) Scope{parent, type};
+  auto scope{new (ScopePool.malloc()) Scope{parent, type}};
+  Scopes.push_back(scope);
+  return scope;
 }
 
 void Scope::InsertTag(IdentifierExpr *ident) {
@@ -79,6 +89,15 @@ bool Scope::IsFileScope() const { return type_ == kFile; }
 
 bool Scope::IsBlockScope() const { return type_ == kBlock; }
 
+std::pair<std::size_t, std::size_t> Scope::GetHashMapStats() {
+  std::size_t size{}, bucket_count{};
+  for (const auto &item : Scopes) {
+    size += std::size(item->tags_) + std::size(item->usual_);
+    bucket_count += item->tags_.bucket_count() + item->usual_.bucket_count();
+  }
+  return {size, bucket_count};
+}
+
 Scope::Scope(Scope *parent, enum ScopeType type)
     : parent_{parent}, type_{type} {}
 
@@ -64,11 +64,13 @@ bool Token::IsTypeSpecQual() const {
          tag_ == Tag::kComplex || tag_ == Tag::kAtomic ||
          tag_ == Tag::kStruct || tag_ == Tag::kUnion || tag_ == Tag::kEnum ||
          tag_ == Tag::kConst || tag_ == Tag::kRestrict ||
-         tag_ == Tag::kVolatile || tag_ == Tag::kAtomic || tag_ == Tag::kTypeof;
+         tag_ == Tag::kVolatile || tag_ == Tag::kAtomic ||
+         tag_ == Tag::kTypeof || tag_ == Tag::kInt128;
 }
 
 bool Token::IsDeclSpec() const {
-  return IsTypeSpecQual() || tag_ == Tag::kAttribute || tag_ == Tag::kInline ||
+  return IsTypeSpecQual() || tag_ == Tag::kAutoType ||
+         tag_ == Tag::kAttribute || tag_ == Tag::kInline ||
          tag_ == Tag::kNoreturn || tag_ == Tag::kAlignas ||
          tag_ == Tag::kStaticAssert || tag_ == Tag::kTypedef ||
          tag_ == Tag::kExtern || tag_ == Tag::kStatic ||
@@ -38,7 +38,7 @@ std::string QualType::ToString() const {
     str += "volatile ";
   }
   if (type_qual_ & kAtomic) {
-    assert(false);
+    str += "_Atomic ";
   }
 
   return str + type_->ToString();
@@ -70,6 +70,8 @@ bool QualType::IsConst() const { return type_qual_ & kConst; }
 
 bool QualType::IsVolatile() const { return type_qual_ & kVolatile; }
 
+bool QualType::IsAtomic() const { return type_qual_ & kAtomic; }
+
 bool operator==(QualType lhs, QualType rhs) { return lhs.type_ == rhs.type_; }
 
 bool operator!=(QualType lhs, QualType rhs) { return !(lhs == rhs); }
@@ -96,6 +98,8 @@ std::string Type::ToString() const {
     prefix = IsUnsigned() ? "u" : "";
   } else if (IsPointerTy()) {
     prefix = PointerGetElementType()->IsUnsigned() ? "u" : "";
+  } else if (IsVectorTy()) {
+    prefix = VectorGetElementType()->IsUnsigned() ? "u" : "";
   }
 
   return prefix + LLVMTypeToStr(llvm_type_);
@@ -116,6 +120,8 @@ PointerType *Type::ToPointerType() { return dynamic_cast<PointerType *>(this); }
 
 ArrayType *Type::ToArrayType() { return dynamic_cast<ArrayType *>(this); }
 
+VectorType *Type::ToVectorType() { return dynamic_cast<VectorType *>(this); }
+
 StructType *Type::ToStructType() { return dynamic_cast<StructType *>(this); }
 
 FunctionType *Type::ToFunctionType() {
@@ -138,6 +144,10 @@ const ArrayType *Type::ToArrayType() const {
   return dynamic_cast<const ArrayType *>(this);
 }
 
+const VectorType *Type::ToVectorType() const {
+  return dynamic_cast<const VectorType *>(this);
+}
+
 const StructType *Type::ToStructType() const {
   return dynamic_cast<const StructType *>(this);
 }
@@ -161,6 +171,11 @@ bool Type::IsUnsigned() const {
     return true;
   }
 
+  // 向量运算的符号取决于元素类型
+  if (IsVectorTy()) {
+    return VectorGetElementType()->IsUnsigned();
+  }
+
   if (!IsIntegerTy()) {
     return false;
   } else {
@@ -199,6 +214,12 @@ bool Type::IsLongLongTy() const {
                   (type->type_spec_ == (kLongLong | kUnsigned)));
 }
 
+bool Type::IsInt128Ty() const {
+  auto type{ToArithmeticType()};
+  return type && ((type->type_spec_ == kInt128) ||
+                  (type->type_spec_ == (kInt128 | kUnsigned)));
+}
+
 bool Type::IsFloatTy() const {
   auto type{ToArithmeticType()};
   return type && (type->type_spec_ == kFloat);
@@ -218,6 +239,13 @@ bool Type::IsPointerTy() const { return ToPointerType(); }
 
 bool Type::IsArrayTy() const { return ToArrayType(); }
 
+bool Type::IsVLATy() const {
+  auto type{ToArrayType()};
+  return type && type->IsVLA();
+}
+
+bool Type::IsVectorTy() const { return ToVectorType(); }
+
 bool Type::IsStructTy() const {
   auto type{ToStructType()};
   return type && type->is_struct_;
@@ -294,6 +322,31 @@ QualType Type::ArrayGetElementType() const {
   return ToArrayType()->GetElementType();
 }
 
+Expr *Type::ArrayGetVLALength() const {
+  assert(IsVLATy());
+  return ToArrayType()->GetVLALength();
+}
+
+ObjectExpr *Type::ArrayGetVLASize() const {
+  assert(IsVLATy());
+  return ToArrayType()->GetVLASize();
+}
+
+void Type::ArraySetVLASize(ObjectExpr *size) {
+  assert(IsVLATy());
+  ToArrayType()->SetVLASize(size);
+}
+
+std::size_t Type::VectorGetNumElements() const {
+  assert(IsVectorTy());
+  return ToVectorType()->GetNumElements();
+}
+
+QualType Type::VectorGetElementType() const {
+  assert(IsVectorTy());
+  return ToVectorType()->GetElementType();
+}
+
 bool Type::StructHasName() const {
   assert(IsStructOrUnionTy());
   return ToStructType()->HasName();
@@ -447,6 +500,10 @@ ArithmeticType *ArithmeticType::Get(std::uint32_t type_spec) {
                                  ArithmeticType{kLongLong}};
   static auto ulong_long_type{new (ArithmeticTypePool.malloc())
                                   ArithmeticType{kLongLong | kUnsigned}};
+  static auto int128_type{new (ArithmeticTypePool.malloc())
+                              ArithmeticType{kInt128}};
+  static auto uint128_type{new (ArithmeticTypePool.malloc())
+                               ArithmeticType{kInt128 | kUnsigned}};
   static auto float_type{new (ArithmeticTypePool.malloc())
                              ArithmeticType{kFloat}};
   static auto double_type{new (ArithmeticTypePool.malloc())
@@ -479,6 +536,10 @@ ArithmeticType *ArithmeticType::Get(std::uint32_t type_spec) {
       return long_long_type;
     case kLongLong | kUnsigned:
       return ulong_long_type;
+    case kInt128:
+      return int128_type;
+    case kInt128 | kUnsigned:
+      return uint128_type;
     case kFloat:
       return float_type;
     case kDouble:
@@ -556,6 +617,9 @@ std::int32_t ArithmeticType::GetWidth() const {
     case kLongLong:
     case kLongLong | kUnsigned:
       return 8;
+    case kInt128:
+    case kInt128 | kUnsigned:
+      return 16;
     case kFloat:
       return 4;
     case kDouble:
@@ -607,6 +671,10 @@ std::uint64_t ArithmeticType::MaxIntegerValue() const {
     case kLong | kUnsigned:
     case kLongLong | kUnsigned:
       return std::numeric_limits<std::uint64_t>::max();
+    // 超出了 std::uint64_t 的范围, 这里取饱和值, 只用于 MaxType 中的比较
+    case kInt128:
+    case kInt128 | kUnsigned:
+      return std::numeric_limits<std::uint64_t>::max();
     default:
       assert(false);
       return 0;
@@ -626,6 +694,8 @@ ArithmeticType::ArithmeticType(std::uint32_t type_spec) : Type{true} {
     llvm_type_ = Builder.getInt32Ty();
   } else if (IsLongTy() || IsLongLongTy()) {
     llvm_type_ = Builder.getInt64Ty();
+  } else if (IsInt128Ty()) {
+    llvm_type_ = Builder.getInt128Ty();
   } else if (IsFloatTy()) {
     llvm_type_ = Builder.getFloatTy();
   } else if (IsDoubleTy()) {
@@ -646,7 +716,8 @@ std::uint32_t ArithmeticType::DealWithTypeSpec(std::uint32_t type_spec) {
 
   type_spec &= ~kSigned;
 
-  if ((type_spec & kShort) || (type_spec & kLong) || (type_spec & kLongLong)) {
+  if ((type_spec & kShort) || (type_spec & kLong) || (type_spec & kLongLong) ||
+      (type_spec & kInt128)) {
     type_spec &= ~kInt;
   }
 
@@ -672,12 +743,15 @@ std::int32_t ArithmeticType::Rank() const {
     case kLongLong:
     case kLongLong | kUnsigned:
       return 5;
-    case kFloat:
+    case kInt128:
+    case kInt128 | kUnsigned:
       return 6;
-    case kDouble:
+    case kFloat:
       return 7;
-    case kDouble | kLong:
+    case kDouble:
       return 8;
+    case kDouble | kLong:
+      return 9;
     default:
       assert(false);
       return 0;
@@ -737,8 +811,14 @@ ArrayType *ArrayType::Get(QualType contained_type,
   return new (ArrayTypePool.malloc()) ArrayType{contained_type, num_elements};
 }
 
+ArrayType *ArrayType::GetVLA(QualType contained_type, Expr *length) {
+  assert(length != nullptr);
+  return new (ArrayTypePool.malloc()) ArrayType{contained_type, length};
+}
+
 std::int32_t ArrayType::GetWidth() const {
-  assert(num_elements_);
+  // 变长数组的大小在运行时计算
+  assert(num_elements_ && !IsVLA());
   return contained_type_->GetWidth() * *num_elements_;
 }
 
@@ -755,6 +835,9 @@ bool ArrayType::Compatible(const Type *other) const {
     if (!contained_type_->Compatible(other_arr->contained_type_.GetType())) {
       return false;
     }
+    if (IsVLA() || other_arr->IsVLA()) {
+      return true;
+    }
     if (IsComplete() && other_arr->IsComplete()) {
       return GetNumElements() == other_arr->GetNumElements();
     }
@@ -773,6 +856,9 @@ bool ArrayType::Equal(const Type *other) const {
     if (!contained_type_->Equal(other_arr->contained_type_.GetType())) {
       return false;
     }
+    if (IsVLA() || other_arr->IsVLA()) {
+      return vla_length_ == other_arr->vla_length_;
+    }
     if (IsComplete() && other_arr->IsComplete()) {
       return GetNumElements() == other_arr->GetNumElements();
     }
@@ -802,6 +888,14 @@ std::size_t ArrayType::GetNumElements() const {
 
 QualType ArrayType::GetElementType() const { return contained_type_; }
 
+bool ArrayType::IsVLA() const { return vla_length_ != nullptr; }
+
+Expr *ArrayType::GetVLALength() const { return vla_length_; }
+
+ObjectExpr *ArrayType::GetVLASize() const { return vla_size_; }
+
+void ArrayType::SetVLASize(ObjectExpr *size) { vla_size_ = size; }
+
 ArrayType::ArrayType(QualType contained_type,
                      std::optional<std::size_t> num_elements)
     : Type{num_elements.has_value()},
@@ -815,6 +909,50 @@ ArrayType::ArrayType(QualType contained_type,
   }
 }
 
+// 变长数组的存储由动态的 alloca 分配, 其 LLVM 类型的元素数量为 0
+ArrayType::ArrayType(QualType contained_type, Expr *length)
+    : Type{true}, contained_type_{contained_type}, vla_length_{length} {
+  llvm_type_ = llvm::ArrayType::get(contained_type_->GetLLVMType(), 0);
+}
+
+/*
+ * VectorType
+ */
+VectorType *VectorType::Get(QualType element_type, std::size_t num_elements) {
+  return new (VectorTypePool.malloc()) VectorType{element_type, num_elements};
+}
+
+std::int32_t VectorType::GetWidth() const {
+  return element_type_->GetWidth() * num_elements_;
+}
+
+// 和 GCC 一样, 按向量的大小对齐
+std::int32_t VectorType::GetAlign() const { return GetWidth(); }
+
+bool VectorType::Compatible(const Type *other) const { return Equal(other); }
+
+bool VectorType::Equal(const Type *other) const {
+  assert(other != nullptr);
+
+  if (other->IsVectorTy()) {
+    auto other_vec{other->ToVectorType()};
+    return element_type_->Equal(other_vec->element_type_.GetType()) &&
+           num_elements_ == other_vec->num_elements_;
+  } else {
+    return false;
+  }
+}
+
+std::size_t VectorType::GetNumElements() const { return num_elements_; }
+
+QualType VectorType::GetElementType() const { return element_type_; }
+
+VectorType::VectorType(QualType element_type, std::size_t num_elements)
+    : Type{true}, element_type_{element_type}, num_elements_{num_elements} {
+  llvm_type_ = llvm::FixedVectorType::get(element_type_->GetLLVMType(),
+                                          num_elements_);
+}
+
 /*
  * StructType
  */
@@ -954,6 +1092,14 @@ void StructType::AddMember(ObjectExpr *member) {
   // bit field 前后的对齐空间不包括在 offset 中
   member->SetOffset(offset - bit_field_space_count_);
 
+  // LLVM 的数据布局中 i128 只按 8 字节对齐, 与 ABI 不同时需要显式填充
+  if (is_struct_ &&
+      MakeAlign(offset_, GetLLVMTypeAlign(type->GetLLVMType())) < offset) {
+    llvm_types_.push_back(
+        llvm::ArrayType::get(Builder.getInt8Ty(), offset - offset_));
+    ++index_;
+  }
+
   member->GetIndexs().push_front({this, index_++});
 
   members_.push_back(member);
@@ -981,6 +1127,15 @@ void StructType::MergeAnonymous(ObjectExpr *anonymous) {
   auto offset{MakeAlign(offset_, anonymous->GetAlign())};
   anonymous->SetOffset(offset);
 
+  // 同 AddMember, 匿名成员中可能含有 __int128 或 _Alignas
+  if (is_struct_ &&
+      MakeAlign(offset_, GetLLVMTypeAlign(anonymous_type->GetLLVMType())) <
+          offset) {
+    llvm_types_.push_back(
+        llvm::ArrayType::get(Builder.getInt8Ty(), offset - offset_));
+    ++index_;
+  }
+
   anonymous->GetIndexs().push_front({this, index_});
 
   members_.push_back(anonymous);
@@ -1145,6 +1300,13 @@ void StructType::Finish() {
     assert(std::size(llvm_types_) == 0 || std::size(llvm_types_) == 1);
   }
 
+  // 同上, 末尾的填充, 联合体的填充放在最大的成员之后
+  if (auto size{GetLLVMTypeSize(llvm::StructType::get(Context, llvm_types_))};
+      size < width_) {
+    llvm_types_.push_back(
+        llvm::ArrayType::get(Builder.getInt8Ty(), width_ - size));
+  }
+
   auto struct_type{llvm::cast<llvm::StructType>(llvm_type_)};
   assert(struct_type->getStructNumElements() == 0);
   struct_type->setBody(llvm_types_);
@@ -14,7 +14,10 @@
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <system_error>
 
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include "error.h"
@@ -31,7 +34,24 @@ void InitCommandLine(int argc, char *argv[]) {
     os << "InstalledDir: " << GetPath() << '\n';
   });
 
-  llvm::cl::ParseCommandLineOptions(argc, argv);
+  // kcc --run file.c [args], .c 文件之后的参数属于程序, 不由 kcc 解析
+  std::vector<char *> args{argv, argv + argc};
+  auto run{std::find_if(std::begin(args), std::end(args), [](const char *arg) {
+    return std::strcmp(arg, "--run") == 0 || std::strcmp(arg, "-run") == 0;
+  })};
+  if (run != std::end(args)) {
+    auto file{std::find_if(run + 1, std::end(args), [](const char *arg) {
+      return *arg != '-' &&
+             std::filesystem::path{arg}.extension().string() == ".c";
+    })};
+    if (file != std::end(args)) {
+      RunArgs.assign(file + 1, std::end(args));
+      args.erase(file + 1, std::end(args));
+    }
+  }
+
+  llvm::cl::ParseCommandLineOptions(static_cast<int>(std::size(args)),
+                                    args.data());
 }
 
 void CommandLineCheck() {
@@ -96,6 +116,16 @@ void CommandLineCheck() {
     InputFilePaths.push_back(item);
   }
 
+  if (JitRun) {
+    if (std::size(InputFilePaths) != 1 || !std::empty(ObjFile) ||
+        !std::empty(AFile)) {
+      Error("--run requires exactly one '.c' file and no '.o' or '.a' files");
+    }
+    if (DoNotLink() || FLto != LTOKind::kNone) {
+      Error("--run can't be used with -c, -S, -E, -emit-* or -flto");
+    }
+  }
+
   for (const auto &folder : IncludePaths) {
     if (!std::filesystem::exists(folder)) {
       Error("no such directory: {}", folder);
@@ -107,6 +137,19 @@ void CommandLineCheck() {
     Error("Cannot specify -o when generating multiple output files");
   }
 
+  if (ProfileGenerate() && !std::empty(FProfileUse)) {
+    Error("-fprofile-generate and -fprofile-use can't be used together");
+  }
+
+  if (!std::empty(FProfileUse)) {
+    if (std::filesystem::is_directory(FProfileUse.getValue())) {
+      FProfileUse = (std::filesystem::path{FProfileUse.getValue()} /
+                     "default.profdata")
+                        .string();
+    }
+    EnsureFileExists(FProfileUse);
+  }
+
   for (auto &&item : RPath) {
     if (!std::filesystem::exists(item)) {
       Error("no such directory: {}", item);
@@ -119,6 +162,11 @@ void CommandLineCheck() {
     item = "-l" + item;
   }
 
+  // OpenMP 4.5
+  if (FOpenMP) {
+    MacroDefines.push_back("_OPENMP=201511");
+  }
+
   for (const auto &item : InputFilePaths) {
     ObjFile.push_back(GetObjFile(item));
   }
@@ -166,6 +214,27 @@ void TimingEnd(const std::string &str) {
   }
 }
 
+void TimeTraceStart() {
+  if (FTimeTrace) {
+    llvm::timeTraceProfilerInitialize(FTimeTraceGranularity, "kcc");
+  }
+}
+
+void TimeTraceEnd(const std::string &trace_file) {
+  if (!llvm::timeTraceProfilerEnabled()) {
+    return;
+  }
+
+  std::error_code error_code;
+  llvm::raw_fd_ostream os{trace_file, error_code, llvm::sys::fs::OF_Text};
+  if (error_code) {
+    Error("Could not open file: '{}'", error_code.message());
+  }
+
+  llvm::timeTraceProfilerWrite(os);
+  llvm::timeTraceProfilerCleanup();
+}
+
 void EnsureFileExists(const std::string &file_name) {
   if (!std::filesystem::exists(file_name)) {
     Error("no such file: {}", file_name);
@@ -181,6 +250,15 @@ std::string GetFileName(const std::string &name, std::string_view extension) {
   return std::filesystem::path{name}.replace_extension(extension).string();
 }
 
+std::string GetAuxFileName(const std::string &name,
+                           std::string_view extension) {
+  if (OutputObjectFile && !std::empty(OutputFilePath)) {
+    return GetFileName(OutputFilePath, extension);
+  } else {
+    return GetFileName(name, extension);
+  }
+}
+
 void RemoveFiles() {
   for (const auto &item : RemoveFile) {
     std::filesystem::remove(item);
@@ -191,6 +269,8 @@ bool CommandSuccess(std::int32_t status) {
   return status != -1 && WIFEXITED(status) && !WEXITSTATUS(status);
 }
 
+bool ProfileGenerate() { return FProfileGenerate.getNumOccurrences() > 0; }
+
 bool DoNotLink() {
   return Preprocess || OutputAssembly || OutputObjectFile || EmitTokens ||
          EmitAST || EmitLLVM;
@@ -0,0 +1,142 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+// 字节码解释器的分发方式: switch 与 threaded (goto *)
+// 用法: dispatch switch|threaded [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { kPush, kAdd, kOver, kDup, kSwap, kDec, kJnz, kPop, kHalt };
+
+// 计算 1 + 2 + ... + n, 栈上为 acc n
+static const int kProgram[] = {
+    kPush, 0,        // acc
+    kPush, 1000000,  // acc n
+    kSwap,           // loop: n acc
+    kOver,           // n acc n
+    kAdd,            // n acc+n
+    kSwap,           // acc n
+    kDec,            // acc n-1
+    kDup,            // acc n-1 n-1
+    kJnz,  4,        // acc n-1
+    kPop,            // acc
+    kHalt,
+};
+
+static long run_switch(const int *code) {
+  long stack[16];
+  long *sp = stack;
+  const int *pc = code;
+
+  for (;;) {
+    switch (*pc++) {
+      case kPush:
+        *sp++ = *pc++;
+        break;
+      case kAdd:
+        sp[-2] += sp[-1];
+        --sp;
+        break;
+      case kOver:
+        *sp = sp[-2];
+        ++sp;
+        break;
+      case kDup:
+        *sp = sp[-1];
+        ++sp;
+        break;
+      case kSwap: {
+        long t = sp[-1];
+        sp[-1] = sp[-2];
+        sp[-2] = t;
+      } break;
+      case kDec:
+        --sp[-1];
+        break;
+      case kJnz:
+        if (*--sp) {
+          pc = code + *pc;
+        } else {
+          ++pc;
+        }
+        break;
+      case kPop:
+        --sp;
+        break;
+      case kHalt:
+        return sp[-1];
+      default:
+        abort();
+    }
+  }
+}
+
+static long run_threaded(const int *code) {
+  static void *const dispatch[] = {&&push, &&add, &&over, &&dup, &&swap,
+                                   &&dec,  &&jnz, &&pop,  &&halt};
+  long stack[16];
+  long *sp = stack;
+  const int *pc = code;
+
+#define NEXT goto *dispatch[*pc++]
+  NEXT;
+push:
+  *sp++ = *pc++;
+  NEXT;
+add:
+  sp[-2] += sp[-1];
+  --sp;
+  NEXT;
+over:
+  *sp = sp[-2];
+  ++sp;
+  NEXT;
+dup:
+  *sp = sp[-1];
+  ++sp;
+  NEXT;
+swap: {
+  long t = sp[-1];
+  sp[-1] = sp[-2];
+  sp[-2] = t;
+}
+  NEXT;
+dec:
+  --sp[-1];
+  NEXT;
+jnz:
+  if (*--sp) {
+    pc = code + *pc;
+  } else {
+    ++pc;
+  }
+  NEXT;
+pop:
+  --sp;
+  NEXT;
+halt:
+  return sp[-1];
+#undef NEXT
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s switch|threaded [iterations]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  long (*run)(const int *) =
+      strcmp(argv[1], "threaded") == 0 ? run_threaded : run_switch;
+  int iterations = argc > 2 ? atoi(argv[2]) : 100;
+
+  for (int i = 0; i < iterations; ++i) {
+    if (run(kProgram) != 500000500000) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
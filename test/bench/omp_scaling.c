@@ -0,0 +1,100 @@
+//
+// Created by kaiser on 2026/10/19.
+//
+
+// OpenMP 的扩展性: 用 -fopenmp 编译, 由 OMP_NUM_THREADS 控制线程数
+// 用法: omp_scaling static|dynamic [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { kN = 1 << 20, kRows = 512 };
+
+static double a[kN], b[kN];
+static int mandel[kRows * kRows];
+
+// 每次迭代的工作量相同, 适合 static
+static double dot(void) {
+  double sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+  for (int i = 0; i < kN; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// 每行的工作量不同, 适合 dynamic
+static long mandelbrot(int dynamic) {
+  long total = 0;
+#pragma omp parallel reduction(+ : total)
+  {
+    if (dynamic) {
+#pragma omp for schedule(dynamic, 4) nowait
+      for (int y = 0; y < kRows; ++y) {
+        for (int x = 0; x < kRows; ++x) {
+          double cr = 2.5 * x / kRows - 2.0, ci = 2.5 * y / kRows - 1.25;
+          double zr = 0, zi = 0;
+          int n = 0;
+          while (n < 256 && zr * zr + zi * zi < 4) {
+            double t = zr * zr - zi * zi + cr;
+            zi = 2 * zr * zi + ci;
+            zr = t;
+            ++n;
+          }
+          mandel[y * kRows + x] = n;
+          total += n;
+        }
+      }
+    } else {
+#pragma omp for schedule(static) nowait
+      for (int y = 0; y < kRows; ++y) {
+        for (int x = 0; x < kRows; ++x) {
+          double cr = 2.5 * x / kRows - 2.0, ci = 2.5 * y / kRows - 1.25;
+          double zr = 0, zi = 0;
+          int n = 0;
+          while (n < 256 && zr * zr + zi * zi < 4) {
+            double t = zr * zr - zi * zi + cr;
+            zi = 2 * zr * zi + ci;
+            zr = t;
+            ++n;
+          }
+          mandel[y * kRows + x] = n;
+          total += n;
+        }
+      }
+    }
+  }
+  return total;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s static|dynamic [iterations]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int dynamic = strcmp(argv[1], "dynamic") == 0;
+  int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+#pragma omp parallel for
+  for (int i = 0; i < kN; ++i) {
+    a[i] = 1.0;
+    b[i] = 0.5;
+  }
+
+  long expected = -1;
+  for (int i = 0; i < iterations; ++i) {
+    if (dot() != kN * 0.5) {
+      return EXIT_FAILURE;
+    }
+
+    long total = mandelbrot(dynamic);
+    if (expected != -1 && total != expected) {
+      return EXIT_FAILURE;
+    }
+    expected = total;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+-- Runtime benchmark for lua interpreters built by different compilers.
+-- Exercises the VM dispatch loop, function calls, tables, strings and the
+-- garbage collector.  Usage: lua bench.lua [scale]
+
+local scale = tonumber(arg and arg[1]) or 1
+
+local function fib(n)
+  if n < 2 then return n end
+  return fib(n - 1) + fib(n - 2)
+end
+
+local function sieve(n)
+  local count = 0
+  for _ = 1, 10 * scale do
+    local flags = {}
+    count = 0
+    for i = 2, n do
+      if not flags[i] then
+        count = count + 1
+        for j = i * i, n, i do flags[j] = true end
+      end
+    end
+  end
+  return count
+end
+
+local function sort(n)
+  local t = {}
+  local seed = 42
+  for i = 1, n do
+    seed = (seed * 1103515245 + 12345) % 2147483648
+    t[i] = seed
+  end
+  table.sort(t)
+  return t[1]
+end
+
+local function strings(n)
+  local parts = {}
+  for i = 1, n do
+    parts[#parts + 1] = string.format("%d:%s", i, string.rep("x", i % 16))
+  end
+  local s = table.concat(parts, ",")
+  local count = 0
+  for _ in s:gmatch("%d+:x+") do count = count + 1 end
+  return count
+end
+
+local function closures(n)
+  local sum = 0
+  for i = 1, n do
+    local f = function(x) return x + i end
+    sum = sum + f(i)
+  end
+  return sum
+end
+
+local function mandelbrot(size)
+  local count = 0
+  for y = 0, size - 1 do
+    local ci = 2 * y / size - 1
+    for x = 0, size - 1 do
+      local cr = 2 * x / size - 1.5
+      local zr, zi = 0.0, 0.0
+      local escaped = false
+      for _ = 1, 50 do
+        zr, zi = zr * zr - zi * zi + cr, 2 * zr * zi + ci
+        if zr * zr + zi * zi > 4 then
+          escaped = true
+          break
+        end
+      end
+      if not escaped then count = count + 1 end
+    end
+  end
+  return count
+end
+
+assert(fib(27 + scale) > 0)
+assert(sieve(1000000) == 78498)
+assert(sort(200000 * scale) >= 0)
+assert(strings(200000 * scale) > 0)
+assert(closures(2000000 * scale) > 0)
+assert(mandelbrot(400 * scale) > 0)
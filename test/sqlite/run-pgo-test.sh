@@ -0,0 +1,34 @@
+#!/bin/bash
+#
+# Measure the effect of profile-guided optimization on speedtest1.
+# Typical usage (from this directory):
+#
+#     sh run-pgo-test.sh              # -O3
+#     sh run-pgo-test.sh -O2 -flto=thin
+#
+# speedtest1 is built three times: without a profile, instrumented with
+# -fprofile-generate, and with -fprofile-use.  The instrumented binary is
+# run once to collect the profile, then the plain and the PGO binary are
+# timed on the same workload.
+#
+set -e
+CC_OPTS="-O3 $* -DSQLITE_ENABLE_RTREE -DSQLITE_ENABLE_MEMSYS5"
+SPEEDTEST_OPTS="--shrink-memory --reprepare --heap 10000000 64 --size 5"
+PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+rm -rf pgo-profile speedtest1-base speedtest1-instr speedtest1-pgo
+kcc $CC_OPTS ./speedtest1.c ./sqlite3.c -o speedtest1-base -ldl -lpthread
+kcc $CC_OPTS -fprofile-generate=pgo-profile ./speedtest1.c ./sqlite3.c \
+    -o speedtest1-instr -ldl -lpthread
+./speedtest1-instr $SPEEDTEST_OPTS >/dev/null
+$PROFDATA merge -o pgo-profile/default.profdata pgo-profile/*.profraw
+kcc $CC_OPTS -fprofile-use=pgo-profile ./speedtest1.c ./sqlite3.c \
+    -o speedtest1-pgo -ldl -lpthread
+TIMEFORMAT="%R"
+BASE=$( { time ./speedtest1-base $SPEEDTEST_OPTS >/dev/null; } 2>&1 )
+PGO=$( { time ./speedtest1-pgo $SPEEDTEST_OPTS >/dev/null; } 2>&1 )
+echo "CC_OPTS        = $CC_OPTS"
+echo "SPEEDTEST_OPTS = $SPEEDTEST_OPTS"
+echo "without profile: ${BASE}s"
+echo "with profile:    ${PGO}s"
+awk -v b="$BASE" -v p="$PGO" \
+    'BEGIN { printf "speedup:         %.1f%%\n", (b - p) / b * 100 }'
@@ -0,0 +1,120 @@
+#include "test.h"
+
+int my_abs(int) asm("abs");
+
+static int add_impl(int a, int b) __asm__("kcc_asm_add");
+static int add_impl(int a, int b) { return a + b; }
+
+static int counter asm("kcc_asm_counter") = 3;
+
+// 静态初始化中取地址时使用 asm 标号
+static int (*add_ptr)(int, int) = add_impl;
+
+static void test_label() {
+  expect(5, my_abs(-5));
+  expect(3, add_impl(1, 2));
+  expect(7, add_ptr(3, 4));
+  expect(3, counter);
+  counter++;
+  expect(4, counter);
+}
+
+static void test_operand() {
+  int a = 1, b = 2, c;
+  asm("addl %2, %0" : "=r"(c) : "0"(a), "r"(b));
+  expect(3, c);
+
+  int x = 5;
+  asm("addl $10, %0" : "+r"(x));
+  expect(15, x);
+
+  int y;
+  asm("movl %[in], %[out]\n\t"
+      "shll $1, %[out]"
+      : [out] "=&r"(y)
+      : [in] "r"(x));
+  expect(30, y);
+
+  int z;
+  asm("movl $%c1, %%eax\n\t"
+      "movl %%eax, %0"
+      : "=r"(z)
+      : "i"(7)
+      : "eax");
+  expect(7, z);
+
+  int g;
+  asm("movl %1, %0" : "=r"(g) : "g"(a + 41));
+  expect(42, g);
+
+  char ch = 1;
+  asm("addb %1, %0" : "+q"(ch) : "q"((char)2));
+  expect(3, ch);
+
+  int lo, hi;
+  asm("movl $1, %0\n\t"
+      "movl $2, %1"
+      : "=r"(lo), "=r"(hi));
+  expect(1, lo);
+  expect(2, hi);
+}
+
+static void test_memory() {
+  long m = 1;
+  asm volatile("incq %0" : "+m"(m));
+  expectl(2, m);
+
+  int arr[2] = {1, 2};
+  asm("movl %1, %0" : "=m"(arr[0]) : "r"(arr[1]));
+  expect(2, arr[0]);
+
+  int val = 9, out;
+  asm("movl %1, %0" : "=r"(out) : "m"(val));
+  expect(9, out);
+
+  asm volatile("" ::: "memory");
+  __asm__ __volatile__("nop");
+
+  unsigned eax, edx;
+  asm volatile("rdtsc" : "=a"(eax), "=d"(edx));
+  expect(1, ((unsigned long)edx << 32 | eax) != 0);
+}
+
+static int is_zero(int v) {
+  asm goto("testl %0, %0\n\t"
+           "je %l1"
+           :
+           : "r"(v)
+           : "cc"
+           : zero);
+  return 0;
+zero:
+  return 1;
+}
+
+static int is_negative(int v) {
+  asm goto("testl %0, %0\n\t"
+           "js %l[neg]"
+           :
+           : "r"(v)
+           : "cc"
+           : neg);
+  return 0;
+neg:
+  return 1;
+}
+
+static void test_goto() {
+  expect(1, is_zero(0));
+  expect(0, is_zero(3));
+  expect(1, is_negative(-1));
+  expect(0, is_negative(1));
+}
+
+void testmain() {
+  print("asm");
+  test_label();
+  test_operand();
+  test_memory();
+  test_goto();
+}
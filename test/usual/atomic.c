@@ -0,0 +1,130 @@
+#include <stdatomic.h>
+
+#include "test.h"
+
+static void test_qualifier() {
+  _Atomic int a = 1;
+  expect(1, a);
+  a = 2;
+  expect(2, a);
+  a++;
+  expect(3, a);
+  --a;
+  expect(2, a);
+  a += 5;
+  expect(7, a);
+  a |= 8;
+  expect(15, a);
+
+  _Atomic(long) b = 10;
+  expectl(10, b);
+  b -= 3;
+  expectl(7, b);
+
+  // 其他复合赋值通过 cmpxchg 循环完成
+  a *= 3;
+  expect(45, a);
+  a <<= 2;
+  expect(180, a);
+  a >>= 1;
+  expect(90, a);
+  a /= 4;
+  expect(22, a);
+  a %= 5;
+  expect(2, a);
+
+  _Atomic char c = 100;
+  c *= 2;
+  expect(-56, c);
+
+  _Atomic double d = 1.5;
+  d += 2;
+  expect(1, d == 3.5);
+  d *= 2;
+  expect(1, d == 7.0);
+
+  int arr[3] = {1, 2, 3};
+  int *_Atomic p = arr;
+  p++;
+  expect(2, *p);
+  p += 1;
+  expect(3, *p);
+
+  // ++ 总是得到 1, -- 将值取反
+  _Atomic _Bool flag = 0;
+  expect(0, flag++);
+  expect(1, flag);
+  expect(1, ++flag);
+  expect(1, flag--);
+  expect(0, flag);
+  expect(1, --flag);
+}
+
+static void test_auto_type() {
+  int count = 0;
+  // 初始化表达式只解析和求值一次
+  __auto_type x = ({
+    int y = ++count;
+    y * 2;
+  });
+  expect(2, x);
+  expect(1, count);
+  expect(4, sizeof(x));
+}
+
+static void test_builtin() {
+  int a = 5;
+  expect(5, __atomic_load_n(&a, __ATOMIC_SEQ_CST));
+  __atomic_store_n(&a, 6, __ATOMIC_RELEASE);
+  expect(6, a);
+  expect(6, __atomic_exchange_n(&a, 7, __ATOMIC_SEQ_CST));
+  expect(7, __atomic_fetch_add(&a, 3, __ATOMIC_RELAXED));
+  expect(8, __atomic_sub_fetch(&a, 2, __ATOMIC_SEQ_CST));
+  expect(8, __atomic_fetch_and(&a, 12, __ATOMIC_SEQ_CST));
+
+  int expected = 1;
+  expect(0, __atomic_compare_exchange_n(&a, &expected, 2, 0, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST));
+  expect(8, expected);
+  expect(1, __atomic_compare_exchange_n(&a, &expected, 2, 0, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST));
+  expect(2, a);
+
+  expect(2, __sync_fetch_and_add(&a, 1));
+  expect(1, __sync_bool_compare_and_swap(&a, 3, 4));
+  expect(4, __sync_val_compare_and_swap(&a, 0, 5));
+  expect(4, a);
+
+  volatile int v = 1;
+  __atomic_store_n(&v, 2, __ATOMIC_SEQ_CST);
+  expect(2, __atomic_load_n(&v, __ATOMIC_SEQ_CST));
+}
+
+static void test_stdatomic() {
+  atomic_int a = ATOMIC_VAR_INIT(3);
+  expect(3, atomic_load(&a));
+  atomic_store(&a, 4);
+  expect(4, atomic_fetch_add(&a, 1));
+  expect(5, atomic_load_explicit(&a, memory_order_acquire));
+
+  int expected = 5;
+  expect(1, atomic_compare_exchange_strong(&a, &expected, 6));
+  expect(6, a);
+
+  atomic_flag flag = ATOMIC_FLAG_INIT;
+  expect(0, atomic_flag_test_and_set(&flag));
+  expect(1, atomic_flag_test_and_set(&flag));
+  atomic_flag_clear(&flag);
+  expect(0, atomic_flag_test_and_set(&flag));
+
+  atomic_thread_fence(memory_order_seq_cst);
+  expect(1, atomic_is_lock_free(&a));
+}
+
+void testmain() {
+  print("atomic");
+  test_qualifier();
+  test_auto_type();
+  test_builtin();
+  test_stdatomic();
+}
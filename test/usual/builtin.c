@@ -0,0 +1,85 @@
+#include "test.h"
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+static void test_expect() {
+  int a = 3;
+  if (likely(a == 3)) {
+    expect(3, a);
+  } else {
+    fail("likely");
+  }
+  if (unlikely(a != 3)) {
+    fail("unlikely");
+  }
+  expectl(5, __builtin_expect(5, 0));
+  if (__builtin_expect_with_probability(a, 3, 0.9) == 3) {
+    expect(3, a);
+  }
+}
+
+static int f(int a) {
+  if (a > 0) {
+    return a;
+  }
+  __builtin_unreachable();
+}
+
+static void test_misc() {
+  int arr[4] = {1, 2, 3, 4};
+  __builtin_prefetch(arr);
+  __builtin_prefetch(arr, 1, 0);
+  expect(2, f(2));
+
+  int *p = __builtin_assume_aligned(arr, 4);
+  expect(1, *p);
+
+  expect(1, __builtin_constant_p(10 + 2));
+  expect(0, __builtin_constant_p(arr[0]));
+  static int constant = __builtin_constant_p(1);
+  expect(1, constant);
+}
+
+static void test_mem() {
+  char buf[8];
+  char *s = "abcdefg";
+  expect(1, __builtin_memcpy(buf, s, 8) == buf);
+  expect_string("abcdefg", buf);
+  __builtin_memmove(buf + 1, buf, 3);
+  expect_string("aabcefg", buf);
+  __builtin_memset(buf, 'x', 2);
+  expect_string("xxbcefg", buf);
+}
+
+static void test_overflow() {
+  int i;
+  expect(0, __builtin_add_overflow(1, 2, &i));
+  expect(3, i);
+  expect(1, __builtin_add_overflow(2147483647, 1, &i));
+  expect(-2147483648, i);
+  expect(1, __builtin_mul_overflow(65536, 65536, &i));
+  expect(0, i);
+
+  unsigned u;
+  expect(1, __builtin_sub_overflow(0, 1, &u));
+  expect(0, __builtin_sub_overflow(5u, 3, &u));
+  expect(2, u);
+
+  long l;
+  expect(0, __builtin_mul_overflow(65536, 65536, &l));
+  expectl(4294967296, l);
+
+  char c;
+  expect(1, __builtin_add_overflow(127, 1, &c));
+  expect(0, __builtin_add_overflow(-100, -28, &c));
+  expect(-128, c);
+}
+
+void testmain() {
+  print("builtin");
+  test_expect();
+  test_misc();
+  test_mem();
+  test_overflow();
+}
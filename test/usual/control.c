@@ -320,6 +320,51 @@ static void test_label() {
   expect(8, z);
 }
 
+static int run_threaded(const unsigned char *code) {
+  static void *dispatch[] = {&&op_inc, &&op_dec, &&op_double, &&op_halt};
+  int acc = 0;
+
+  goto *dispatch[*code++];
+op_inc:
+  acc++;
+  goto *dispatch[*code++];
+op_dec:
+  acc--;
+  goto *dispatch[*code++];
+op_double:
+  acc *= 2;
+  goto *dispatch[*code++];
+op_halt:
+  return acc;
+}
+
+static void test_computed_goto() {
+  unsigned char code[] = {0, 0, 2, 1, 2, 3};
+  expect(6, run_threaded(code));
+  unsigned char code2[] = {0, 2, 2, 2, 1, 3};
+  expect(7, run_threaded(code2));
+
+  int n = 0;
+  void *p = &&l1;
+  goto *p;
+  n = 100;
+l1:
+  expect(0, n);
+
+  void *local[] = {&&l2, &&l3};
+  int i = 0;
+again:
+  goto *local[i];
+l2:
+  n += 1;
+  i = 1;
+  goto again;
+l3:
+  n += 10;
+  expect(11, n);
+  expect(1, &&l2 != &&l3);
+}
+
 static void test_logor() {
   expect(1, 0 || 3);
   expect(1, 5 || 0);
@@ -336,4 +381,5 @@ void testmain() {
   test_goto();
   test_label();
   test_logor();
+  test_computed_goto();
 }
@@ -1,5 +1,6 @@
 // Copyright 2012 Rui Ueyama. Released under the MIT license.
 
+#include <setjmp.h>
 #include <stdbool.h>
 #include "test.h"
 
@@ -194,6 +195,59 @@ static void test_func_ret_struct() {
   expect(10, c);
 }
 
+#ifdef __KCC__
+#define MUSTTAIL __attribute__((musttail))
+#else
+#define MUSTTAIL
+#endif
+
+// 互相尾递归, -O0 下也不会栈溢出
+static long is_odd(long n, long acc);
+
+static long is_even(long n, long acc) {
+  if (n == 0) {
+    return acc;
+  }
+  MUSTTAIL return is_odd(n - 1, acc + 1);
+}
+
+static long is_odd(long n, long acc) {
+  if (n == 0) {
+    return -acc;
+  }
+  MUSTTAIL return is_even(n - 1, acc + 1);
+}
+
+static int tail_count;
+
+static void count_down(int n) {
+  if (n == 0) {
+    return;
+  }
+  ++tail_count;
+  MUSTTAIL return count_down(n - 1);
+}
+
+static jmp_buf tail_env;
+
+static int jump_back(int v) { longjmp(tail_env, v); }
+
+// 调用了 setjmp, return jump_back(...) 不能标记为 tail
+static int with_setjmp(int v) {
+  if (setjmp(tail_env)) {
+    return 7;
+  }
+  return jump_back(v);
+}
+
+static void test_musttail() {
+  expectl(1000000, is_even(1000000, 0));
+  expectl(-999999, is_even(999999, 0));
+  count_down(1000000);
+  expect(1000000, tail_count);
+  expect(7, with_setjmp(1));
+}
+
 void testmain() {
   print("function");
 
@@ -222,4 +276,5 @@ void testmain() {
   test_return_struct();
   test_func_param();
   test_func_ret_struct();
+  test_musttail();
 }
@@ -329,6 +329,141 @@ static void test_struct_anonymous_complex() {
   expect(3, foo1.h.g);
 }
 
+static int side_effect;
+static int next() { return ++side_effect; }
+
+static void test_constant_pool() {
+  int table[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  expect(1, table[0]);
+  expect(16, table[15]);
+  table[0] = 100;
+  int table2[16] = {1, 2, 3};
+  expect(1, table2[0]);
+  expect(0, table2[15]);
+
+  int x = 42;
+  int mixed[8] = {1, 2, x, 4, [6] = next(), 7};
+  expect(2, mixed[1]);
+  expect(42, mixed[2]);
+  expect(4, mixed[3]);
+  expect(0, mixed[5]);
+  expect(side_effect, mixed[6]);
+  expect(7, mixed[7]);
+
+  int zero[8] = {0, 0, x};
+  expect(0, zero[0]);
+  expect(42, zero[2]);
+  expect(0, zero[7]);
+
+  int full[4] = {x, x + 1, x + 2, x + 3};
+  expect(45, full[3]);
+
+  int before = side_effect;
+  int calls[2] = {({ next(); 1; }) + 0, x};
+  expect(before + 1, side_effect);
+  expect(1, calls[0]);
+  expect(42, calls[1]);
+
+  int div[2] = {x > 0 ? 2 : 1 / 0, x};
+  expect(2, div[0]);
+
+  int dup[4] = {[1] = 1, [1] = x, [2] = 3};
+  expect(42, dup[1]);
+  expect(3, dup[2]);
+
+  struct {
+    int a;
+    double d;
+    char *s;
+    long arr[3];
+  } s = {1, 2.5, "abc", {[2] = 9}};
+  expect(1, s.a);
+  expect(1, s.d == 2.5);
+  expect_string("abc", s.s);
+  expectl(0, s.arr[1]);
+  expectl(9, s.arr[2]);
+
+  char buf[64] = "hello";
+  expect_string("hello", buf);
+  expect(0, buf[5]);
+  expect(0, buf[63]);
+
+  for (int i = 0; i < 2; ++i) {
+    int again[4] = {1, 2, 3, 4};
+    expect(1, again[0]);
+    again[0] = 5;
+  }
+}
+
+static unsigned char data_u8[] = {0x7f, 0x45, 0b101, 017, 255u, -1, +2, 300};
+static short data_i16[8] = {-32768, 0xffff, 10L};
+static long data_i64[] = {-2147483647, 0x7fffffffffffffff, 1ull};
+static float data_f32[] = {1.5f, -2.25, 3, 0x1p3, 1e-3};
+static double data_f64[4] = {0.1, -1e300, 1.5L, -7};
+static int data_mixed[] = {1, 2, 1 + 2, [5] = 6};
+
+#ifdef __KCC__
+static const unsigned char embed[] = __builtin_embed("embed.txt");
+#endif
+
+static void test_data_array() {
+  expect(8, sizeof(data_u8));
+  expect(0x7f, data_u8[0]);
+  expect('E', data_u8[1]);
+  expect(5, data_u8[2]);
+  expect(15, data_u8[3]);
+  expect(255, data_u8[4]);
+  expect(255, data_u8[5]);
+  expect(2, data_u8[6]);
+  expect(44, data_u8[7]);
+
+  expect(-32768, data_i16[0]);
+  expect(-1, data_i16[1]);
+  expect(10, data_i16[2]);
+  expect(0, data_i16[7]);
+
+  expect(3, sizeof(data_i64) / sizeof(long));
+  expectl(-2147483647, data_i64[0]);
+  expectl(0x7fffffffffffffff, data_i64[1]);
+  expectl(1, data_i64[2]);
+
+  expect(1, data_f32[0] == 1.5f);
+  expect(1, data_f32[1] == -2.25f);
+  expect(1, data_f32[2] == 3.0f);
+  expect(1, data_f32[3] == 8.0f);
+  expect(1, data_f32[4] == (float)1e-3);
+
+  expect(1, data_f64[0] == 0.1);
+  expect(1, data_f64[1] == -1e300);
+  expect(1, data_f64[2] == 1.5);
+  expect(1, data_f64[3] == -7.0);
+
+  expect(6, sizeof(data_mixed) / sizeof(int));
+  expect(3, data_mixed[2]);
+  expect(6, data_mixed[5]);
+
+  unsigned char local[6] = {1, 0x80, -3};
+  expect(1, local[0]);
+  expect(0x80, local[1]);
+  expect(253, local[2]);
+  expect(0, local[5]);
+
+  double local_f64[] = {0.5, -0.25};
+  expect(2, sizeof(local_f64) / sizeof(double));
+  expect(1, local_f64[1] == -0.25);
+
+#ifdef __KCC__
+  expect(10, sizeof(embed));
+  expect('k', embed[0]);
+  expect('\n', embed[9]);
+
+  char buf[16] = __builtin_embed("embed.txt");
+  expect('e', buf[4]);
+  expect(0, buf[10]);
+  expect(0, buf[15]);
+#endif
+}
+
 void testmain() {
   print("initializer");
 
@@ -349,4 +484,6 @@ void testmain() {
   test_struct_anonymous_complex();
   test_literal();
   test_dup();
+  test_constant_pool();
+  test_data_array();
 }
@@ -0,0 +1,148 @@
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "test.h"
+
+typedef unsigned __int128 u128;
+
+static u128 mul_64x64(unsigned long a, unsigned long b) { return (u128)a * b; }
+
+static void test_arith() {
+  expect(16, sizeof(__int128));
+  expect(16, sizeof(unsigned __int128));
+  expect(16, _Alignof(__int128));
+  expect(16, sizeof(__uint128_t));
+
+  u128 r = mul_64x64(0xffffffffffffffffUL, 0xffffffffffffffffUL);
+  expectl(0xfffffffffffffffe, (unsigned long)(r >> 64));
+  expectl(1, (unsigned long)r);
+
+  __int128 a = -1;
+  expect(1, a < 0);
+  expectl(-1, (long)(a >> 100));
+  expectl(-3, (long)(a * 3));
+
+  u128 b = (u128)1 << 100;
+  expectl(1L << 36, (long)(b >> 64));
+  expectl(3, (long)((b * 3) >> 100));
+  expectl(7, (long)((b * 7) / b));
+
+  // 有符号 __int128 可以表示所有 unsigned long 的值
+  expect(1, -1 < (__int128)0xffffffffffffffffUL);
+  expect(1, sizeof(1L + (__int128)1) == 16);
+  expect(1, sizeof(1UL + (unsigned __int128)1) == 16);
+
+  expect(1, (double)((u128)1 << 64) == 18446744073709551616.0);
+}
+
+typedef struct {
+  char c;
+  __int128 i;
+  char d;
+} S;
+
+static void test_struct() {
+  expect(16, offsetof(S, i));
+  expect(48, sizeof(S));
+
+  S s = {1, (__int128)-2, 3};
+  expect(1, s.c);
+  expectl(-2, (long)s.i);
+  expect(3, s.d);
+}
+
+typedef struct {
+  char c;
+  struct {
+    __int128 i;
+  };
+  char d;
+} AnonS;
+
+typedef union {
+  char c;
+  _Alignas(16) char buf[20];
+} U;
+
+static void test_padding() {
+  expect(16, offsetof(AnonS, i));
+  expect(48, sizeof(AnonS));
+
+  AnonS s = {1, {(__int128)-2}, 3};
+  expect(1, s.c);
+  expectl(-2, (long)s.i);
+  expect(3, s.d);
+
+  expect(32, sizeof(U));
+  U u[2] = {{1}, {2}};
+  expect(2, u[1].c);
+  expect(32, (char *)&u[1] - (char *)&u[0]);
+}
+
+static __int128 sum(int n, ...) {
+  va_list ap;
+  va_start(ap, n);
+  __int128 total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += va_arg(ap, __int128);
+  }
+  va_end(ap);
+  return total;
+}
+
+static void test_varargs() {
+  __int128 big = (__int128)1 << 80;
+  expectl(1L << 17, (long)(sum(3, big, big, (__int128)0) >> 64));
+  // 超出寄存器的参数在栈上传递
+  expectl(8, (long)sum(8, (__int128)1, (__int128)1, (__int128)1, (__int128)1,
+                       (__int128)1, (__int128)1, (__int128)1, (__int128)1));
+}
+
+static void test_builtin() {
+#ifdef __KCC__
+  expect(0x34, __builtin_rotateleft8(0x43, 4));
+  expect(0x1, __builtin_rotateleft16(0x8000, 1));
+  expect(0x80000000, __builtin_rotateright32(1, 1));
+  expectl(0x8000000000000000, __builtin_rotateleft64(1, 63));
+#endif
+
+  expect(0, __builtin_ffs(0));
+  expect(1, __builtin_ffs(1));
+  expect(5, __builtin_ffs(0x10));
+  expect(33, __builtin_ffsl(1L << 32));
+  expect(64, __builtin_ffsll(1LL << 63));
+
+  expect(0, __builtin_parity(0));
+  expect(1, __builtin_parity(7));
+  expect(0, __builtin_parityl(3UL << 40));
+  expect(1, __builtin_parityll(1ULL << 63));
+
+  unsigned long hi;
+  expect(1, __builtin_mul_overflow(1UL << 32, 1UL << 32, &hi));
+  u128 product;
+  expect(0, __builtin_mul_overflow(1UL << 32, 1UL << 32, &product));
+  expectl(1, (unsigned long)(product >> 64));
+
+  __int128 max = (__int128)(~(u128)0 >> 1);
+  __int128 min = -max - 1;
+  __int128 sp;
+  expect(0, __builtin_mul_overflow((__int128)-3, (__int128)5, &sp));
+  expectl(-15, (long)sp);
+  expect(1, __builtin_mul_overflow(max, (__int128)2, &sp));
+  expect(0, __builtin_mul_overflow(min, (__int128)1, &sp));
+  expect(1, sp == min);
+  expect(1, __builtin_mul_overflow(min, (__int128)-1, &sp));
+  expect(0, __builtin_mul_overflow((__int128)1 << 63, -((__int128)1 << 64), &sp));
+  expect(1, sp == min);
+  expect(1, __builtin_mul_overflow((__int128)1 << 64, (__int128)1 << 63, &sp));
+}
+
+void testmain() {
+  print("__int128");
+
+  test_arith();
+  test_struct();
+  test_padding();
+  test_varargs();
+  test_builtin();
+}
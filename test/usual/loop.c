@@ -25,9 +25,53 @@ void test3() {
   expect(sum, 45);
 }
 
+void test_pragma() {
+  int arr[100];
+
+#pragma unroll 4
+  for (int i = 0; i < 100; ++i) arr[i] = i;
+
+  int sum = 0;
+#pragma GCC unroll 2
+  for (int i = 0; i < 100; ++i) sum += arr[i];
+  expect(4950, sum);
+
+  sum = 0;
+#pragma unroll(0x8)
+  for (int i = 0; i < 100; ++i) sum += arr[i];
+  expect(4950, sum);
+
+#pragma GCC ivdep
+  for (int i = 1; i < 100; ++i) arr[i] += arr[0];
+  expect(99, arr[99]);
+
+  int i = 0;
+  sum = 0;
+#pragma clang loop vectorize(enable) interleave_count(2)
+  while (i < 100) sum += arr[i++];
+  expect(4950, sum);
+
+  i = 0;
+#pragma nounroll
+#pragma clang loop vectorize(disable)
+  do {
+    --arr[i];
+  } while (++i < 100);
+  expect(-1, arr[0]);
+  expect(98, arr[99]);
+
+#pragma unroll
+  for (int j = 0; j < 4; ++j) {
+#pragma clang loop unroll(disable) vectorize(assume_safety)
+    for (int k = 0; k < 4; ++k) arr[j * 4 + k] = j;
+  }
+  expect(3, arr[15]);
+}
+
 void testmain() {
   print("loop");
   test1();
   test2();
   test3();
+  test_pragma();
 }
@@ -0,0 +1,155 @@
+#include "test.h"
+
+// 没有 -fopenmp 时忽略 OpenMP 指令, 串行执行的结果相同
+#ifdef _OPENMP
+int omp_get_thread_num(void);
+int omp_get_num_threads(void);
+#else
+static int omp_get_thread_num(void) { return 0; }
+static int omp_get_num_threads(void) { return 1; }
+#endif
+
+static void test_parallel() {
+  int count = 0;
+  int threads = 0;
+#pragma omp parallel num_threads(4)
+  {
+#pragma omp critical
+    ++count;
+
+    if (omp_get_thread_num() == 0) {
+      threads = omp_get_num_threads();
+    }
+  }
+  expect(threads, count);
+
+  // 区域中声明的变量和 private 变量属于各个线程
+  int id = -1;
+  int sum = 0;
+#pragma omp parallel num_threads(4) private(id) reduction(+ : sum)
+  {
+    id = omp_get_thread_num();
+    int local = id + 1;
+    sum += local;
+  }
+  expect(threads * (threads + 1) / 2, sum);
+}
+
+static void test_for() {
+  int arr[1000];
+
+#pragma omp parallel for
+  for (int i = 0; i < 1000; ++i) {
+    arr[i] = i;
+  }
+
+  long sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(dynamic, 7)
+  for (int i = 0; i < 1000; i++) {
+    sum += arr[i];
+  }
+  expectl(499500, sum);
+
+  // <= / 递减 / 步长不为 1
+  sum = 0;
+#pragma omp parallel for reduction(+ : sum)
+  for (int i = 999; i >= 0; i -= 3) {
+    sum += arr[i];
+  }
+  expectl(166833, sum);
+
+  int i;
+  sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static, 10)
+  for (i = 1; i <= 100; ++i) {
+    sum += i;
+  }
+  expectl(5050, sum);
+
+  int max = 0, min = 1000, all = 1;
+  double prod = 1.0;
+#pragma omp parallel for reduction(max : max) reduction(min : min) \
+    reduction(&& : all) reduction(* : prod)
+  for (int j = 1; j < 1000; ++j) {
+    max = max > arr[j] ? max : arr[j];
+    min = min < arr[j] ? min : arr[j];
+    all = all && arr[j];
+    prod *= j < 10 ? 2.0 : 1.0;
+  }
+  expect(999, max);
+  expect(1, min);
+  expect(1, all);
+  expect(512, (int)prod);
+
+  // 无符号循环变量的区间跨过 LONG_MAX
+  unsigned long base = 0x7ffffffffffffe00UL;
+  sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(dynamic, 16)
+  for (unsigned long u = base; u < base + 1000; ++u) {
+    sum += (long)(u - base);
+  }
+  expectl(499500, sum);
+
+  sum = 0;
+#pragma omp parallel for reduction(+ : sum)
+  for (unsigned long u = base + 999; u >= base; u -= 3) {
+    sum += arr[u - base];
+  }
+  expectl(166833, sum);
+}
+
+static void test_worksharing() {
+  int arr[100];
+  long sum = 0;
+  int count = 0;
+
+  // 区域中的工作共享循环和 barrier
+#pragma omp parallel
+  {
+#pragma omp for
+    for (int i = 0; i < 100; ++i) {
+      arr[i] = 2 * i;
+    }
+
+#pragma omp barrier
+
+#pragma omp for reduction(+ : sum) nowait
+    for (int i = 0; i < 100; ++i) {
+      sum += arr[99 - i];
+    }
+
+#pragma omp critical(update)
+    ++count;
+  }
+  expectl(9900, sum);
+  expect(1, count > 0);
+}
+
+static void test_simd() {
+  float a[256], b[256];
+  for (int i = 0; i < 256; ++i) {
+    b[i] = i;
+  }
+
+#pragma omp simd
+  for (int i = 0; i < 256; ++i) {
+    a[i] = b[i] * 2;
+  }
+  expect(510, (int)a[255]);
+
+  float total = 0;
+#pragma omp parallel for simd reduction(+ : total)
+  for (int i = 0; i < 256; ++i) {
+    total += a[i];
+  }
+  expect(65280, (int)total);
+}
+
+void testmain() {
+  print("openmp");
+
+  test_parallel();
+  test_for();
+  test_worksharing();
+  test_simd();
+}
@@ -333,6 +333,63 @@ static void flexible_member() {
   };
 }
 
+struct big {
+  long a[8];
+  char c;
+  union {
+    double d;
+    int i;
+  } u;
+};
+
+static struct big make_big(int base) {
+  struct big b = {{base, base + 1, base + 2, base + 3, base + 4, base + 5,
+                   base + 6, base + 7},
+                  'x',
+                  {.i = base}};
+  struct big copy = b;
+  return copy;
+}
+
+static void big_copy() {
+  struct big a = make_big(10);
+  expectl(10, a.a[0]);
+  expectl(17, a.a[7]);
+  expect('x', a.c);
+  expect(10, a.u.i);
+
+  struct big b;
+  b = a;
+  expectl(17, b.a[7]);
+
+  struct big arr[2];
+  struct big *p = arr;
+  arr[1] = b;
+  expectl(14, arr[1].a[4]);
+  *p = arr[1];
+  expectl(15, p->a[5]);
+
+  struct {
+    int x;
+    struct big b;
+  } outer = {1, a};
+  expect(1, outer.x);
+  expectl(12, outer.b.a[2]);
+
+  struct big c, d;
+  c = d = outer.b;
+  expectl(11, c.a[1]);
+  expectl(11, d.a[1]);
+
+  volatile struct big v = a;
+  b = v;
+  expectl(13, b.a[3]);
+
+  b = (struct big){{1, 2}};
+  expectl(2, b.a[1]);
+  expectl(0, b.a[2]);
+}
+
 static void empty_struct() {
   struct tag15 {};
   expect(0, sizeof(struct tag15));
@@ -689,6 +746,7 @@ void testmain() {
   test_unnamed_bitfield();
   flexible_member();
   empty_struct();
+  big_copy();
 
   test1();
   test2();
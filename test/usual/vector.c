@@ -0,0 +1,235 @@
+#include "test.h"
+
+typedef int v4si __attribute__((vector_size(16)));
+typedef unsigned v4su __attribute__((__vector_size__(16)));
+typedef float v4sf __attribute__((vector_size(16)));
+typedef char v8qi __attribute__((vector_size(8)));
+typedef long v2di __attribute__((vector_size(16)));
+
+static v4si g = {1, 2, 3, 4};
+static v4sf gf = {0.5f, 1.5f};
+
+struct S {
+  int a;
+  v4si v;
+};
+
+static v4si add(v4si a, v4si b) { return a + b; }
+
+static int calls;
+static v4si next(void) {
+  ++calls;
+  return (v4si){calls, calls * 2, calls * 3, calls * 4};
+}
+
+static void test_basic() {
+  expect(16, sizeof(v4si));
+  expect(16, _Alignof(v4si));
+  expect(8, sizeof(v8qi));
+  expect(32, sizeof(int __attribute__((vector_size(32)))));
+
+  v4si a = {1, 2, 3, 4};
+  expect(1, a[0]);
+  expect(4, a[3]);
+
+  v4si b = {5, 6};
+  expect(6, b[1]);
+  expect(0, b[2]);
+
+  v4si c = a;
+  c[2] = 10;
+  expect(10, c[2]);
+  expect(3, a[2]);
+
+  expect(1, g[0]);
+  expect(4, g[3]);
+  expect(1, (int)(gf[1] * 2) == 3);
+  expect(0, (int)gf[3]);
+
+  v4si d = (v4si){7, 8, 9, 10};
+  expect(9, d[2]);
+
+  struct S s = {1, {2, 3, 4, 5}};
+  expect(5, s.v[3]);
+}
+
+static void test_arith() {
+  v4si a = {1, 2, 3, 4};
+  v4si b = {10, 20, 30, 40};
+
+  v4si c = a + b;
+  expect(11, c[0]);
+  expect(44, c[3]);
+
+  c = b - a;
+  expect(9, c[0]);
+  c = a * b;
+  expect(40, c[1]);
+  c = b / a;
+  expect(10, c[2]);
+  c = b % (v4si){3, 3, 3, 3};
+  expect(1, c[0]);
+  expect(2, c[1]);
+
+  c = a + 1;
+  expect(2, c[0]);
+  expect(5, c[3]);
+  c = 2 * a;
+  expect(8, c[3]);
+  c += a;
+  expect(12, c[3]);
+
+  c = -a;
+  expect(-1, c[0]);
+  c = ~a;
+  expect(-2, c[0]);
+
+  c = a << 2;
+  expect(16, c[3]);
+  c = b >> (v4si){1, 2, 3, 4};
+  expect(5, c[0]);
+  expect(2, c[3]);
+  c = a & 1;
+  expect(0, c[1]);
+  c = a | 8;
+  expect(9, c[0]);
+  c = a ^ a;
+  expect(0, c[2]);
+
+  expect(23, (a + b)[2] - 10);
+  expect(33, add(a, b)[2]);
+
+  v4sf f = {1.5f, 2.5f, 3.5f, 4.5f};
+  v4sf h = f * 2;
+  expect(3, (int)h[0]);
+  expect(9, (int)h[3]);
+
+  v4su u = {1, 2, 3, 4};
+  v4su w = u - 2;
+  expect(1, w[0] > 100);
+
+  v8qi q = {1, 2, 3, 4, 5, 6, 7, 8};
+  q = q + q;
+  expect(16, q[7]);
+
+  v2di l = {1L << 40, 2};
+  l = l * 2;
+  expectl(1L << 41, l[0]);
+}
+
+static void test_compare() {
+  v4si a = {1, 5, 3, 7};
+  v4si b = {2, 5, 1, 8};
+
+  v4si c = a < b;
+  expect(-1, c[0]);
+  expect(0, c[1]);
+  expect(0, c[2]);
+  expect(-1, c[3]);
+
+  c = a == b;
+  expect(0, c[0]);
+  expect(-1, c[1]);
+
+  c = a >= 3;
+  expect(0, c[0]);
+  expect(-1, c[2]);
+
+  v4sf f = {1.0f, 2.0f, 3.0f, 4.0f};
+  v4si m = f > 2.5f;
+  expect(0, m[1]);
+  expect(-1, m[2]);
+
+  v4su u = {1, 0xffffffff, 3, 4};
+  c = u > 2;
+  expect(-1, c[1]);
+}
+
+static void test_shuffle() {
+  v4si a = {1, 2, 3, 4};
+  v4si b = {5, 6, 7, 8};
+
+  v4si c = __builtin_shufflevector(a, b, 0, 4, 1, 5);
+  expect(1, c[0]);
+  expect(5, c[1]);
+  expect(2, c[2]);
+  expect(6, c[3]);
+
+  c = __builtin_shufflevector(a, a, 3, 2, 1, 0);
+  expect(4, c[0]);
+  expect(1, c[3]);
+
+  typedef int v2si __attribute__((vector_size(8)));
+  v2si d = __builtin_shufflevector(a, b, 1, 7);
+  expect(2, d[0]);
+  expect(8, d[1]);
+
+  v4si mask = {3, 0, 2, 1};
+  c = __builtin_shuffle(a, mask);
+  expect(4, c[0]);
+  expect(1, c[1]);
+  expect(3, c[2]);
+  expect(2, c[3]);
+
+  mask = (v4si){0, 4, 7, 9};
+  c = __builtin_shuffle(a, b, mask);
+  expect(1, c[0]);
+  expect(5, c[1]);
+  expect(8, c[2]);
+  expect(2, c[3]);
+
+  c = __builtin_shuffle(a, (v4si){1, 1, 1, 1});
+  expect(2, c[0]);
+  expect(2, c[3]);
+}
+
+static void test_cast() {
+  v4sf f = {1.0f, 2.0f, 3.0f, 4.0f};
+  v4si i = (v4si)f;
+  expect(0x3f800000, i[0]);
+
+  v8qi q = {1, 0, 0, 0, 2, 0, 0, 0};
+  typedef int v2si __attribute__((vector_size(8)));
+  v2si s = (v2si)q;
+  expect(1, s[0]);
+  expect(2, s[1]);
+}
+
+static void test_rvalue_index() {
+  calls = 0;
+  int n = 0;
+  while (next()[0] < 4) {
+    ++n;
+  }
+  expect(3, n);
+  expect(4, calls);
+
+  calls = 0;
+  for (int i = 0; i < 3 && next()[3] > 0; ++i) {
+  }
+  expect(3, calls);
+
+  calls = 0;
+  int zero = 0;
+  expect(0, zero && next()[1]);
+  expect(0, calls);
+  expect(1, 1 || next()[1]);
+  expect(0, calls);
+  expect(1, !zero && next()[1] == 2);
+  expect(1, calls);
+
+  v4si a = {1, 2, 3, 4};
+  for (int i = 0; i < 4; ++i) {
+    expect(i + 11, (a + 10)[i]);
+  }
+}
+
+void testmain() {
+  print("vector");
+  test_basic();
+  test_arith();
+  test_compare();
+  test_shuffle();
+  test_cast();
+  test_rvalue_index();
+}
@@ -0,0 +1,104 @@
+#include "test.h"
+
+static int sum(int n, int a[n]) {
+  int s = 0;
+  for (int i = 0; i < n; ++i) {
+    s += a[i];
+  }
+  return s;
+}
+
+static void fill(int n, int a[*]);
+
+static void fill(int n, int a[n]) {
+  for (int i = 0; i < n; ++i) {
+    a[i] = i + 1;
+  }
+}
+
+static void test_basic() {
+  int n = 5;
+  int a[n];
+  expectl(20, sizeof(a));
+  expectl(5, sizeof(a) / sizeof(a[0]));
+
+  fill(n, a);
+  expect(1, a[0]);
+  expect(5, a[4]);
+  expect(15, sum(n, a));
+
+  // sizeof 使用声明时的长度
+  n = 10;
+  expectl(20, sizeof a);
+  expectl(40, sizeof(int[n]));
+
+  char s[n + 1];
+  expectl(11, sizeof(s));
+  for (int i = 0; i < n; ++i) {
+    s[i] = 'a' + i;
+  }
+  s[n] = '\0';
+  expect_string("abcdefghij", s);
+}
+
+static void test_multi() {
+  int n = 3;
+  int a[n][4];
+  expectl(48, sizeof(a));
+  expectl(16, sizeof(a[0]));
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      a[i][j] = i * 4 + j;
+    }
+  }
+  expect(0, a[0][0]);
+  expect(6, a[1][2]);
+  expect(11, a[2][3]);
+}
+
+static void test_loop() {
+  int total = 0;
+  for (int i = 1; i <= 1000; ++i) {
+    long a[i];
+    a[i - 1] = i;
+    if (i % 2) {
+      continue;
+    }
+    total += a[i - 1];
+    if (i == 100) {
+      break;
+    }
+  }
+  expect(2550, total);
+
+  int i = 0;
+  while (1) {
+    int a[++i];
+    a[0] = i;
+    switch (a[0]) {
+    case 3:
+      continue;
+    case 5:
+      break;
+    }
+    if (i == 8) {
+      break;
+    }
+  }
+  expect(8, i);
+
+  i = ({
+    int b[4 + i];
+    b[0] = 7;
+    b[0] + (int)sizeof(b);
+  });
+  expect(55, i);
+}
+
+void testmain() {
+  print("vla");
+  test_basic();
+  test_multi();
+  test_loop();
+}
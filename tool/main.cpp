@@ -19,10 +19,12 @@
 #include "code_gen.h"
 #include "cpp.h"
 #include "error.h"
+#include "jit.h"
 #include "json_gen.h"
 #include "lex.h"
 #include "link.h"
 #include "llvm_common.h"
+#include "mem_report.h"
 #include "obj_gen.h"
 #include "opt.h"
 #include "parse.h"
@@ -38,11 +40,12 @@ void RunDev();
 #endif
 
 int main(int argc, char *argv[]) try {
-  InitLLVM();
-
   InitCommandLine(argc, argv);
   CommandLineCheck();
 
+  // 依赖 -march 等命令行选项
+  InitLLVM();
+
 #ifdef DEV
   if (DevMode) {
     RunDev();
@@ -50,13 +53,22 @@ int main(int argc, char *argv[]) try {
   }
 #endif
 
+  // --run 时不 fork, 在本进程中编译并执行, 不生成目标文件也不链接
+  if (JitRun) {
+    TimeTraceStart();
+    RunKcc(InputFilePaths.front());
+  }
+
   TimingStart();
   for (const auto &item : InputFilePaths) {
     auto pid{fork()};
     if (pid < 0) {
       Error("fork error");
     } else if (pid == 0) {
+      TimeTraceStart();
       RunKcc(item);
+      TimeTraceEnd(GetAuxFileName(item, ".json"));
+      MemReportPrint(GetAuxFileName(item, ".mem.json"));
       PrintWarnings();
       return EXIT_SUCCESS;
     }
@@ -82,7 +94,12 @@ int main(int argc, char *argv[]) try {
     OutputFilePath = "a.out";
   }
 
-  if (!Link()) {
+  // 链接在父进程中进行, 单独输出一个文件, e.g. a.out -> a.link.json
+  TimeTraceStart();
+  auto link_success{Link()};
+  TimeTraceEnd(GetFileName(OutputFilePath, ".link.json"));
+
+  if (!link_success) {
     RemoveFiles();
     Error("Link Failed");
   } else {
@@ -100,6 +117,9 @@ void RunKcc(const std::string &file_name) {
   preprocessor.AddMacroDefinitions(MacroDefines);
 
   auto preprocessed_code{preprocessor.Cpp(file_name)};
+  MemReportPhase("Preprocess");
+  MemReportBuffer("Preprocessed code", std::size(preprocessed_code),
+                  preprocessed_code.capacity());
 
   if (Preprocess) {
     if (std::empty(OutputFilePath)) {
@@ -113,6 +133,9 @@ void RunKcc(const std::string &file_name) {
 
   Scanner scanner{std::move(preprocessed_code)};
   auto tokens{scanner.Tokenize()};
+  MemReportPhase("Tokenize");
+  MemReportBuffer("Tokens", std::size(tokens),
+                  tokens.capacity() * sizeof(Token));
 
   if (EmitTokens) {
     if (std::empty(OutputFilePath)) {
@@ -136,6 +159,7 @@ void RunKcc(const std::string &file_name) {
 
   Parser parser{std::move(tokens)};
   auto unit{parser.ParseTranslationUnit()};
+  MemReportPhase("Parse");
 
   if (EmitAST) {
     JsonGen json_gen{file_name};
@@ -147,9 +171,13 @@ void RunKcc(const std::string &file_name) {
     return;
   }
 
+  InitOptimizationRemarks(file_name);
+
   CodeGen code_gen;
   code_gen.GenCode(unit);
+  MemReportPhase("CodeGen");
   Optimization();
+  MemReportPhase("Optimization");
 
   if (EmitLLVM) {
     std::error_code error_code;
@@ -173,16 +201,28 @@ void RunKcc(const std::string &file_name) {
     return;
   }
 
+  if (JitRun) {
+    RunJit(file_name);
+  }
+
+  // -flto 时目标文件中保存的是 LLVM bitcode, 由链接器进行优化和代码生成
+  auto obj_gen{[](const std::string &obj_file) {
+    if (FLto == LTOKind::kNone) {
+      ObjGen(obj_file);
+    } else {
+      BitcodeGen(obj_file);
+    }
+  }};
   if (OutputObjectFile) {
     if (std::empty(OutputFilePath)) {
-      ObjGen(GetFileName(file_name, ".o"));
+      obj_gen(GetFileName(file_name, ".o"));
     } else {
-      ObjGen(OutputFilePath);
+      obj_gen(OutputFilePath);
     }
-    return;
+  } else {
+    obj_gen(GetObjFile(file_name));
   }
-
-  ObjGen(GetObjFile(file_name));
+  MemReportPhase("ObjGen");
 }
 
 #ifdef DEV